@@ -0,0 +1,9 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+// Stand-in for the Plugin SDK header, inc/IPluginOSC.h only needs the name.
+namespace PluginManager
+{
+    struct IPluginBase;
+}
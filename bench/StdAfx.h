@@ -0,0 +1,148 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+// Stand-in for src/StdAfx.h so the engine independent plugin sources
+// (transports, connections etc.) can be built and benchmarked without CryEngine.
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <list>
+#include <string>
+#include <limits>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+typedef int64_t int64;
+typedef uint64_t uint64;
+typedef int32_t int32;
+typedef uint32_t uint32;
+
+// CryThread.h
+class CryMutex
+{
+        std::recursive_mutex m_Mutex;
+
+    public:
+        void Lock()
+        {
+            m_Mutex.lock();
+        }
+
+        void Unlock()
+        {
+            m_Mutex.unlock();
+        }
+};
+
+template<class T>
+class CryAutoLock
+{
+        T& m_Lock;
+
+    public:
+        CryAutoLock( T& lock ) : m_Lock( lock )
+        {
+            m_Lock.Lock();
+        }
+
+        ~CryAutoLock()
+        {
+            m_Lock.Unlock();
+        }
+};
+
+class CryEvent
+{
+        std::mutex m_Mutex;
+        std::condition_variable m_Cond;
+        bool m_bSet;
+
+    public:
+        CryEvent() : m_bSet( false ) {}
+
+        void Set()
+        {
+            std::lock_guard<std::mutex> lock( m_Mutex );
+            m_bSet = true;
+            m_Cond.notify_all();
+        }
+
+        void Reset()
+        {
+            std::lock_guard<std::mutex> lock( m_Mutex );
+            m_bSet = false;
+        }
+
+        bool Wait( uint32 nTimeoutMs )
+        {
+            std::unique_lock<std::mutex> lock( m_Mutex );
+            return m_Cond.wait_for( lock, std::chrono::milliseconds( nTimeoutMs ), [this] { return m_bSet; } );
+        }
+};
+
+template<class TRunnable = int>
+class CrySimpleThread
+{
+        std::thread m_Thread;
+
+    public:
+        virtual ~CrySimpleThread()
+        {
+            if ( m_Thread.joinable() )
+            {
+                m_Thread.join();
+            }
+        }
+
+        virtual void Run() = 0;
+        virtual void Cancel() = 0;
+
+        void Start( unsigned /* nCpuMask */ = 0, const char* /* sName */ = NULL )
+        {
+            m_Thread = std::thread( [this] { Run(); } );
+        }
+
+        void WaitForThread()
+        {
+            if ( m_Thread.joinable() )
+            {
+                m_Thread.join();
+            }
+        }
+};
+
+typedef unsigned long threadID;
+
+inline threadID CryGetCurrentThreadId()
+{
+    return threadID( std::hash<std::thread::id>()( std::this_thread::get_id() ) );
+}
+
+inline void CrySleep( unsigned int nMs )
+{
+    if ( nMs )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( nMs ) );
+    }
+
+    else
+    {
+        std::this_thread::yield();
+    }
+}
+
+// IConsole.h
+struct IConsoleCmdArgs
+{
+    virtual ~IConsoleCmdArgs() {}
+    virtual int GetArgCount() const = 0;
+    virtual const char* GetArg( int nIndex ) const = 0;
+};
@@ -0,0 +1,1191 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+/**
+   Frame rate throughput and latency of the connection core (src/OSCConnection.cpp)
+   driven by the mock flow system in bench/osc_mock_flow.h, no CryEngine required.
+
+   Every frame the sender writes the frame number and n float values into its packet
+   slots and the receiver gets them through the receive value sinks:
+   - loopback: client and server connection in one process (in-process handover)
+   - udp, tcp: a raw transport sends the encoded packet to a server connection
+   - replay: captures the udp run (src/OSCCapture.h) and plays it back as fast as possible and at the original pacing
+   - rebind: re-initializes a graph with a fresh connection and in place (BeginRegistration), which keeps the socket
+     open and the ids, and hot rebinds to another port, then checks the values still arrive at the nodes registered before
+   - coalesce: a client connection with several packets changing every frame sends to a plain socket,
+     one datagram per packet and coalesced into bundles (COSCConnection::SetCoalesceSize)
+   - suppress: the same packets are requested every frame but only change every 10th,
+     sent as they are and with repeats suppressed (COSCConnection::SetSuppressRepeats)
+   - timetag: a bundle sent with immediate, frame start and monotonic timetags plus a lookahead,
+     how far ahead of its arrival the timetag of each bundle is (COSCConnection::SetTimeTags)
+   - jitter: a ramp sent at 30 Hz with up to 10 ms of send jitter, read by a render loop at 250 Hz through a plain
+     receive message and one with a jitter buffer (COSCConnection::SetJitterBuffer), how evenly the values advance
+   - diag: every message arrives with the wrong type, log lines written with every occurrence logged and
+     with repeats summarized (COSCDiagnostics, osc_log_interval), no occurrence may go uncounted
+   - fanout: a udp server with many peers that subscribed by sending to it, every frame's packet is encoded once
+     and sent to all of them (COSCConnection::SetFanOut), then a request answered to its sender only, idle peers dropped
+     and a full peer table (osc_max_peers) making room for a new one
+
+   build with cmake (CMakeLists.txt) or (Linux):
+
+   g++ -O2 -std=c++11 -Ibench -I. -Isrc -Iinc bench/osc_core_bench.cc src/OSCConnection.cpp src/OSCCapture.cpp src/OSCTransport.cpp src/OSCTcpTransport.cpp src/OSCShmTransport.cpp src/OSCByteSwap.cpp src/OSCCoalescer.cpp src/OSCDiagnostics.cpp src/OSCJitterBuffer.cpp src/OSCPeerTable.cpp src/OSCSendScheduler.cpp src/OSCTrace.cpp -o osc_core_bench -lpthread -lrt
+
+   usage: osc_core_bench [--frames n] [--values n] [loopback|udp|tcp|replay|rebind|coalesce|suppress|timetag|jitter|diag|fanout ...]
+
+   returns nonzero if less than 99% of the frames arrived
+ */
+
+#include <osc_mock_flow.h>
+#include <OSCLatencyHistogram.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <thread>
+
+using namespace OSCMock;
+
+namespace
+{
+    const int BENCH_PORT = 9320;
+    const int WAIT_FRAMES = 100000; //!< frames a socket scenario polls for a packet before counting it lost
+    const char* CAPTURE_FILE = "osc_core_bench.osccap";
+    const int REBIND_MESSAGES = 32; //!< receive messages of the graph re-initialized by the rebind scenario
+    const int REBIND_ROUNDS = 20;
+    const int COALESCE_PACKETS = 8; //!< packets of the client in the coalesce scenario, all change every frame
+    const int SUPPRESS_CHANGE = 10; //!< frames between changes in the suppress scenario
+    const float TIMETAG_LATENCY = 0.005f; //!< lookahead of the timetag scenario
+    const double JITTER_RATE = 30; //!< messages per second of the jitter scenario
+    const double JITTER_SEND = 0.010; //!< most a message is sent late, seconds
+    const double JITTER_FRAME = 0.004; //!< render frame time
+    const double JITTER_WARMUP = 0.3; //!< seconds before the speeds are measured
+    const double JITTER_DURATION = 1.5;
+    const float DIAG_INTERVAL = 0.02f; //!< osc_log_interval of the diag scenario
+    const int FANOUT_PEERS = 200; //!< controllers of the fanout scenario
+    const float FANOUT_TIMEOUT = 0.05f; //!< peer timeout of the fanout scenario
+
+    typedef std::chrono::steady_clock Clock;
+
+    double Seconds( Clock::duration d )
+    {
+        return std::chrono::duration<double>( d ).count();
+    }
+
+    struct SScenario
+    {
+        const char* sName;
+        EOSCConnectionType eServer;
+        eOSCTransportType eTransport; //!< of the raw sender, unused for loopback
+    };
+
+    /**
+    * @brief Receiver side of the mock graph, one node per value
+    */
+    struct SReceiver
+    {
+        CMockReceiveNode* pFrame;
+        std::vector<CMockReceiveNode*> values;
+
+        void Init( CMockFlowGraph& graph, int nConnection, int nValues )
+        {
+            int nMessage = graph.AddReceiveMessage( nConnection, "/bench/frame" );
+            pFrame = graph.AddReceiveValue( nConnection, nMessage, OSCT_Int32 );
+
+            for ( int i = 0; i < nValues; ++i )
+            {
+                values.push_back( graph.AddReceiveValue( nConnection, nMessage, OSCT_Float32 ) );
+            }
+        }
+
+        int GetReceivedValues() const
+        {
+            int nCount = 0;
+
+            for ( size_t i = 0; i < values.size(); ++i )
+            {
+                nCount += values[i]->GetPort().nActivations;
+            }
+
+            return nCount;
+        }
+    };
+
+    /**
+    * @brief Sender side, the packet either belongs to a client connection or is encoded by hand
+    */
+    struct SSender
+    {
+        int nFrameSlot;
+        std::vector<int> slots;
+
+        void Init( COSCPacket& packet, int nValues )
+        {
+            int nMessage = packet.AddMessage( "/bench/frame" );
+            nFrameSlot = packet.AddValue( nMessage, OSCT_Int32 );
+
+            for ( int i = 0; i < nValues; ++i )
+            {
+                slots.push_back( packet.AddValue( nMessage, OSCT_Float32 ) );
+            }
+        }
+
+        void Write( COSCPacket& packet, int nFrame )
+        {
+            packet.SetValue( nFrameSlot, nFrame );
+
+            for ( size_t i = 0; i < slots.size(); ++i )
+            {
+                packet.SetValue( slots[i], float( nFrame ) + float( i ) * 0.5f );
+            }
+
+            packet.NotifyChange();
+        }
+    };
+
+    bool Report( const SScenario& scenario, int nFrames, const SReceiver& receiver, COSCLatencyHistogram& latency, Clock::duration elapsed )
+    {
+        int nReceived = receiver.pFrame->GetPort().nActivations;
+        double fSeconds = Seconds( elapsed );
+
+        printf( "%-8s %6d frames %4zu values: %10.0f updates/s %12.0f values/s latency p50 %7.2f us p99 %7.2f us (lost %d)\n",
+                scenario.sName, nFrames, receiver.values.size(),
+                nReceived / fSeconds, receiver.GetReceivedValues() / fSeconds,
+                latency.GetPercentile( 50 ) / 1000.0, latency.GetPercentile( 99 ) / 1000.0,
+                nFrames - nReceived );
+
+        bool bOk = nReceived >= nFrames - nFrames / 100 && receiver.GetReceivedValues() == nReceived * int( receiver.values.size() );
+
+        if ( !bOk )
+        {
+            fprintf( stderr, "%s: values did not arrive\n", scenario.sName );
+        }
+
+        return bOk;
+    }
+
+    bool RunLoopback( const SScenario& scenario, int nFrames, int nValues )
+    {
+        CMockFlowGraph graph;
+        int nServer = graph.AddConnection( "127.0.0.1", BENCH_PORT, OSCCT_UdpServer );
+        int nClient = graph.AddConnection( "127.0.0.1", BENCH_PORT, OSCCT_UdpClient );
+
+        if ( !OSCIsConnectionOk( nServer ) || !OSCIsConnectionOk( nClient ) )
+        {
+            fprintf( stderr, "%s: open %d failed\n", scenario.sName, BENCH_PORT );
+            return false;
+        }
+
+        SReceiver receiver;
+        receiver.Init( graph, nServer, nValues );
+
+        int nPacket = graph.AddPacket( nClient );
+        SSender sender;
+        sender.Init( graph.GetPacket( nClient, nPacket ), nValues );
+
+        COSCLatencyHistogram latency;
+        Clock::time_point start = Clock::now();
+
+        for ( int nFrame = 1; nFrame <= nFrames; ++nFrame )
+        {
+            uint64 nSent = GetOSCWallClockNs();
+            sender.Write( graph.GetPacket( nClient, nPacket ), nFrame );
+            graph.Update();
+
+            const SMockPortValue& frame = receiver.pFrame->GetPort();
+
+            if ( frame.nValue == nFrame )
+            {
+                latency.Record( frame.nTime - nSent );
+            }
+        }
+
+        return Report( scenario, nFrames, receiver, latency, Clock::now() - start );
+    }
+
+    bool RunSocket( const SScenario& scenario, int nFrames, int nValues, const char* sCapture = NULL )
+    {
+        CMockFlowGraph graph;
+        int nServer = graph.AddConnection( "127.0.0.1", BENCH_PORT, scenario.eServer );
+
+        if ( sCapture && !OSCCapture( BENCH_PORT, sCapture ) )
+        {
+            return false;
+        }
+
+        IOSCTransport* pTransport = CreateOSCTransport( scenario.eTransport, OSCSF_Slip );
+
+        if ( !OSCIsConnectionOk( nServer ) || !pTransport->Open( "127.0.0.1", BENCH_PORT, false ) )
+        {
+            fprintf( stderr, "%s: open %d failed: %s\n", scenario.sName, BENCH_PORT, pTransport->GetErrorMessage().c_str() );
+            pTransport->Release();
+            return false;
+        }
+
+        SReceiver receiver;
+        receiver.Init( graph, nServer, nValues );
+
+        COSCPacket packet;
+        SSender sender;
+        sender.Init( packet, nValues );
+        oscpkt::PacketWriter pw;
+
+        COSCLatencyHistogram latency;
+        Clock::time_point start = Clock::now();
+
+        for ( int nFrame = 1; nFrame <= nFrames; ++nFrame )
+        {
+            uint64 nSent = GetOSCWallClockNs();
+            sender.Write( packet, nFrame );
+
+            if ( packet.Encode( pw ) )
+            {
+                pTransport->SendPacket( pw.packetData(), pw.packetSize() );
+                pTransport->Flush();
+            }
+
+            const SMockPortValue& frame = receiver.pFrame->GetPort();
+
+            for ( int i = 0; i < WAIT_FRAMES && frame.nValue != nFrame; ++i )
+            {
+                graph.Update();
+            }
+
+            if ( frame.nValue == nFrame )
+            {
+                latency.Record( frame.nTime - nSent );
+            }
+        }
+
+        Clock::duration elapsed = Clock::now() - start;
+        pTransport->Release();
+        return Report( scenario, nFrames, receiver, latency, elapsed );
+    }
+
+    bool RunReplay( const SScenario& scenario, int nFrames, int nValues )
+    {
+        const SScenario capture = { "capture", OSCCT_UdpServer, OSCTT_Udp };
+        Clock::time_point captureStart = Clock::now();
+
+        if ( !RunSocket( capture, nFrames, nValues, CAPTURE_FILE ) )
+        {
+            return false;
+        }
+
+        double fCaptured = Seconds( Clock::now() - captureStart );
+        static const float speeds[] = { 0, 1 };
+        bool bOk = true;
+
+        for ( size_t s = 0; s < sizeof( speeds ) / sizeof( speeds[0] ); ++s )
+        {
+            CMockFlowGraph graph;
+            int nServer = graph.AddConnection( "127.0.0.1", BENCH_PORT, OSCCT_UdpServer );
+
+            SReceiver receiver;
+            receiver.Init( graph, nServer, nValues );
+
+            if ( !OSCReplay( BENCH_PORT, CAPTURE_FILE, speeds[s] ) )
+            {
+                return false;
+            }
+
+            // the capture was taken at full speed, so even the paced replay can't take much longer
+            Clock::time_point start = Clock::now();
+            Clock::duration timeout = std::chrono::seconds( 10 ) + std::chrono::duration_cast<Clock::duration>( std::chrono::duration<double>( 2 * fCaptured ) );
+
+            while ( receiver.pFrame->GetPort().nValue != nFrames && Clock::now() - start < timeout )
+            {
+                graph.Update();
+            }
+
+            double fSeconds = Seconds( Clock::now() - start );
+            int nReceived = receiver.pFrame->GetPort().nActivations;
+
+            printf( "%-8s %6d frames %4zu values: speed %g %10.0f updates/s %12.0f values/s in %.3f s (captured in %.3f s, lost %d)\n",
+                    scenario.sName, nFrames, receiver.values.size(), speeds[s],
+                    nReceived / fSeconds, receiver.GetReceivedValues() / fSeconds, fSeconds, fCaptured,
+                    nFrames - nReceived );
+
+            if ( receiver.GetReceivedValues() != nReceived * nValues || nReceived < nFrames - nFrames / 100 )
+            {
+                fprintf( stderr, "%s: values did not arrive\n", scenario.sName );
+                bOk = false;
+            }
+        }
+
+        remove( CAPTURE_FILE );
+        return bOk;
+    }
+
+    /**
+    * @brief What the Init chain of a graph with nMessages receive messages registers
+    */
+    void RegisterMessages( CMockFlowGraph& graph, int nConnection, int nMessages, int nValues, std::vector<int>& ids, std::vector<CMockReceiveNode*>& nodes )
+    {
+        ids.clear();
+        nodes.clear();
+
+        for ( int m = 0; m < nMessages; ++m )
+        {
+            char sAddress[32];
+            snprintf( sAddress, sizeof( sAddress ), "/bench/rebind/%d", m );
+            ids.push_back( graph.AddReceiveMessage( nConnection, sAddress ) );
+
+            for ( int v = 0; v < nValues; ++v )
+            {
+                nodes.push_back( graph.AddReceiveValue( nConnection, ids.back(), OSCT_Float32 ) );
+            }
+        }
+    }
+
+    /**
+    * @return messages whose first node got the value
+    */
+    int SendMessages( CMockFlowGraph& graph, IOSCTransport* pTransport, int nMessages, int nValues, const std::vector<CMockReceiveNode*>& nodes )
+    {
+        COSCPacket packet;
+        std::vector<int> slots;
+        packet.AddBundleStart();
+
+        for ( int m = 0; m < nMessages; ++m )
+        {
+            char sAddress[32];
+            snprintf( sAddress, sizeof( sAddress ), "/bench/rebind/%d", m );
+            int nMessage = packet.AddMessage( sAddress );
+
+            for ( int v = 0; v < nValues; ++v )
+            {
+                slots.push_back( packet.AddValue( nMessage, OSCT_Float32 ) );
+            }
+        }
+
+        packet.AddBundleEnd();
+
+        for ( size_t i = 0; i < slots.size(); ++i )
+        {
+            packet.SetValue( slots[i], float( i ) );
+        }
+
+        packet.NotifyChange();
+        oscpkt::PacketWriter pw;
+
+        if ( !packet.Encode( pw ) || !pTransport->SendPacket( pw.packetData(), pw.packetSize() ) )
+        {
+            return 0;
+        }
+
+        int nArrived = 0;
+
+        for ( int i = 0; i < WAIT_FRAMES && nArrived < nMessages; ++i )
+        {
+            graph.Update();
+            nArrived = 0;
+
+            for ( int m = 0; m < nMessages; ++m )
+            {
+                nArrived += nodes[m * nValues]->GetPort().nActivations > 0;
+            }
+        }
+
+        return nArrived;
+    }
+
+    bool RunRebind( const SScenario& scenario, int nValues )
+    {
+        CMockFlowGraph graph;
+        int nServer = graph.AddConnection( "127.0.0.1", BENCH_PORT, OSCCT_UdpServer );
+        std::vector<int> ids, firstIds;
+        std::vector<CMockReceiveNode*> nodes;
+        RegisterMessages( graph, nServer, REBIND_MESSAGES, nValues, firstIds, nodes );
+        graph.Update();
+
+        // what Init did before: a new connection, everything registered from scratch
+        Clock::time_point start = Clock::now();
+
+        for ( int i = 0; i < REBIND_ROUNDS; ++i )
+        {
+            ReleaseOSCConnection( nServer );
+            nServer = graph.AddConnection( "127.0.0.1", BENCH_PORT, OSCCT_UdpServer );
+            RegisterMessages( graph, nServer, REBIND_MESSAGES, nValues, ids, nodes );
+            graph.Update();
+        }
+
+        double fFresh = Seconds( Clock::now() - start ) / REBIND_ROUNDS;
+
+        // Init of the only user: the entries are reused in registration order
+        start = Clock::now();
+
+        for ( int i = 0; i < REBIND_ROUNDS; ++i )
+        {
+            graph.Reinit( nServer, "127.0.0.1", BENCH_PORT, OSCCT_UdpServer );
+            RegisterMessages( graph, nServer, REBIND_MESSAGES, nValues, ids, nodes );
+            graph.Update();
+        }
+
+        double fInPlace = Seconds( Clock::now() - start ) / REBIND_ROUNDS;
+        std::vector<int> inPlaceIds = ids;
+        bool bOk = GetConnection( nServer ).GetReceiveMessageCount() == size_t( REBIND_MESSAGES );
+
+        // port change without Init, nothing registers again
+        start = Clock::now();
+
+        for ( int i = 0; i < REBIND_ROUNDS; ++i )
+        {
+            bOk &= graph.Rebind( nServer, "127.0.0.1", BENCH_PORT + 1 + ( i & 1 ), OSCCT_UdpServer );
+        }
+
+        double fRebind = Seconds( Clock::now() - start ) / REBIND_ROUNDS;
+        graph.Update();
+
+        IOSCTransport* pTransport = CreateOSCTransport( scenario.eTransport, OSCSF_Slip );
+        int nArrived = 0;
+
+        // the last rebind went to BENCH_PORT + 2
+        if ( pTransport->Open( "127.0.0.1", BENCH_PORT + 2, false ) )
+        {
+            nArrived = SendMessages( graph, pTransport, REBIND_MESSAGES, nValues, nodes );
+        }
+
+        pTransport->Release();
+
+        printf( "%-8s %6d messages %4d values: re-init fresh %8.1f us in place %8.1f us, rebind %8.1f us (%d of %d messages arrived after the rebind)\n",
+                scenario.sName, REBIND_MESSAGES, nValues, fFresh * 1e6, fInPlace * 1e6, fRebind * 1e6, nArrived, REBIND_MESSAGES );
+
+        if ( !bOk || inPlaceIds != firstIds || nArrived != REBIND_MESSAGES )
+        {
+            fprintf( stderr, "%s: ids changed or values did not arrive after the rebind\n", scenario.sName );
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+    * @return messages received, waits until at least nExpected arrived
+    */
+    uint64 Drain( IOSCTransport* pReceiver, uint64 nExpected, uint64& nDatagrams )
+    {
+        oscpkt::PacketReader pr;
+        uint64 nMessages = 0;
+
+        for ( int i = 0; i < WAIT_FRAMES && nMessages < nExpected; ++i )
+        {
+            while ( pReceiver->ReceiveNextPacket() )
+            {
+                ++nDatagrams;
+                pr.init( pReceiver->GetPacketData(), pReceiver->GetPacketSize() );
+
+                while ( pr.isOk() && pr.popMessage() )
+                {
+                    ++nMessages;
+                }
+            }
+        }
+
+        return nMessages;
+    }
+
+    bool RunCoalesce( const SScenario& scenario, int nFrames, int nValues )
+    {
+        // the receiver is no pooled connection, otherwise the packets would be handed over in process
+        IOSCTransport* pReceiver = CreateOSCTransport( scenario.eTransport, OSCSF_Slip );
+
+        if ( !pReceiver->Open( "127.0.0.1", BENCH_PORT, true ) )
+        {
+            fprintf( stderr, "%s: open %d failed: %s\n", scenario.sName, BENCH_PORT, pReceiver->GetErrorMessage().c_str() );
+            pReceiver->Release();
+            return false;
+        }
+
+        static const size_t sizes[] = { 0, OSC_COALESCE_UDP_SIZE };
+        bool bOk = true;
+
+        for ( size_t s = 0; s < sizeof( sizes ) / sizeof( sizes[0] ); ++s )
+        {
+            CMockFlowGraph graph;
+            int nClient = graph.AddConnection( "127.0.0.1", BENCH_PORT, OSCCT_UdpClient );
+            GetConnection( nClient ).SetCoalesceSize( sizes[s] );
+
+            std::vector<int> packets;
+            std::vector<SSender> senders( COALESCE_PACKETS );
+
+            for ( int p = 0; p < COALESCE_PACKETS; ++p )
+            {
+                packets.push_back( graph.AddPacket( nClient ) );
+                senders[p].Init( graph.GetPacket( nClient, packets[p] ), nValues );
+            }
+
+            uint64 nDatagrams = 0;
+            uint64 nMessages = 0;
+            uint64 nExpected = 0;
+            Clock::time_point start = Clock::now();
+
+            for ( int nFrame = 1; nFrame <= nFrames; ++nFrame )
+            {
+                for ( int p = 0; p < COALESCE_PACKETS; ++p )
+                {
+                    senders[p].Write( graph.GetPacket( nClient, packets[p] ), nFrame );
+                }
+
+                graph.Update();
+                nExpected += COALESCE_PACKETS;
+                nMessages += Drain( pReceiver, COALESCE_PACKETS, nDatagrams );
+            }
+
+            double fSeconds = Seconds( Clock::now() - start );
+            SOSCStats stats;
+            OSCGetStats( nClient, stats );
+
+            printf( "%-8s %6d frames %4d packets: coalesce %4zu bytes %10.0f packets/s %8.2f datagrams/frame %8.1f bytes/datagram (%llu coalesced, lost %llu)\n",
+                    scenario.sName, nFrames, COALESCE_PACKETS, sizes[s], nMessages / fSeconds, double( nDatagrams ) / nFrames,
+                    nDatagrams ? double( stats.nBytesOut ) / nDatagrams : 0.0, ( unsigned long long )stats.nCoalesced,
+                    ( unsigned long long )( nExpected - nMessages ) );
+
+            // a few lost datagrams are tolerated like in the other socket scenarios
+            if ( nMessages < nExpected - nExpected / 100 || ( sizes[s] && nDatagrams > uint64( nFrames ) * 2 ) )
+            {
+                fprintf( stderr, "%s: packets did not arrive or were not coalesced\n", scenario.sName );
+                bOk = false;
+            }
+        }
+
+        pReceiver->Release();
+        return bOk;
+    }
+
+    bool RunSuppress( const SScenario& scenario, int nFrames, int nValues )
+    {
+        IOSCTransport* pReceiver = CreateOSCTransport( scenario.eTransport, OSCSF_Slip );
+
+        if ( !pReceiver->Open( "127.0.0.1", BENCH_PORT, true ) )
+        {
+            fprintf( stderr, "%s: open %d failed: %s\n", scenario.sName, BENCH_PORT, pReceiver->GetErrorMessage().c_str() );
+            pReceiver->Release();
+            return false;
+        }
+
+        bool bOk = true;
+
+        for ( int nSuppress = 0; nSuppress < 2; ++nSuppress )
+        {
+            CMockFlowGraph graph;
+            int nClient = graph.AddConnection( "127.0.0.1", BENCH_PORT, OSCCT_UdpClient );
+            GetConnection( nClient ).SetSuppressRepeats( nSuppress != 0, 0 );
+
+            std::vector<int> packets;
+            std::vector<SSender> senders( COALESCE_PACKETS );
+
+            for ( int p = 0; p < COALESCE_PACKETS; ++p )
+            {
+                packets.push_back( graph.AddPacket( nClient ) );
+                senders[p].Init( graph.GetPacket( nClient, packets[p] ), nValues );
+            }
+
+            uint64 nDatagrams = 0;
+            uint64 nMessages = 0;
+            uint64 nExpected = 0;
+            Clock::time_point start = Clock::now();
+
+            for ( int nFrame = 0; nFrame < nFrames; ++nFrame )
+            {
+                bool bChanged = nFrame % SUPPRESS_CHANGE == 0;
+
+                for ( int p = 0; p < COALESCE_PACKETS; ++p )
+                {
+                    COSCPacket& packet = graph.GetPacket( nClient, packets[p] );
+
+                    if ( bChanged )
+                    {
+                        senders[p].Write( packet, nFrame / SUPPRESS_CHANGE );
+                    }
+
+                    else
+                    {
+                        // graph logic that sends every frame no matter what
+                        packet.RequestSend();
+                    }
+                }
+
+                graph.Update();
+                uint64 nFrameExpected = bChanged || !nSuppress ? COALESCE_PACKETS : 0;
+                nExpected += nFrameExpected;
+                nMessages += Drain( pReceiver, nFrameExpected, nDatagrams );
+            }
+
+            double fSeconds = Seconds( Clock::now() - start );
+            SOSCStats stats;
+            OSCGetStats( nClient, stats );
+
+            printf( "%-8s %6d frames %4d packets: suppress %d %10.0f frames/s %8.2f datagrams/frame %10llu bytes out (%llu suppressed, lost %llu)\n",
+                    scenario.sName, nFrames, COALESCE_PACKETS, nSuppress, nFrames / fSeconds, double( nDatagrams ) / nFrames,
+                    ( unsigned long long )stats.nBytesOut, ( unsigned long long )stats.nSuppressed, ( unsigned long long )( nExpected - std::min( nMessages, nExpected ) ) );
+
+            uint64 nRepeats = uint64( nFrames - ( nFrames + SUPPRESS_CHANGE - 1 ) / SUPPRESS_CHANGE ) * COALESCE_PACKETS;
+
+            if ( nMessages < nExpected - nExpected / 100 || nMessages > nExpected || stats.nSuppressed != ( nSuppress ? nRepeats : 0 ) )
+            {
+                fprintf( stderr, "%s: repeats were not suppressed or changes did not arrive\n", scenario.sName );
+                bOk = false;
+            }
+        }
+
+        pReceiver->Release();
+        return bOk;
+    }
+
+    bool RunTimeTag( const SScenario& scenario, int nFrames, int nValues )
+    {
+        IOSCTransport* pReceiver = CreateOSCTransport( scenario.eTransport, OSCSF_Slip );
+
+        if ( !pReceiver->Open( "127.0.0.1", BENCH_PORT, true ) )
+        {
+            fprintf( stderr, "%s: open %d failed: %s\n", scenario.sName, BENCH_PORT, pReceiver->GetErrorMessage().c_str() );
+            pReceiver->Release();
+            return false;
+        }
+
+        static const char* sClocks[] = { "immediate", "frame", "monotonic" };
+        bool bOk = true;
+
+        for ( int nClock = OSCTC_Immediate; nClock <= OSCTC_Monotonic; ++nClock )
+        {
+            CMockFlowGraph graph;
+            int nClient = graph.AddConnection( "127.0.0.1", BENCH_PORT, OSCCT_UdpClient );
+            GetConnection( nClient ).SetTimeTags( eOSCTimeTagClock( nClock ), TIMETAG_LATENCY );
+
+            int nPacket = graph.AddPacket( nClient );
+            COSCPacket& packet = graph.GetPacket( nClient, nPacket );
+            SSender sender;
+            packet.AddBundleStart();
+            sender.Init( packet, nValues );
+            packet.AddBundleEnd();
+
+            COSCLatencyHistogram lead; //!< timetag - arrival
+            int nReceived = 0;
+            int nImmediate = 0;
+            int nLate = 0;
+            oscpkt::PacketReader pr;
+
+            for ( int nFrame = 1; nFrame <= nFrames; ++nFrame )
+            {
+                sender.Write( graph.GetPacket( nClient, nPacket ), nFrame );
+                graph.Update();
+
+                for ( int i = 0; i < WAIT_FRAMES && !pReceiver->ReceiveNextPacket(); ++i )
+                {
+                }
+
+                pr.init( pReceiver->GetPacketData(), pReceiver->GetPacketSize() );
+                oscpkt::Message* pMessage = pr.popMessage();
+
+                if ( !pMessage )
+                {
+                    continue;
+                }
+
+                ++nReceived;
+                uint64 nArrival = pReceiver->GetPacketTimestamp();
+
+                if ( pMessage->timeTag() == oscpkt::TimeTag::immediate() )
+                {
+                    ++nImmediate;
+                }
+
+                else if ( OSCTimeTagToUnixNs( pMessage->timeTag() ) >= nArrival )
+                {
+                    lead.Record( OSCTimeTagToUnixNs( pMessage->timeTag() ) - nArrival );
+                }
+
+                else
+                {
+                    ++nLate;
+                }
+            }
+
+            printf( "%-8s %6d frames %-9s latency %.1f ms: timetag ahead of arrival p50 %7.1f us p1 %7.1f us (immediate %d, late %d, lost %d)\n",
+                    scenario.sName, nFrames, sClocks[nClock], TIMETAG_LATENCY * 1000.0f,
+                    lead.GetPercentile( 50 ) / 1000.0, lead.GetPercentile( 1 ) / 1000.0, nImmediate, nLate, nFrames - nReceived );
+
+            // the lookahead covers the trip through loopback, a few late ones are scheduling noise
+            bool bTagged = nClock == OSCTC_Immediate ? nImmediate == nReceived : nImmediate == 0 && nLate <= nReceived / 100
+                           && lead.GetPercentile( 50 ) <= uint64( TIMETAG_LATENCY * 1e9 );
+
+            if ( !bTagged || nReceived < nFrames - nFrames / 100 )
+            {
+                fprintf( stderr, "%s: %s timetags are wrong\n", scenario.sName, sClocks[nClock] );
+                bOk = false;
+            }
+        }
+
+        pReceiver->Release();
+        return bOk;
+    }
+
+    bool RunJitter( const SScenario& scenario )
+    {
+        CMockFlowGraph graph;
+        int nServer = graph.AddConnection( "127.0.0.1", BENCH_PORT, scenario.eServer );
+        IOSCTransport* pTransport = CreateOSCTransport( scenario.eTransport, OSCSF_Slip );
+
+        if ( !OSCIsConnectionOk( nServer ) || !pTransport->Open( "127.0.0.1", BENCH_PORT, false ) )
+        {
+            fprintf( stderr, "%s: open %d failed: %s\n", scenario.sName, BENCH_PORT, pTransport->GetErrorMessage().c_str() );
+            pTransport->Release();
+            return false;
+        }
+
+        // the same stream through a plain and a buffered receive message
+        CMockReceiveNode* nodes[2];
+
+        for ( int i = 0; i < 2; ++i )
+        {
+            int nMessage = graph.AddReceiveMessage( nServer, "/bench/ramp" );
+            GetConnection( nServer ).SetJitterBuffer( nMessage, i == 1, 0.1f, 0.05f );
+            nodes[i] = graph.AddReceiveValue( nServer, nMessage, OSCT_Float32 );
+        }
+
+        COSCPacket packet;
+        int nSlot = packet.AddValue( packet.AddMessage( "/bench/ramp" ), OSCT_Float32 );
+        oscpkt::PacketWriter pw;
+        srand( 1 );
+
+        double fError[2] = { 0, 0 }; //!< sum of |speed - 1|
+        float fLast[2] = { 0, 0 };
+        double fLastTime = 0;
+        int nSpeeds = 0;
+        int nSent = 0;
+        double fSendAt = 0;
+        Clock::time_point start = Clock::now();
+
+        for ( double fNow = 0; fNow < JITTER_DURATION; fNow = Seconds( Clock::now() - start ) )
+        {
+            // the value is the time it was meant to be sent, so it advances at exactly 1 per second
+            while ( fSendAt <= fNow )
+            {
+                packet.SetValue( nSlot, float( nSent / JITTER_RATE ) );
+                packet.NotifyChange();
+
+                if ( packet.Encode( pw ) )
+                {
+                    pTransport->SendPacket( pw.packetData(), pw.packetSize() );
+                    pTransport->Flush();
+                }
+
+                ++nSent;
+                fSendAt = nSent / JITTER_RATE + JITTER_SEND * rand() / RAND_MAX;
+            }
+
+            graph.Update();
+
+            if ( fNow >= JITTER_WARMUP && fLastTime > 0 )
+            {
+                for ( int i = 0; i < 2; ++i )
+                {
+                    fError[i] += fabs( ( nodes[i]->GetPort().fValue - fLast[i] ) / ( fNow - fLastTime ) - 1 );
+                }
+
+                ++nSpeeds;
+            }
+
+            for ( int i = 0; i < 2; ++i )
+            {
+                fLast[i] = nodes[i]->GetPort().fValue;
+            }
+
+            fLastTime = fNow;
+            std::this_thread::sleep_for( std::chrono::duration<double>( JITTER_FRAME ) );
+        }
+
+        pTransport->Release();
+
+        double fPlain = nSpeeds ? fError[0] / nSpeeds : 0;
+        double fBuffered = nSpeeds ? fError[1] / nSpeeds : 0;
+        const COSCJitterBuffer& buffer = GetConnection( nServer ).GetJitterBuffer( 1 );
+
+        printf( "%-8s %6d messages %5d frames: speed deviation plain %6.3f buffered %6.3f (delay %.1f ms, behind %.1f ms)\n",
+                scenario.sName, nSent, nSpeeds, fPlain, fBuffered, buffer.GetDelayNs() / 1e6, ( fLastTime - fLast[1] ) * 1000.0 );
+
+        // the plain value stands still most frames and jumps on arrival, the buffered one should move at the sent rate
+        if ( !nodes[1]->GetPort().nActivations || fBuffered > 0.25 || fBuffered * 4 > fPlain )
+        {
+            fprintf( stderr, "%s: buffered values are not smooth\n", scenario.sName );
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+    * @brief Log handler of the diag scenario, counts lines and the repeats the summaries report
+    */
+    struct SDiagLog
+    {
+        static int nLines;
+        static uint64 nRepeats;
+
+        static void Handle( eOSCLogLevel /* eLevel */, const char* sMessage )
+        {
+            ++nLines;
+
+            for ( const char* p = strchr( sMessage, '(' ); p; p = strchr( p + 1, '(' ) )
+            {
+                unsigned long long n = 0;
+
+                if ( sscanf( p, "(%llu times)", &n ) == 1 )
+                {
+                    nRepeats += n;
+                }
+            }
+        }
+    };
+
+    int SDiagLog::nLines = 0;
+    uint64 SDiagLog::nRepeats = 0;
+
+    bool RunDiag( const SScenario& scenario, int nFrames )
+    {
+        static const float intervals[] = { 0, DIAG_INTERVAL };
+        bool bOk = true;
+
+        for ( int nInterval = 0; nInterval < 2; ++nInterval )
+        {
+            g_fOSCLogInterval = intervals[nInterval];
+            SDiagLog::nLines = 0;
+            SDiagLog::nRepeats = 0;
+            SetOSCLogHandler( SDiagLog::Handle );
+
+            IOSCTransport* pTransport = CreateOSCTransport( scenario.eTransport, OSCSF_Slip );
+            SOSCStats stats;
+            double fSeconds = 0;
+
+            {
+                CMockFlowGraph graph;
+                int nServer = graph.AddConnection( "127.0.0.1", BENCH_PORT, scenario.eServer );
+
+                if ( !OSCIsConnectionOk( nServer ) || !pTransport->Open( "127.0.0.1", BENCH_PORT, false ) )
+                {
+                    SetOSCLogHandler( NULL );
+                    fprintf( stderr, "%s: open %d failed: %s\n", scenario.sName, BENCH_PORT, pTransport->GetErrorMessage().c_str() );
+                    pTransport->Release();
+                    return false;
+                }
+
+                // a sender that sends floats where ints are expected
+                graph.AddReceiveValue( nServer, graph.AddReceiveMessage( nServer, "/bench/diag" ), OSCT_Int32 );
+
+                COSCPacket packet;
+                int nSlot = packet.AddValue( packet.AddMessage( "/bench/diag" ), OSCT_Float32 );
+                oscpkt::PacketWriter pw;
+                Clock::time_point start = Clock::now();
+
+                for ( int nFrame = 1; nFrame <= nFrames; ++nFrame )
+                {
+                    packet.SetValue( nSlot, float( nFrame ) );
+                    packet.NotifyChange();
+
+                    if ( packet.Encode( pw ) )
+                    {
+                        pTransport->SendPacket( pw.packetData(), pw.packetSize() );
+                        pTransport->Flush();
+                    }
+
+                    for ( int i = 0; i < WAIT_FRAMES && stats.nTypeMismatches < uint64( nFrame ); ++i )
+                    {
+                        graph.Update();
+                        OSCGetStats( nServer, stats );
+                    }
+                }
+
+                fSeconds = Seconds( Clock::now() - start );
+            }
+
+            // closing the connection logged the last summary
+            SetOSCLogHandler( NULL );
+            pTransport->Release();
+
+            // the connect message, the first occurrence and a summary per interval
+            int nMaxLines = 2 + int( fSeconds / DIAG_INTERVAL ) + 1;
+
+            printf( "%-8s %6d frames osc_log_interval %.2f: %6d log lines for %llu wrong types (%llu in summaries) %8.2f us/message\n",
+                    scenario.sName, nFrames, g_fOSCLogInterval, SDiagLog::nLines, ( unsigned long long )stats.nTypeMismatches,
+                    ( unsigned long long )SDiagLog::nRepeats, fSeconds * 1e6 / nFrames );
+
+            // the first occurrence is logged, the rest has to show up in a summary
+            bool bCounted = nInterval ? SDiagLog::nRepeats + 1 == stats.nTypeMismatches : uint64( SDiagLog::nLines ) > stats.nTypeMismatches;
+
+            if ( stats.nTypeMismatches < uint64( nFrames - nFrames / 100 ) || !bCounted || ( nInterval && SDiagLog::nLines > nMaxLines ) )
+            {
+                fprintf( stderr, "%s: wrong types were not summarized\n", scenario.sName );
+                bOk = false;
+            }
+        }
+
+        g_fOSCLogInterval = 5;
+        return bOk;
+    }
+
+    /**
+    * @brief Answers /bench/ping with /bench/pong to whoever asked
+    */
+    struct SPingHandler :
+        public IOSCMessageHandler
+    {
+        int nPings;
+
+        SPingHandler() : nPings( 0 ) {}
+
+        void OnOSCMessage( int nConnection, const IOSCArgs& /* args */ )
+        {
+            char buffer[64];
+            oscpkt::PacketWriter pw;
+            oscpkt::Message msg( "/bench/pong" );
+            pw.init().addMessage( msg );
+            memcpy( buffer, pw.packetData(), pw.packetSize() );
+            OSCReplyPacket( nConnection, buffer, pw.packetSize() );
+            ++nPings;
+        }
+    };
+
+    bool RunFanOut( const SScenario& scenario, int nFrames )
+    {
+        CMockFlowGraph graph;
+        int nServer = graph.AddConnection( "127.0.0.1", BENCH_PORT, scenario.eServer );
+
+        if ( !OSCIsConnectionOk( nServer ) || !GetConnection( nServer ).SetFanOut( true, 0 ) )
+        {
+            fprintf( stderr, "%s: fan out on %d failed\n", scenario.sName, BENCH_PORT );
+            return false;
+        }
+
+        // every controller subscribes by sending something
+        std::vector<IOSCTransport*> peers;
+        COSCPacket hello;
+        hello.AddMessage( "/bench/hello" );
+        hello.NotifyChange();
+        oscpkt::PacketWriter pw;
+        hello.Encode( pw );
+
+        for ( int i = 0; i < FANOUT_PEERS; ++i )
+        {
+            peers.push_back( CreateOSCTransport( scenario.eTransport, OSCSF_Slip ) );
+            peers.back()->Open( "127.0.0.1", BENCH_PORT, false );
+            peers.back()->SendPacket( pw.packetData(), pw.packetSize() );
+        }
+
+        for ( int i = 0; i < WAIT_FRAMES && GetConnection( nServer ).GetPeerCount() < FANOUT_PEERS; ++i )
+        {
+            graph.Update();
+        }
+
+        int nSubscribed = GetConnection( nServer ).GetPeerCount();
+
+        int nPacket = graph.AddPacket( nServer );
+        SSender sender;
+        sender.Init( graph.GetPacket( nServer, nPacket ), 4 );
+
+        uint64 nDatagrams = 0;
+        uint64 nMessages = 0;
+        Clock::duration sendTime = Clock::duration::zero();
+
+        for ( int nFrame = 1; nFrame <= nFrames; ++nFrame )
+        {
+            sender.Write( graph.GetPacket( nServer, nPacket ), nFrame );
+            Clock::time_point start = Clock::now();
+            graph.Update();
+            sendTime += Clock::now() - start;
+
+            for ( size_t i = 0; i < peers.size(); ++i )
+            {
+                nMessages += Drain( peers[i], 1, nDatagrams );
+            }
+        }
+
+        // a request is answered to its sender only
+        SPingHandler handler;
+        OSCAddHandler( nServer, "/bench/ping", &handler );
+        COSCPacket ping;
+        ping.AddMessage( "/bench/ping" );
+        ping.NotifyChange();
+        ping.Encode( pw );
+        peers[0]->SendPacket( pw.packetData(), pw.packetSize() );
+
+        for ( int i = 0; i < WAIT_FRAMES && !handler.nPings; ++i )
+        {
+            graph.Update();
+        }
+
+        uint64 nPongs = 0;
+        uint64 nOthers = 0;
+        Drain( peers[0], 1, nPongs );
+
+        for ( size_t i = 1; i < peers.size(); ++i )
+        {
+            while ( peers[i]->ReceiveNextPacket() )
+            {
+                ++nOthers;
+            }
+        }
+
+        // everyone but the one that pinged goes quiet and is dropped
+        GetConnection( nServer ).SetFanOut( true, FANOUT_TIMEOUT );
+        std::this_thread::sleep_for( std::chrono::duration<double>( FANOUT_TIMEOUT * 1.5 ) );
+        peers[0]->SendPacket( pw.packetData(), pw.packetSize() );
+
+        for ( int i = 0; i < WAIT_FRAMES && handler.nPings < 2; ++i )
+        {
+            graph.Update();
+        }
+
+        sender.Write( graph.GetPacket( nServer, nPacket ), nFrames + 1 );
+        graph.Update();
+        int nRemaining = GetConnection( nServer ).GetPeerCount();
+        OSCRemoveHandler( nServer, &handler );
+
+        // a full table makes room by dropping the peer that was silent longest
+        int nMaxPeers = g_nOSCMaxPeers;
+        g_nOSCMaxPeers = 2;
+        GetConnection( nServer ).SetFanOut( true, 0 );
+        hello.Encode( pw );
+
+        for ( int i = 1; i <= 2; ++i )
+        {
+            peers[i]->SendPacket( pw.packetData(), pw.packetSize() );
+            graph.Update();
+        }
+
+        for ( int i = 0; i < WAIT_FRAMES && GetConnection( nServer ).GetPeerCount() < 2; ++i )
+        {
+            graph.Update();
+        }
+
+        int nCapped = GetConnection( nServer ).GetPeerCount();
+        g_nOSCMaxPeers = nMaxPeers;
+
+        for ( size_t i = 0; i < peers.size(); ++i )
+        {
+            peers[i]->Release();
+        }
+
+        double fSeconds = Seconds( sendTime );
+        uint64 nExpected = uint64( nFrames ) * FANOUT_PEERS;
+        printf( "%-8s %6d frames %4d peers: %8.1f us/frame %6.2f us/peer, %llu of %llu delivered (reply to 1 peer: %llu, others %llu, %d peers after timeout, %d with 2 at most)\n",
+                scenario.sName, nFrames, nSubscribed, fSeconds * 1e6 / nFrames, fSeconds * 1e6 / nFrames / FANOUT_PEERS,
+                ( unsigned long long )nMessages, ( unsigned long long )nExpected, ( unsigned long long )nPongs, ( unsigned long long )nOthers, nRemaining, nCapped );
+
+        if ( nSubscribed != FANOUT_PEERS || nMessages < nExpected - nExpected / 100 || nPongs != 1 || nOthers != 0 || nRemaining != 1 || nCapped != 2 )
+        {
+            fprintf( stderr, "%s: packets were not fanned out to the peers\n", scenario.sName );
+            return false;
+        }
+
+        return true;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    static const SScenario scenarios[] =
+    {
+        { "loopback", OSCCT_UdpServer, OSCTT_Udp },
+        { "udp", OSCCT_UdpServer, OSCTT_Udp },
+        { "tcp", OSCCT_TcpServer, OSCTT_Tcp },
+        { "replay", OSCCT_UdpServer, OSCTT_Udp },
+        { "rebind", OSCCT_UdpServer, OSCTT_Udp },
+        { "coalesce", OSCCT_UdpServer, OSCTT_Udp },
+        { "suppress", OSCCT_UdpServer, OSCTT_Udp },
+        { "timetag", OSCCT_UdpServer, OSCTT_Udp },
+        { "jitter", OSCCT_UdpServer, OSCTT_Udp },
+        { "diag", OSCCT_UdpServer, OSCTT_Udp },
+        { "fanout", OSCCT_UdpServer, OSCTT_Udp },
+    };
+
+    int nFrames = 100000;
+    int nValues = 16;
+    std::vector<const char*> selected;
+
+    for ( int i = 1; i < argc; ++i )
+    {
+        if ( strcmp( argv[i], "--frames" ) == 0 && i + 1 < argc )
+        {
+            nFrames = atoi( argv[++i] );
+        }
+
+        else if ( strcmp( argv[i], "--values" ) == 0 && i + 1 < argc )
+        {
+            nValues = atoi( argv[++i] );
+        }
+
+        else
+        {
+            selected.push_back( argv[i] );
+        }
+    }
+
+    bool bOk = true;
+
+    for ( size_t s = 0; s < sizeof( scenarios ) / sizeof( scenarios[0] ); ++s )
+    {
+        bool bSelected = selected.empty();
+
+        for ( size_t i = 0; i < selected.size(); ++i )
+        {
+            bSelected |= strcmp( selected[i], scenarios[s].sName ) == 0;
+        }
+
+        if ( !bSelected )
+        {
+            continue;
+        }
+
+        if ( s == 0 )
+        {
+            bOk &= RunLoopback( scenarios[s], nFrames, nValues );
+        }
+
+        else if ( s == 3 )
+        {
+            bOk &= RunReplay( scenarios[s], nFrames, nValues );
+        }
+
+        else if ( s == 4 )
+        {
+            bOk &= RunRebind( scenarios[s], nValues );
+        }
+
+        else if ( s == 5 )
+        {
+            bOk &= RunCoalesce( scenarios[s], nFrames, nValues );
+        }
+
+        else if ( s == 6 )
+        {
+            bOk &= RunSuppress( scenarios[s], nFrames, nValues );
+        }
+
+        else if ( s == 7 )
+        {
+            bOk &= RunTimeTag( scenarios[s], nFrames, nValues );
+        }
+
+        else if ( s == 8 )
+        {
+            bOk &= RunJitter( scenarios[s] );
+        }
+
+        else if ( s == 9 )
+        {
+            bOk &= RunDiag( scenarios[s], nFrames );
+        }
+
+        else if ( s == 10 )
+        {
+            bOk &= RunFanOut( scenarios[s], nFrames );
+        }
+
+        else
+        {
+            bOk &= RunSocket( scenarios[s], nFrames, nValues );
+        }
+    }
+
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,942 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+/**
+   Correctness checks of the connection core (src/OSCConnection.cpp) and its transports,
+   the timings are in bench/osc_core_bench.cc, this only checks the results:
+   - shm: a ring whose header was left behind corrupted is set up again
+   - loopback: every value type arrives unchanged at the receive value nodes, once per change
+   - capture: the capture file holds the received packets byte for byte, replaying it returns and dispatches the same packets
+   - rebind: an Init with the same settings keeps the ids and the socket, a hot rebind keeps the nodes, a shared connection can't be moved
+   - coalesce: the packets changed in a frame arrive in as few datagrams as the size limit allows, each exactly once
+   - suppress: a packet requested every frame is sent once per change, the suppressed count equals the number of repeats
+   - timetag: bundles are tagged immediate, with the frame start shared by all connections or with the send time, plus the latency
+   - jitter: a ramp arriving unevenly comes out of the jitter buffer in order, moving every frame and never going back
+   - diag: the first occurrence of a problem is logged, every repeat is counted in exactly one summary
+   - fanout: every subscribed peer receives the same bytes of every packet once, replies only reach the sender
+
+   build with cmake (CMakeLists.txt) or (Linux):
+
+   g++ -O2 -std=c++11 -Ibench -I. -Isrc -Iinc bench/osc_core_test.cc src/OSCConnection.cpp src/OSCCapture.cpp src/OSCTransport.cpp src/OSCTcpTransport.cpp src/OSCShmTransport.cpp src/OSCByteSwap.cpp src/OSCCoalescer.cpp src/OSCDiagnostics.cpp src/OSCJitterBuffer.cpp src/OSCPeerTable.cpp src/OSCSendScheduler.cpp src/OSCTrace.cpp -o osc_core_test -lpthread -lrt
+
+   returns nonzero and names the failed check if anything doesn't work as expected
+ */
+
+#include <osc_mock_flow.h>
+#include <OSCCapture.h>
+#include <OSCDiagnostics.h>
+#include <OSCShmTransport.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#if !defined(_MSC_VER) && !defined(WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace OSCMock;
+
+// unlike assert this also checks in release builds
+#define OSC_CHECK(x) do { if ( !( x ) ) { fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x ); exit( 1 ); } } while ( 0 )
+
+namespace
+{
+    const int TEST_PORT = 9340;
+    const int WAIT_FRAMES = 1000; //!< frames a check waits for something to arrive, in process it takes one or two
+
+    /**
+    * @brief Open a ring whose header was left behind with a bad capacity, it has to start over instead of
+    * deriving its mask from it
+    */
+    void TestShmCorruptHeader( unsigned int nCapacity )
+    {
+#if !defined(_MSC_VER) && !defined(WIN32)
+        const char* sName = "osc_core_test_shm";
+        std::string sPath = std::string( "/" ) + sName;
+        shm_unlink( sPath.c_str() );
+
+        size_t nSize = sizeof( SOSCShmHeader ) + COSCShmRing::SHM_MIN_CAPACITY;
+        int nHandle = shm_open( sPath.c_str(), O_RDWR | O_CREAT, 0600 );
+        OSC_CHECK( nHandle != -1 );
+        OSC_CHECK( ftruncate( nHandle, nSize ) == 0 );
+
+        void* pMemory = mmap( 0, nSize, PROT_READ | PROT_WRITE, MAP_SHARED, nHandle, 0 );
+        OSC_CHECK( pMemory != MAP_FAILED );
+        close( nHandle );
+
+        SOSCShmHeader* pHeader = ( SOSCShmHeader* )pMemory;
+        memset( pHeader, 0, sizeof( SOSCShmHeader ) );
+        pHeader->nMagic = COSCShmRing::SHM_MAGIC;
+        pHeader->nCapacity = nCapacity;
+
+        COSCShmRing consumer;
+        OSC_CHECK( consumer.Open( sName, COSCShmRing::SHM_MIN_CAPACITY, true ) );
+        OSC_CHECK( pHeader->nCapacity == COSCShmRing::SHM_MIN_CAPACITY );
+
+        COSCShmRing producer;
+        OSC_CHECK( producer.Open( sName, COSCShmRing::SHM_MIN_CAPACITY, false ) );
+
+        // enough records to wrap around the ring several times
+        for ( int i = 0; i < 1000; ++i )
+        {
+            char data[64];
+            memset( data, i & 0xFF, sizeof( data ) );
+            OSC_CHECK( producer.Write( data, sizeof( data ) ) );
+
+            const char* pData = 0;
+            size_t nData = 0;
+            OSC_CHECK( consumer.Peek( pData, nData ) );
+            OSC_CHECK( nData == sizeof( data ) && memcmp( pData, data, nData ) == 0 );
+            consumer.Pop();
+        }
+
+        munmap( pMemory, nSize );
+        producer.Close();
+        consumer.Close();
+        shm_unlink( sPath.c_str() );
+#else
+        ( void )nCapacity;
+#endif
+    }
+
+    void TestShm()
+    {
+        TestShmCorruptHeader( 0 );
+        TestShmCorruptHeader( 3000 ); // not a power of two
+        TestShmCorruptHeader( 1024 ); // below the minimum
+        TestShmCorruptHeader( 1u << 30 ); // larger than the mapping
+    }
+
+    /**
+    * @brief Values of every type a client connection sends to a server connection in the same process
+    */
+    void TestLoopback()
+    {
+        CMockFlowGraph graph;
+        int nServer = graph.AddConnection( "127.0.0.1", TEST_PORT, OSCCT_UdpServer );
+        int nClient = graph.AddConnection( "127.0.0.1", TEST_PORT, OSCCT_UdpClient );
+        OSC_CHECK( OSCIsConnectionOk( nServer ) && OSCIsConnectionOk( nClient ) );
+
+        int nMessage = graph.AddReceiveMessage( nServer, "/test/values" );
+        CMockReceiveNode* pInt = graph.AddReceiveValue( nServer, nMessage, OSCT_Int32 );
+        CMockReceiveNode* pFloat = graph.AddReceiveValue( nServer, nMessage, OSCT_Float32 );
+        CMockReceiveNode* pBool = graph.AddReceiveValue( nServer, nMessage, OSCT_Bool );
+        CMockReceiveNode* pString = graph.AddReceiveValue( nServer, nMessage, OSCT_String );
+
+        int nPacket = graph.AddPacket( nClient );
+        int nSend = graph.AddSendMessage( nClient, nPacket, "/test/values" );
+        int nIntSlot = graph.AddSendValue( nClient, nPacket, nSend, OSCT_Int32 );
+        int nFloatSlot = graph.AddSendValue( nClient, nPacket, nSend, OSCT_Float32 );
+        int nBoolSlot = graph.AddSendValue( nClient, nPacket, nSend, OSCT_Bool );
+        int nStringSlot = graph.AddSendValue( nClient, nPacket, nSend, OSCT_String );
+
+        const int nFrames = 100;
+
+        for ( int nFrame = 1; nFrame <= nFrames; ++nFrame )
+        {
+            char sValue[32];
+            snprintf( sValue, sizeof( sValue ), "frame %d", nFrame );
+            graph.SetValue( nClient, nPacket, nIntSlot, nFrame );
+            graph.SetValue( nClient, nPacket, nFloatSlot, nFrame * 0.25f );
+            graph.SetValue( nClient, nPacket, nBoolSlot, ( nFrame & 1 ) != 0 );
+            graph.SetValue( nClient, nPacket, nStringSlot, ( const char* )sValue );
+
+            for ( int i = 0; i < WAIT_FRAMES && pInt->GetPort().nActivations < nFrame; ++i )
+            {
+                graph.Update();
+            }
+
+            OSC_CHECK( pInt->GetPort().nActivations == nFrame && pInt->GetPort().nValue == nFrame );
+            OSC_CHECK( pFloat->GetPort().nActivations == nFrame && pFloat->GetPort().fValue == nFrame * 0.25f );
+            OSC_CHECK( pBool->GetPort().nActivations == nFrame && pBool->GetPort().bValue == ( ( nFrame & 1 ) != 0 ) );
+            OSC_CHECK( pString->GetPort().nActivations == nFrame && pString->GetPort().sValue == sValue );
+        }
+
+        // nothing changed, nothing is sent again
+        for ( int i = 0; i < 10; ++i )
+        {
+            graph.Update();
+        }
+
+        OSC_CHECK( pInt->GetPort().nActivations == nFrames );
+    }
+
+    /**
+    * @brief Packets a raw socket sends to a server connection that records them, then played back from the file
+    */
+    void TestCaptureReplay()
+    {
+        const char* sFile = "osc_core_test.osccap";
+        const int nPackets = 50;
+        std::vector<std::string> sent;
+
+        {
+            CMockFlowGraph graph;
+            int nServer = graph.AddConnection( "127.0.0.1", TEST_PORT, OSCCT_UdpServer );
+            OSC_CHECK( OSCIsConnectionOk( nServer ) && OSCCapture( TEST_PORT, sFile ) );
+
+            IOSCTransport* pTransport = CreateOSCTransport( OSCTT_Udp, OSCSF_Slip );
+            OSC_CHECK( pTransport->Open( "127.0.0.1", TEST_PORT, false ) );
+
+            oscpkt::PacketWriter pw;
+            SOSCStats stats;
+
+            for ( int i = 1; i <= nPackets; ++i )
+            {
+                oscpkt::Message msg( "/test/capture" );
+                msg.pushInt32( i ).pushStr( std::string( i, 'x' ) );
+                pw.init().addMessage( msg );
+                sent.push_back( std::string( pw.packetData(), pw.packetSize() ) );
+                OSC_CHECK( pTransport->SendPacket( pw.packetData(), pw.packetSize() ) );
+
+                // one at a time, so a full socket buffer can't drop any
+                for ( int n = 0; n < WAIT_FRAMES && stats.nPacketsIn < uint64( i ); ++n )
+                {
+                    graph.Update();
+                    OSCGetStats( nServer, stats );
+                }
+
+                OSC_CHECK( stats.nPacketsIn == uint64( i ) );
+            }
+
+            pTransport->Release();
+            OSC_CHECK( OSCCapture( TEST_PORT, NULL ) );
+        }
+
+        // the file holds the packets byte for byte, in order, with their sender
+        COSCCaptureFile file;
+        OSC_CHECK( file.Open( sFile ) );
+        size_t nOffset = file.Begin();
+        const SOSCCaptureRecord* pRecord = NULL;
+        const char* pSender = NULL;
+        const void* pData = NULL;
+        uint64 nLast = 0;
+        int nRecords = 0;
+
+        while ( file.Next( nOffset, pRecord, pSender, pData ) )
+        {
+            OSC_CHECK( nRecords < nPackets );
+            OSC_CHECK( std::string( ( const char* )pData, pRecord->nSize ) == sent[nRecords] );
+            OSC_CHECK( std::string( pSender, pRecord->nSenderSize ).compare( 0, 10, "127.0.0.1:" ) == 0 );
+            OSC_CHECK( pRecord->nTimestamp >= nLast );
+            nLast = pRecord->nTimestamp;
+            ++nRecords;
+        }
+
+        OSC_CHECK( nRecords == nPackets );
+        file.Close();
+
+        // the replay hands out the same bytes
+        COSCReplayTransport replay( 0 );
+        OSC_CHECK( replay.Open( sFile, TEST_PORT, true ) );
+
+        for ( int i = 0; i < nPackets; ++i )
+        {
+            OSC_CHECK( replay.ReceiveNextPacket() );
+            OSC_CHECK( std::string( ( const char* )replay.GetPacketData(), replay.GetPacketSize() ) == sent[i] );
+        }
+
+        OSC_CHECK( !replay.ReceiveNextPacket() && replay.IsFinished() );
+        replay.Close();
+
+        // and a server connection replaying it dispatches every packet to its nodes
+        {
+            CMockFlowGraph graph;
+            int nServer = graph.AddConnection( "127.0.0.1", TEST_PORT, OSCCT_UdpServer );
+            CMockReceiveNode* pNode = graph.AddReceiveValue( nServer, graph.AddReceiveMessage( nServer, "/test/capture" ), OSCT_Int32 );
+            OSC_CHECK( OSCReplay( TEST_PORT, sFile, 0 ) );
+
+            for ( int i = 0; i < WAIT_FRAMES && pNode->GetPort().nActivations < nPackets; ++i )
+            {
+                graph.Update();
+            }
+
+            OSC_CHECK( pNode->GetPort().nActivations == nPackets && pNode->GetPort().nValue == nPackets );
+        }
+
+        remove( sFile );
+    }
+
+    /**
+    * @brief Send an int to a port with a raw socket
+    */
+    void SendInt( int nPort, const char* sAddress, int nValue )
+    {
+        IOSCTransport* pTransport = CreateOSCTransport( OSCTT_Udp, OSCSF_Slip );
+        OSC_CHECK( pTransport->Open( "127.0.0.1", nPort, false ) );
+
+        oscpkt::PacketWriter pw;
+        oscpkt::Message msg( sAddress );
+        msg.pushInt32( nValue );
+        pw.init().addMessage( msg );
+        OSC_CHECK( pTransport->SendPacket( pw.packetData(), pw.packetSize() ) );
+        pTransport->Release();
+    }
+
+    /**
+    * @brief Re-initializing a connection in place keeps its ids and socket, a hot rebind keeps the nodes
+    */
+    void TestRebind()
+    {
+        const int nMessages = 8;
+        CMockFlowGraph graph;
+        int nServer = graph.AddConnection( "127.0.0.1", TEST_PORT, OSCCT_UdpServer );
+        OSC_CHECK( OSCIsConnectionOk( nServer ) );
+
+        std::vector<int> ids;
+        std::vector<CMockReceiveNode*> nodes;
+
+        for ( int m = 0; m < nMessages; ++m )
+        {
+            char sAddress[32];
+            snprintf( sAddress, sizeof( sAddress ), "/test/rebind/%d", m );
+            ids.push_back( graph.AddReceiveMessage( nServer, sAddress ) );
+            nodes.push_back( graph.AddReceiveValue( nServer, ids.back(), OSCT_Int32 ) );
+        }
+
+        graph.Update();
+
+        // a packet waiting in the socket survives an Init with the same settings
+        SendInt( TEST_PORT, "/test/rebind/3", 1 );
+        OSC_CHECK( graph.Reinit( nServer, "127.0.0.1", TEST_PORT, OSCCT_UdpServer ) == nServer );
+
+        for ( int m = 0; m < nMessages; ++m )
+        {
+            char sAddress[32];
+            snprintf( sAddress, sizeof( sAddress ), "/test/rebind/%d", m );
+            OSC_CHECK( graph.AddReceiveMessage( nServer, sAddress ) == ids[m] );
+            nodes[m] = graph.AddReceiveValue( nServer, ids[m], OSCT_Int32 );
+        }
+
+        for ( int i = 0; i < WAIT_FRAMES && !nodes[3]->GetPort().nActivations; ++i )
+        {
+            graph.Update();
+        }
+
+        OSC_CHECK( nodes[3]->GetPort().nValue == 1 );
+        OSC_CHECK( GetConnection( nServer ).GetReceiveMessageCount() == size_t( nMessages ) );
+
+        // another port without Init, the nodes registered before get the values
+        OSC_CHECK( graph.Rebind( nServer, "127.0.0.1", TEST_PORT + 1, OSCCT_UdpServer ) );
+        SendInt( TEST_PORT + 1, "/test/rebind/5", 2 );
+
+        for ( int i = 0; i < WAIT_FRAMES && !nodes[5]->GetPort().nActivations; ++i )
+        {
+            graph.Update();
+        }
+
+        OSC_CHECK( nodes[5]->GetPort().nValue == 2 );
+
+        // a shared connection keeps its settings for the other user
+        int nShared = graph.AddConnection( "127.0.0.1", TEST_PORT + 1, OSCCT_UdpServer );
+        OSC_CHECK( &GetConnection( nShared ) == &GetConnection( nServer ) );
+        OSC_CHECK( !graph.Rebind( nServer, "127.0.0.1", TEST_PORT, OSCCT_UdpServer ) );
+    }
+
+    /**
+    * @brief Collect the datagrams that arrive, waits for nExpected and then briefly for any surplus
+    */
+    void ReceiveDatagrams( IOSCTransport* pReceiver, size_t nExpected, std::vector<std::string>& datagrams )
+    {
+        datagrams.clear();
+
+        while ( pReceiver->WaitForPacket( datagrams.size() < nExpected ? 1000 : 5 ) )
+        {
+            while ( pReceiver->ReceiveNextPacket() )
+            {
+                datagrams.push_back( std::string( ( const char* )pReceiver->GetPacketData(), pReceiver->GetPacketSize() ) );
+            }
+        }
+    }
+
+    /**
+    * @brief The messages of a datagram, bundles are unpacked
+    */
+    std::vector<oscpkt::Message> ReadMessages( const std::string& sDatagram )
+    {
+        std::vector<oscpkt::Message> messages;
+        oscpkt::PacketReader pr( sDatagram.data(), sDatagram.size() );
+        OSC_CHECK( pr.isOk() );
+
+        while ( oscpkt::Message* pMessage = pr.popMessage() )
+        {
+            messages.push_back( *pMessage );
+        }
+
+        return messages;
+    }
+
+    /**
+    * @brief The packets changed in a frame go out as few bundles, none is lost or sent twice
+    */
+    void TestCoalesce()
+    {
+        const int nPackets = 8;
+        IOSCTransport* pReceiver = CreateOSCTransport( OSCTT_Udp, OSCSF_Slip );
+        OSC_CHECK( pReceiver->Open( "127.0.0.1", TEST_PORT, true ) );
+
+        // off, one datagram, and a limit that only fits a few packets per bundle
+        static const size_t sizes[] = { 0, OSC_COALESCE_UDP_SIZE, 128 };
+
+        for ( size_t s = 0; s < sizeof( sizes ) / sizeof( sizes[0] ); ++s )
+        {
+            CMockFlowGraph graph;
+            int nClient = graph.AddConnection( "127.0.0.1", TEST_PORT, OSCCT_UdpClient );
+            GetConnection( nClient ).SetCoalesceSize( sizes[s] );
+
+            std::vector<int> packets;
+            std::vector<int> slots;
+
+            for ( int p = 0; p < nPackets; ++p )
+            {
+                char sAddress[32];
+                snprintf( sAddress, sizeof( sAddress ), "/test/coalesce/%d", p );
+                packets.push_back( graph.AddPacket( nClient ) );
+                int nMessage = graph.AddSendMessage( nClient, packets[p], sAddress );
+                slots.push_back( graph.AddSendValue( nClient, packets[p], nMessage, OSCT_Int32 ) );
+            }
+
+            for ( int nFrame = 1; nFrame <= 3; ++nFrame )
+            {
+                for ( int p = 0; p < nPackets; ++p )
+                {
+                    graph.SetValue( nClient, packets[p], slots[p], nFrame * 100 + p );
+                }
+
+                graph.Update();
+
+                std::vector<std::string> datagrams;
+                ReceiveDatagrams( pReceiver, sizes[s] == OSC_COALESCE_UDP_SIZE ? 1 : nPackets, datagrams );
+                std::vector<int> received( nPackets, 0 );
+
+                for ( size_t d = 0; d < datagrams.size(); ++d )
+                {
+                    OSC_CHECK( sizes[s] == 0 || datagrams[d].size() <= sizes[s] );
+                    std::vector<oscpkt::Message> messages = ReadMessages( datagrams[d] );
+
+                    for ( size_t m = 0; m < messages.size(); ++m )
+                    {
+                        int p = atoi( messages[m].addressPattern().c_str() + strlen( "/test/coalesce/" ) );
+                        int nValue = 0;
+                        OSC_CHECK( p >= 0 && p < nPackets );
+                        OSC_CHECK( messages[m].arg().popInt32( nValue ).isOkNoMoreArgs() && nValue == nFrame * 100 + p );
+                        ++received[p];
+                    }
+                }
+
+                OSC_CHECK( std::count( received.begin(), received.end(), 1 ) == nPackets );
+
+                if ( sizes[s] == 0 )
+                {
+                    OSC_CHECK( datagrams.size() == size_t( nPackets ) );
+                }
+
+                else if ( sizes[s] == OSC_COALESCE_UDP_SIZE )
+                {
+                    OSC_CHECK( datagrams.size() == 1 );
+                }
+
+                else
+                {
+                    OSC_CHECK( datagrams.size() > 1 && datagrams.size() < size_t( nPackets ) );
+                }
+            }
+
+            SOSCStats stats;
+            OSCGetStats( nClient, stats );
+            OSC_CHECK( sizes[s] == OSC_COALESCE_UDP_SIZE ? stats.nCoalesced == uint64( 3 * nPackets ) : ( stats.nCoalesced == 0 ) == ( sizes[s] == 0 ) );
+        }
+
+        pReceiver->Release();
+    }
+
+    /**
+    * @brief Packets requested every frame but changed only every few frames are sent once per change,
+    * every repeat is counted as suppressed, and the keep alive sends a repeat once it's due
+    */
+    void TestSuppress()
+    {
+        const int nPackets = 4;
+        const int nFrames = 60;
+        const int nChange = 5; //!< frames between changes
+
+        CMockFlowGraph graph;
+        int nServer = graph.AddConnection( "127.0.0.1", TEST_PORT, OSCCT_UdpServer );
+        int nClient = graph.AddConnection( "127.0.0.1", TEST_PORT, OSCCT_UdpClient );
+        GetConnection( nClient ).SetSuppressRepeats( true, 0 );
+
+        std::vector<int> packets;
+        std::vector<int> slots;
+        std::vector<CMockReceiveNode*> nodes;
+
+        for ( int p = 0; p < nPackets; ++p )
+        {
+            char sAddress[32];
+            snprintf( sAddress, sizeof( sAddress ), "/test/suppress/%d", p );
+            nodes.push_back( graph.AddReceiveValue( nServer, graph.AddReceiveMessage( nServer, sAddress ), OSCT_Int32 ) );
+            packets.push_back( graph.AddPacket( nClient ) );
+            slots.push_back( graph.AddSendValue( nClient, packets[p], graph.AddSendMessage( nClient, packets[p], sAddress ), OSCT_Int32 ) );
+        }
+
+        for ( int nFrame = 0; nFrame < nFrames; ++nFrame )
+        {
+            for ( int p = 0; p < nPackets; ++p )
+            {
+                if ( nFrame % nChange == 0 )
+                {
+                    graph.SetValue( nClient, packets[p], slots[p], nFrame );
+                }
+
+                else
+                {
+                    graph.GetPacket( nClient, packets[p] ).RequestSend();
+                }
+            }
+
+            graph.Update();
+        }
+
+        // whatever is still queued in process arrives with the next frames
+        for ( int i = 0; i < 10; ++i )
+        {
+            graph.Update();
+        }
+
+        int nChanges = ( nFrames + nChange - 1 ) / nChange;
+        SOSCStats stats;
+        OSCGetStats( nClient, stats );
+        OSC_CHECK( stats.nSuppressed == uint64( ( nFrames - nChanges ) * nPackets ) );
+        OSC_CHECK( stats.nPacketsOut == uint64( nChanges * nPackets ) );
+
+        for ( int p = 0; p < nPackets; ++p )
+        {
+            OSC_CHECK( nodes[p]->GetPort().nActivations == nChanges );
+            OSC_CHECK( nodes[p]->GetPort().nValue == ( nChanges - 1 ) * nChange );
+        }
+
+        // with a keep alive a repeat goes out once it's due, and only then
+        GetConnection( nClient ).SetSuppressRepeats( true, 0.05f );
+        graph.SetValue( nClient, packets[0], slots[0], -1 );
+        graph.Update();
+        graph.GetPacket( nClient, packets[0] ).RequestSend();
+        graph.Update();
+        std::this_thread::sleep_for( std::chrono::milliseconds( 80 ) );
+        graph.GetPacket( nClient, packets[0] ).RequestSend();
+        graph.Update();
+        graph.Update();
+
+        OSC_CHECK( nodes[0]->GetPort().nActivations == nChanges + 2 );
+        OSC_CHECK( nodes[0]->GetPort().nValue == -1 );
+    }
+
+    /**
+    * @brief Timetag of the bundle in a datagram
+    */
+    uint64 ReadTimeTag( const std::string& sDatagram )
+    {
+        oscpkt::PacketReader pr( sDatagram.data(), sDatagram.size() );
+        oscpkt::Message* pMessage = pr.popMessage();
+        OSC_CHECK( pMessage );
+        return pMessage->timeTag();
+    }
+
+    /**
+    * @brief Bundles carry the time of the chosen clock plus the latency, packets of a single message stay plain
+    */
+    void TestTimeTag()
+    {
+        const float fLatency = 0.25f;
+        const uint64 nLatencyNs = uint64( double( fLatency ) * 1e9 );
+        const uint64 nSlackNs = 1000; //!< timetags have a resolution of 0.23 ns, the conversions round down
+
+        IOSCTransport* pReceiver = CreateOSCTransport( OSCTT_Udp, OSCSF_Slip );
+        OSC_CHECK( pReceiver->Open( "127.0.0.1", TEST_PORT, true ) );
+
+        // two clients, so the frame clock can be checked to be shared
+        CMockFlowGraph graph;
+        int clients[2] = { graph.AddConnection( "127.0.0.1", TEST_PORT, OSCCT_UdpClient ), graph.AddConnection( "localhost", TEST_PORT, OSCCT_UdpClient ) };
+        int packets[2];
+        int slots[2];
+
+        for ( int c = 0; c < 2; ++c )
+        {
+            packets[c] = graph.AddPacket( clients[c] );
+            COSCPacket& packet = graph.GetPacket( clients[c], packets[c] );
+            packet.AddBundleStart();
+            slots[c] = packet.AddValue( packet.AddMessage( "/test/timetag" ), OSCT_Int32 );
+            packet.AddBundleEnd();
+        }
+
+        std::vector<std::string> datagrams;
+
+        for ( int nClock = OSCTC_Immediate; nClock <= OSCTC_Monotonic; ++nClock )
+        {
+            for ( int c = 0; c < 2; ++c )
+            {
+                GetConnection( clients[c] ).SetTimeTags( eOSCTimeTagClock( nClock ), fLatency );
+            }
+
+            uint64 nPrevious = 0;
+
+            for ( int nFrame = 1; nFrame <= 3; ++nFrame )
+            {
+                for ( int c = 0; c < 2; ++c )
+                {
+                    graph.SetValue( clients[c], packets[c], slots[c], nFrame );
+                }
+
+                uint64 nBefore = GetOSCMonotonicClockNs();
+                graph.Update();
+                uint64 nAfter = GetOSCMonotonicClockNs();
+
+                ReceiveDatagrams( pReceiver, 2, datagrams );
+                OSC_CHECK( datagrams.size() == 2 );
+                uint64 nTimeTag = ReadTimeTag( datagrams[0] );
+
+                if ( nClock == OSCTC_Immediate )
+                {
+                    OSC_CHECK( nTimeTag == 1 && ReadTimeTag( datagrams[1] ) == 1 );
+                    continue;
+                }
+
+                uint64 nTime = OSCTimeTagToUnixNs( nTimeTag );
+                OSC_CHECK( nTime + nSlackNs >= nBefore + nLatencyNs && nTime <= nAfter + nLatencyNs );
+                OSC_CHECK( nTime > nPrevious );
+                nPrevious = nTime;
+
+                if ( nClock == OSCTC_FrameStart )
+                {
+                    // everything sent in a frame has the time the frame started
+                    OSC_CHECK( ReadTimeTag( datagrams[1] ) == nTimeTag );
+                }
+            }
+        }
+
+        // a single message has nowhere to put a timetag
+        int nPlain = graph.AddPacket( clients[0] );
+        int nSlot = graph.AddSendValue( clients[0], nPlain, graph.AddSendMessage( clients[0], nPlain, "/test/plain" ), OSCT_Int32 );
+        graph.SetValue( clients[0], nPlain, nSlot, 1 );
+        graph.Update();
+
+        ReceiveDatagrams( pReceiver, 1, datagrams );
+        OSC_CHECK( datagrams.size() == 1 && datagrams[0][0] == '/' );
+
+        pReceiver->Release();
+    }
+
+    /**
+    * @brief A ramp that arrives with jitter comes out of the buffer in order, never going back once the delay settled,
+    * between the values sent and moving every frame. Runs on a made up clock so the result doesn't depend on the machine.
+    */
+    void TestJitterBuffer()
+    {
+        const uint64 nInterval = 33333333; //!< 30 Hz
+        const uint64 nJitter = 10000000; //!< arrives up to 10 ms late
+        const uint64 nFrame = 4000000; //!< 250 Hz render loop
+        const int nSamples = 90;
+        const uint64 nWarmup = 10 * nInterval; //!< until the delay settled values may be extrapolated too far
+
+        COSCJitterBuffer buffer;
+        buffer.Configure( true, 0.1f, 0.05f );
+        OSC_CHECK( !buffer.Sample( 1 ) );
+
+        unsigned int nRandom = 1;
+        uint64 nNextArrival = nInterval;
+        int nPushed = 0;
+        float fLast = -1;
+        int nStill = 0; //!< frames the output did not move after the buffer filled
+        uint64 nEnd = nSamples * nInterval + nJitter;
+
+        for ( uint64 nNow = nFrame; nNow < nEnd + 200000000; nNow += nFrame )
+        {
+            while ( nPushed < nSamples && nNextArrival <= nNow )
+            {
+                // the value is the time it was sent in seconds
+                buffer.GetInput().assign( 1, float( nPushed ) / 30 );
+                buffer.Push( nNextArrival );
+                ++nPushed;
+
+                nRandom = nRandom * 1103515245 + 12345;
+                nNextArrival = ( nPushed + 1 ) * nInterval + ( nRandom >> 8 ) % nJitter;
+            }
+
+            const float* pValues = buffer.Sample( nNow );
+
+            if ( !pValues )
+            {
+                continue;
+            }
+
+            OSC_CHECK( buffer.GetChannelCount() == 1 );
+            OSC_CHECK( pValues[0] >= fLast || nNow < nWarmup );
+            OSC_CHECK( pValues[0] <= float( nPushed + 1 ) / 30 ); // extrapolated no further than the 50 ms limit
+
+            if ( nNow >= nWarmup && nNow < nEnd && pValues[0] == fLast )
+            {
+                ++nStill;
+            }
+
+            fLast = pValues[0];
+        }
+
+        // the stream ended, the last value was held and isn't output again
+        OSC_CHECK( nStill == 0 );
+        OSC_CHECK( fLast >= float( nSamples - 1 ) / 30 );
+        OSC_CHECK( !buffer.Sample( nEnd + 300000000 ) );
+
+        // a sample older than the newest is dropped instead of sending the output back in time
+        buffer.GetInput().assign( 1, -100.0f );
+        buffer.Push( nInterval );
+        OSC_CHECK( !buffer.Sample( nEnd + 300000000 + nFrame ) );
+
+        // a different number of values starts over
+        buffer.GetInput().assign( 2, 5.0f );
+        buffer.Push( nEnd + 400000000 );
+        const float* pValues = buffer.Sample( nEnd + 400000000 );
+        OSC_CHECK( pValues && buffer.GetChannelCount() == 2 && pValues[0] == 5.0f && pValues[1] == 5.0f );
+    }
+
+    /**
+    * @brief Log handler of the diagnostics test, counts the lines and the repeats the summaries report
+    */
+    struct SDiagLog
+    {
+        static int nLines;
+        static uint64 nRepeats;
+
+        static void Handle( eOSCLogLevel /* eLevel */, const char* sMessage )
+        {
+            ++nLines;
+
+            for ( const char* p = strchr( sMessage, '(' ); p; p = strchr( p + 1, '(' ) )
+            {
+                unsigned long long n = 0;
+
+                if ( sscanf( p, "(%llu times)", &n ) == 1 )
+                {
+                    nRepeats += n;
+                }
+            }
+        }
+
+        static void Reset()
+        {
+            nLines = 0;
+            nRepeats = 0;
+        }
+    };
+
+    int SDiagLog::nLines = 0;
+    uint64 SDiagLog::nRepeats = 0;
+
+    /**
+    * @brief The first occurrence of a problem is logged, every repeat shows up in exactly one summary
+    */
+    void TestDiagnostics()
+    {
+        const uint64 nSecond = 1000000000;
+        float fInterval = g_fOSCLogInterval;
+        g_fOSCLogInterval = 1;
+        SetOSCLogHandler( SDiagLog::Handle );
+        SDiagLog::Reset();
+
+        // on a made up clock
+        COSCDiagnostics diag;
+        uint64 nStart = 10 * nSecond;
+        OSC_CHECK( diag.Report( OSCD_WrongType, 3, "/a", nStart ) );
+        OSC_CHECK( diag.Report( OSCD_WrongType, 4, "/b", nStart ) );
+
+        for ( int i = 1; i < 10; ++i )
+        {
+            OSC_CHECK( !diag.Report( OSCD_WrongType, 3, "/a", nStart + i ) );
+        }
+
+        OSC_CHECK( !diag.IsDue( nStart + nSecond / 2 ) && diag.IsDue( nStart + nSecond ) );
+        diag.Flush( "test", nStart + nSecond );
+        OSC_CHECK( SDiagLog::nLines == 1 && SDiagLog::nRepeats == 9 );
+
+        // /b did not repeat and is forgotten, /a still counts
+        OSC_CHECK( diag.Report( OSCD_WrongType, 4, "/b", nStart + nSecond + 1 ) );
+        OSC_CHECK( !diag.Report( OSCD_WrongType, 3, "/a", nStart + nSecond + 2 ) );
+        diag.Flush( "test", nStart + 2 * nSecond );
+        OSC_CHECK( SDiagLog::nLines == 2 && SDiagLog::nRepeats == 10 );
+
+        // nothing repeated, nothing to summarize and everything logs right away again
+        diag.Flush( "test", nStart + 3 * nSecond );
+        OSC_CHECK( SDiagLog::nLines == 2 );
+        OSC_CHECK( diag.Report( OSCD_WrongType, 3, "/a", nStart + 3 * nSecond ) );
+
+        // a connection receiving the wrong type: one line now, the rest in the summary when it closes
+        const int nMessages = 50;
+        g_fOSCLogInterval = 60; // real time now, no summary may come due before the end
+        SDiagLog::Reset();
+        SOSCStats stats;
+
+        {
+            CMockFlowGraph graph;
+            int nServer = graph.AddConnection( "127.0.0.1", TEST_PORT, OSCCT_UdpServer );
+            int nClient = graph.AddConnection( "127.0.0.1", TEST_PORT, OSCCT_UdpClient );
+            graph.AddReceiveValue( nServer, graph.AddReceiveMessage( nServer, "/test/diag" ), OSCT_Int32 );
+
+            int nPacket = graph.AddPacket( nClient );
+            int nSlot = graph.AddSendValue( nClient, nPacket, graph.AddSendMessage( nClient, nPacket, "/test/diag" ), OSCT_Float32 );
+            SDiagLog::Reset(); // without the connect messages
+
+            for ( int i = 1; i <= nMessages; ++i )
+            {
+                graph.SetValue( nClient, nPacket, nSlot, float( i ) );
+
+                for ( int n = 0; n < WAIT_FRAMES && stats.nTypeMismatches < uint64( i ); ++n )
+                {
+                    graph.Update();
+                    OSCGetStats( nServer, stats );
+                }
+            }
+
+            OSC_CHECK( SDiagLog::nLines == 1 );
+        }
+
+        OSC_CHECK( stats.nTypeMismatches == uint64( nMessages ) );
+        OSC_CHECK( SDiagLog::nLines == 2 && SDiagLog::nRepeats == uint64( nMessages - 1 ) );
+
+        SetOSCLogHandler( NULL );
+        g_fOSCLogInterval = fInterval;
+    }
+
+    /**
+    * @brief Answers every message to its sender
+    */
+    struct SEchoHandler :
+        public IOSCMessageHandler
+    {
+        int nMessages;
+
+        SEchoHandler() : nMessages( 0 ) {}
+
+        void OnOSCMessage( int nConnection, const IOSCArgs& /* args */ )
+        {
+            char buffer[64];
+            oscpkt::PacketWriter pw;
+            oscpkt::Message msg( "/test/echo" );
+            pw.init().addMessage( msg );
+            memcpy( buffer, pw.packetData(), pw.packetSize() );
+            OSC_CHECK( OSCReplyPacket( nConnection, buffer, pw.packetSize() ) );
+            ++nMessages;
+        }
+    };
+
+    /**
+    * @brief Every peer that subscribed gets every packet exactly once, replies only go to the sender,
+    * and the peer table doesn't grow past osc_max_peers
+    */
+    void TestFanOut()
+    {
+        const int nPeers = 16;
+        CMockFlowGraph graph;
+        int nServer = graph.AddConnection( "127.0.0.1", TEST_PORT, OSCCT_UdpServer );
+        OSC_CHECK( GetConnection( nServer ).SetFanOut( true, 0 ) );
+
+        SEchoHandler handler;
+        OSCAddHandler( nServer, "/test/hello", &handler );
+
+        oscpkt::PacketWriter pw;
+        oscpkt::Message hello( "/test/hello" );
+        pw.init().addMessage( hello );
+        std::vector<IOSCTransport*> peers;
+        std::vector<std::string> datagrams;
+
+        for ( int i = 0; i < nPeers; ++i )
+        {
+            peers.push_back( CreateOSCTransport( OSCTT_Udp, OSCSF_Slip ) );
+            OSC_CHECK( peers.back()->Open( "127.0.0.1", TEST_PORT, false ) );
+            OSC_CHECK( peers.back()->SendPacket( pw.packetData(), pw.packetSize() ) );
+
+            for ( int n = 0; n < WAIT_FRAMES && handler.nMessages <= i; ++n )
+            {
+                graph.Update();
+            }
+
+            ReceiveDatagrams( peers[i], 1, datagrams );
+            OSC_CHECK( datagrams.size() == 1 );
+        }
+
+        // the answers only went to the peer that said hello
+        for ( int p = 0; p < nPeers; ++p )
+        {
+            ReceiveDatagrams( peers[p], 0, datagrams );
+            OSC_CHECK( datagrams.empty() );
+        }
+
+        OSC_CHECK( GetConnection( nServer ).GetPeerCount() == nPeers );
+
+        int nPacket = graph.AddPacket( nServer );
+        int nSlot = graph.AddSendValue( nServer, nPacket, graph.AddSendMessage( nServer, nPacket, "/test/fanout" ), OSCT_Int32 );
+
+        for ( int nFrame = 1; nFrame <= 3; ++nFrame )
+        {
+            graph.SetValue( nServer, nPacket, nSlot, nFrame );
+            graph.Update();
+
+            std::string sFirst;
+
+            for ( int p = 0; p < nPeers; ++p )
+            {
+                ReceiveDatagrams( peers[p], 1, datagrams );
+                OSC_CHECK( datagrams.size() == 1 );
+
+                std::vector<oscpkt::Message> messages = ReadMessages( datagrams[0] );
+                int nValue = 0;
+                OSC_CHECK( messages.size() == 1 && messages[0].addressPattern() == "/test/fanout" );
+                OSC_CHECK( messages[0].arg().popInt32( nValue ).isOkNoMoreArgs() && nValue == nFrame );
+                OSC_CHECK( p == 0 || datagrams[0] == sFirst );
+                sFirst = datagrams[0];
+            }
+        }
+
+        // a full table makes room for a new peer instead of growing
+        int nMaxPeers = g_nOSCMaxPeers;
+        g_nOSCMaxPeers = 4;
+        GetConnection( nServer ).SetFanOut( false, 0 );
+        GetConnection( nServer ).SetFanOut( true, 0 );
+
+        for ( int i = 0; i < 6; ++i )
+        {
+            OSC_CHECK( peers[i]->SendPacket( pw.packetData(), pw.packetSize() ) );
+        }
+
+        for ( int n = 0; n < WAIT_FRAMES && handler.nMessages < nPeers + 6; ++n )
+        {
+            graph.Update();
+        }
+
+        OSC_CHECK( handler.nMessages == nPeers + 6 );
+        OSC_CHECK( GetConnection( nServer ).GetPeerCount() == 4 );
+        g_nOSCMaxPeers = nMaxPeers;
+        OSCRemoveHandler( nServer, &handler );
+
+        for ( size_t i = 0; i < peers.size(); ++i )
+        {
+            peers[i]->Release();
+        }
+    }
+}
+
+int main( int /* argc */, char** /* argv */ )
+{
+    TestShm();
+    TestLoopback();
+    TestCaptureReplay();
+    TestRebind();
+    TestCoalesce();
+    TestSuppress();
+    TestTimeTag();
+    TestJitterBuffer();
+    TestDiagnostics();
+    TestFanOut();
+
+    printf( "OK it looks like everything works as expected!\n" );
+    return 0;
+}
@@ -0,0 +1,248 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+/**
+   Per value cost of the receive dispatch of the connection core (COSCConnection::Dispatch)
+   with the flow graph of every value resolved by id (GetGraphById on every value) compared
+   to the graph pointer cached at registration.
+
+   A client and a server connection in one process (in-process handover) move a bundle of
+   n messages with 16 float values each every frame, the server has all n messages registered
+   like the Receive:Message nodes do. The value sinks activate their output on a graph of a
+   mock flow system that keeps its graphs in a vector and searches it linearly like CryAction's
+   CFlowSystem::GetGraphById, once with the lookup per value and once with the cached pointer.
+   The time includes encoding, the handover and parsing, which both variants share.
+
+   build with cmake (CMakeLists.txt) or (Linux):
+
+   g++ -O2 -std=c++11 -Ibench -I. -Isrc -Iinc bench/osc_graph_lookup_bench.cc src/OSCConnection.cpp src/OSCCapture.cpp src/OSCTransport.cpp src/OSCTcpTransport.cpp src/OSCShmTransport.cpp src/OSCByteSwap.cpp src/OSCCoalescer.cpp src/OSCDiagnostics.cpp src/OSCJitterBuffer.cpp src/OSCPeerTable.cpp src/OSCSendScheduler.cpp src/OSCTrace.cpp -o osc_graph_lookup_bench -lpthread -lrt
+
+   usage: osc_graph_lookup_bench [graphs in the level, default 200] [registered messages, default 16]
+
+   returns nonzero if not every value arrived
+ */
+
+#include <osc_mock_flow.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace OSCMock;
+
+namespace
+{
+    typedef unsigned int TMockGraphId;
+
+    class IMockLevelGraph
+    {
+        public:
+            virtual ~IMockLevelGraph() {}
+            virtual TMockGraphId GetGraphId() const = 0;
+            virtual void ActivateOutput( int nNode, int nPort, float fValue ) = 0;
+    };
+
+    class CMockLevelGraph : public IMockLevelGraph
+    {
+            TMockGraphId m_nId;
+            std::vector<float> m_Outputs;
+
+        public:
+            int m_nActivations;
+
+            CMockLevelGraph( TMockGraphId nId, int nNodes ) : m_nId( nId ), m_Outputs( nNodes ), m_nActivations( 0 ) {}
+
+            TMockGraphId GetGraphId() const
+            {
+                return m_nId;
+            }
+
+            void ActivateOutput( int nNode, int /* nPort */, float fValue )
+            {
+                m_Outputs[nNode] = fValue;
+                ++m_nActivations;
+            }
+    };
+
+    class CMockFlowSystem
+    {
+            std::vector<IMockLevelGraph*> m_Graphs;
+
+        public:
+            ~CMockFlowSystem()
+            {
+                for ( size_t i = 0; i < m_Graphs.size(); ++i )
+                {
+                    delete m_Graphs[i];
+                }
+            }
+
+            IMockLevelGraph* CreateGraph( int nNodes )
+            {
+                m_Graphs.push_back( new CMockLevelGraph( TMockGraphId( m_Graphs.size() + 1 ), nNodes ) );
+                return m_Graphs.back();
+            }
+
+            IMockLevelGraph* GetGraphById( TMockGraphId nId ) const
+            {
+                for ( size_t i = 0; i < m_Graphs.size(); ++i )
+                {
+                    if ( m_Graphs[i]->GetGraphId() == nId )
+                    {
+                        return m_Graphs[i];
+                    }
+                }
+
+                return 0;
+            }
+    };
+
+    /**
+    * @brief Receive value node, resolves its graph by id on every value or uses the one cached at registration
+    */
+    class CGraphValueSink :
+        public IOSCValueSink
+    {
+            const CMockFlowSystem& m_FlowSystem;
+            TMockGraphId m_nGraph;
+            IMockLevelGraph* m_pGraph; //!< NULL to look it up by id
+            int m_nNode;
+
+        public:
+            CGraphValueSink( const CMockFlowSystem& flowSystem, IMockLevelGraph* pGraph, int nNode, bool bCached ) :
+                m_FlowSystem( flowSystem ),
+                m_nGraph( pGraph->GetGraphId() ),
+                m_pGraph( bCached ? pGraph : NULL ),
+                m_nNode( nNode )
+            {
+            }
+
+            ~CGraphValueSink()
+            {
+                InvalidateOSCValues( this );
+            }
+
+            void OnOSCValue( int /* nPort */, int /* nValue */ ) {}
+            void OnOSCValue( int /* nPort */, bool /* bValue */ ) {}
+            void OnOSCValue( int /* nPort */, const char* /* sValue */ ) {}
+
+            void OnOSCValue( int nPort, float fValue )
+            {
+                IMockLevelGraph* pGraph = m_pGraph ? m_pGraph : m_FlowSystem.GetGraphById( m_nGraph );
+                pGraph->ActivateOutput( m_nNode, nPort, fValue );
+            }
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    const int BENCH_PORT = 9350;
+    const int VALUES = 16; //!< per message
+    const int FRAMES = 2000;
+
+    /**
+    * @return ns per received value, negative if not every value arrived
+    */
+    double Run( CMockFlowSystem& flowSystem, int nGraphs, int nMessages, bool bCached )
+    {
+        // the OSC nodes live in a graph somewhere in the middle of the level
+        CMockLevelGraph* pLevelGraph = static_cast<CMockLevelGraph*>( flowSystem.GetGraphById( TMockGraphId( nGraphs / 2 + 1 ) ) );
+        pLevelGraph->m_nActivations = 0;
+
+        CMockFlowGraph graph;
+        int nServer = graph.AddConnection( "127.0.0.1", BENCH_PORT, OSCCT_UdpServer );
+        int nClient = graph.AddConnection( "127.0.0.1", BENCH_PORT, OSCCT_UdpClient );
+
+        if ( !OSCIsConnectionOk( nServer ) || !OSCIsConnectionOk( nClient ) )
+        {
+            fprintf( stderr, "open %d failed\n", BENCH_PORT );
+            return -1;
+        }
+
+        std::vector<CGraphValueSink*> sinks;
+        int nPacket = graph.AddPacket( nClient );
+        std::vector<int> slots;
+
+        // like the Send:Bundle node, several messages go out as one bundle
+        graph.GetPacket( nClient, nPacket ).AddBundleStart();
+
+        for ( int m = 0; m < nMessages; ++m )
+        {
+            char sAddress[32];
+            snprintf( sAddress, sizeof( sAddress ), "/bench/msg%d", m );
+
+            int nReceive = graph.AddReceiveMessage( nServer, sAddress );
+            int nSend = graph.AddSendMessage( nClient, nPacket, sAddress );
+
+            for ( int v = 0; v < VALUES; ++v )
+            {
+                sinks.push_back( new CGraphValueSink( flowSystem, pLevelGraph, int( sinks.size() ), bCached ) );
+                GetConnection( nServer ).GetReceiveMessage( nReceive ).AddValue( SOSCValueInfo( OSCT_Float32, sinks.back(), MOCK_PORT_VALUE ) );
+                slots.push_back( graph.AddSendValue( nClient, nPacket, nSend, OSCT_Float32 ) );
+            }
+        }
+
+        graph.GetPacket( nClient, nPacket ).AddBundleEnd();
+
+        Clock::time_point start = Clock::now();
+
+        for ( int nFrame = 1; nFrame <= FRAMES; ++nFrame )
+        {
+            COSCPacket& packet = graph.GetPacket( nClient, nPacket );
+
+            for ( size_t i = 0; i < slots.size(); ++i )
+            {
+                packet.SetValue( slots[i], float( nFrame ) + float( i ) * 0.5f );
+            }
+
+            packet.NotifyChange();
+            graph.Update();
+        }
+
+        Clock::time_point end = Clock::now();
+
+        for ( size_t i = 0; i < sinks.size(); ++i )
+        {
+            delete sinks[i];
+        }
+
+        double fValues = double( FRAMES ) * double( slots.size() );
+
+        if ( pLevelGraph->m_nActivations != int( fValues ) )
+        {
+            fprintf( stderr, "%d of %.0f values arrived\n", pLevelGraph->m_nActivations, fValues );
+            return -1;
+        }
+
+        return std::chrono::duration<double, std::nano>( end - start ).count() / fValues;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    int nGraphs = argc > 1 ? atoi( argv[1] ) : 200;
+    int nMessages = argc > 2 ? atoi( argv[2] ) : 16;
+
+    if ( nGraphs < 1 || nMessages < 1 )
+    {
+        fprintf( stderr, "usage: osc_graph_lookup_bench [graphs] [messages]\n" );
+        return 1;
+    }
+
+    CMockFlowSystem flowSystem;
+
+    for ( int i = 0; i < nGraphs; ++i )
+    {
+        flowSystem.CreateGraph( nMessages * VALUES );
+    }
+
+    double fById = Run( flowSystem, nGraphs, nMessages, false );
+    double fCached = Run( flowSystem, nGraphs, nMessages, true );
+
+    if ( fById < 0 || fCached < 0 )
+    {
+        return 1;
+    }
+
+    printf( "graphs %d, messages %d: GetGraphById %.2f ns/value, cached graph %.2f ns/value (%.1fx)\n",
+            nGraphs, nMessages, fById, fCached, fById / fCached );
+    return 0;
+}
@@ -0,0 +1,214 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+// Mock flow system for driving the connection core (src/OSCConnection.h) headless.
+// It makes the same registrations the Init chain of the flow nodes makes and
+// updates the connections once per frame like the Connection nodes do.
+
+#include <StdAfx.h>
+#include <OSCConnection.h>
+
+#include <algorithm>
+
+#include <string>
+#include <vector>
+
+namespace OSCMock
+{
+    using namespace OSCPlugin;
+
+    enum EMockPorts
+    {
+        MOCK_PORT_VALUE = 1, //!< same as EOP_VALUE of the receive value nodes
+        MOCK_PORT_EXACT, //!< text of 64 bit values
+        MOCK_PORTS,
+    };
+
+    struct SMockPortValue
+    {
+        int nActivations;
+        int nValue;
+        float fValue;
+        bool bValue;
+        std::string sValue;
+        uint64 nTime; //!< of the last activation, see GetOSCWallClockNs
+
+        SMockPortValue() : nActivations( 0 ), nValue( 0 ), fValue( 0 ), bValue( false ), nTime( 0 ) {}
+    };
+
+    /**
+    * @brief Receive value node, records what the core activates on its output ports
+    */
+    class CMockReceiveNode :
+        public IOSCValueSink
+    {
+            SMockPortValue m_Ports[MOCK_PORTS];
+
+            SMockPortValue& Activate( int nPort )
+            {
+                assert( nPort >= 0 && nPort < MOCK_PORTS );
+
+                SMockPortValue& port = m_Ports[nPort];
+                ++port.nActivations;
+                port.nTime = GetOSCWallClockNs();
+                return port;
+            }
+
+        public:
+            std::vector<uint32> m_Array; //!< for array types
+
+            ~CMockReceiveNode()
+            {
+                InvalidateOSCValues( this );
+            }
+
+            const SMockPortValue& GetPort( int nPort = MOCK_PORT_VALUE ) const
+            {
+                return m_Ports[nPort];
+            }
+
+            void OnOSCValue( int nPort, int nValue )
+            {
+                Activate( nPort ).nValue = nValue;
+            }
+
+            void OnOSCValue( int nPort, float fValue )
+            {
+                Activate( nPort ).fValue = fValue;
+            }
+
+            void OnOSCValue( int nPort, bool bValue )
+            {
+                Activate( nPort ).bValue = bValue;
+            }
+
+            void OnOSCValue( int nPort, const char* sValue )
+            {
+                Activate( nPort ).sValue = sValue;
+            }
+    };
+
+    /**
+    * @brief Owns the mock nodes and the connection handles of one "level"
+    */
+    class CMockFlowGraph
+    {
+            std::vector<CMockReceiveNode*> m_Nodes;
+            std::vector<int> m_Connections;
+            int64 m_nFrame;
+
+        public:
+            CMockFlowGraph() : m_nFrame( 0 ) {}
+
+            ~CMockFlowGraph()
+            {
+                for ( size_t i = 0; i < m_Nodes.size(); ++i )
+                {
+                    delete m_Nodes[i];
+                }
+
+                for ( size_t i = 0; i < m_Connections.size(); ++i )
+                {
+                    ReleaseOSCConnection( m_Connections[i] );
+                }
+            }
+
+            // Connection node
+            int AddConnection( const char* sHost, int nPort, EOSCConnectionType eType, int nFraming = 0 )
+            {
+                int nConnection = AcquireOSCConnection( MakeOSCConnectionKey( sHost, nPort, eType, nFraming ) );
+                m_Connections.push_back( nConnection );
+                return nConnection;
+            }
+
+            /**
+            * @brief Init of a connection node that is already connected, the chained nodes have to register again
+            * @return the handle, a new one if the connection couldn't be reused
+            */
+            int Reinit( int nConnection, const char* sHost, int nPort, EOSCConnectionType eType, int nFraming = 0 )
+            {
+                SOSCConnectionKey key = MakeOSCConnectionKey( sHost, nPort, eType, nFraming );
+
+                if ( RebindOSCConnection( nConnection, key ) )
+                {
+                    GetConnection( nConnection ).BeginRegistration( nConnection );
+                    return nConnection;
+                }
+
+                ReleaseOSCConnection( nConnection );
+                int nNew = AcquireOSCConnection( key );
+                std::replace( m_Connections.begin(), m_Connections.end(), nConnection, nNew );
+                return nNew;
+            }
+
+            /**
+            * @brief Host/port/type change of a connected node without Init
+            */
+            bool Rebind( int nConnection, const char* sHost, int nPort, EOSCConnectionType eType, int nFraming = 0 )
+            {
+                return RebindOSCConnection( nConnection, MakeOSCConnectionKey( sHost, nPort, eType, nFraming ) );
+            }
+
+            // Receive:Message and Receive:Value nodes
+            int AddReceiveMessage( int nConnection, const char* sAddress )
+            {
+                return GetConnection( nConnection ).AddReceiveMessage( sAddress, nConnection );
+            }
+
+            CMockReceiveNode* AddReceiveValue( int nConnection, int nMessage, eOSCType type )
+            {
+                CMockReceiveNode* pNode = new CMockReceiveNode();
+                m_Nodes.push_back( pNode );
+
+                bool bArray = type == OSCT_Float32Array || type == OSCT_Int32Array;
+                GetConnection( nConnection ).GetReceiveMessage( nMessage ).AddValue( SOSCValueInfo( type, pNode, MOCK_PORT_VALUE, bArray ? &pNode->m_Array : NULL ) );
+                return pNode;
+            }
+
+            // Send:Packet, Send:Message and Send:Value nodes
+            int AddPacket( int nConnection )
+            {
+                return GetConnection( nConnection ).AddPacket( nConnection );
+            }
+
+            COSCPacket& GetPacket( int nConnection, int nPacket )
+            {
+                return GetConnection( nConnection ).GetPacket( nPacket );
+            }
+
+            int AddSendMessage( int nConnection, int nPacket, const char* sAddress )
+            {
+                return GetPacket( nConnection, nPacket ).AddMessage( sAddress );
+            }
+
+            int AddSendValue( int nConnection, int nPacket, int nMessage, eOSCType type )
+            {
+                return GetPacket( nConnection, nPacket ).AddValue( nMessage, type );
+            }
+
+            /**
+            * @brief What a send value node does when its input port changes
+            */
+            template<typename T>
+            void SetValue( int nConnection, int nPacket, int nSlot, T value )
+            {
+                COSCPacket& packet = GetPacket( nConnection, nPacket );
+                packet.SetValue( nSlot, value );
+                packet.NotifyChange();
+            }
+
+            int64 GetFrame() const
+            {
+                return m_nFrame;
+            }
+
+            /**
+            * @brief One frame of the game loop
+            */
+            void Update()
+            {
+                OSCUpdateConnections( ++m_nFrame );
+            }
+    };
+}
@@ -0,0 +1,261 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+/**
+   Throughput and round trip latency of the plugin transports (UDP loopback,
+   TCP loopback and the shared memory ring) on one machine.
+
+   build with (Linux):
+
+   g++ -O2 -std=c++11 -Ibench -I. -Isrc bench/osc_transport_bench.cc src/OSCTransport.cpp src/OSCTcpTransport.cpp src/OSCShmTransport.cpp -o osc_transport_bench -lpthread -lrt
+
+   usage: osc_transport_bench [udp|tcp|shm ...]
+ */
+
+#include <StdAfx.h>
+#include <OSCTransport.h>
+#include <OSCShmTransport.h>
+#include <oscpkt/oscpkt.hh>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+
+using namespace OSCPlugin;
+
+namespace
+{
+    const int BENCH_PORT = 9310;
+    const int THROUGHPUT_PACKETS = 200000;
+    const int LATENCY_ROUNDS = 10000;
+
+    typedef std::chrono::steady_clock Clock;
+
+    double Seconds( Clock::duration d )
+    {
+        return std::chrono::duration<double>( d ).count();
+    }
+
+    struct STransportKind
+    {
+        const char* sName;
+        eOSCTransportType eType;
+    };
+
+    IOSCTransport* OpenTransport( eOSCTransportType eType, int nPort, bool bServer )
+    {
+        IOSCTransport* pTransport = CreateOSCTransport( eType, OSCSF_Slip );
+
+        if ( !pTransport->Open( "127.0.0.1", nPort, bServer ) )
+        {
+            fprintf( stderr, "open %d failed: %s\n", nPort, pTransport->GetErrorMessage().c_str() );
+        }
+
+        return pTransport;
+    }
+
+    std::vector<char> MakePacket( size_t nFloats, int nSeq )
+    {
+        oscpkt::Message msg( "/bench/values" );
+        msg.pushInt32( nSeq );
+
+        for ( size_t i = 0; i < nFloats; ++i )
+        {
+            msg.pushFloat( float( i ) );
+        }
+
+        oscpkt::PacketWriter pw;
+        pw.addMessage( msg );
+        return std::vector<char>( pw.packetData(), pw.packetData() + pw.packetSize() );
+    }
+
+    void RunThroughput( const STransportKind& kind, size_t nFloats )
+    {
+        IOSCTransport* pServer = OpenTransport( kind.eType, BENCH_PORT, true );
+        IOSCTransport* pClient = OpenTransport( kind.eType, BENCH_PORT, false );
+        std::vector<char> packet = MakePacket( nFloats, 0 );
+
+        std::atomic<bool> bDone( false );
+        int nReceived = 0;
+        Clock::time_point tLast = Clock::now();
+
+        std::thread consumer( [&]()
+        {
+            Clock::time_point tIdle = Clock::now();
+
+            while ( nReceived < THROUGHPUT_PACKETS )
+            {
+                if ( pServer->ReceiveNextPacket() )
+                {
+                    ++nReceived;
+                    tLast = tIdle = Clock::now();
+                }
+
+                else if ( bDone && Seconds( Clock::now() - tIdle ) > 0.5 )
+                {
+                    break; // the rest got lost
+                }
+
+                else
+                {
+                    pServer->WaitForPacket( 10 );
+                }
+            }
+        } );
+
+        Clock::time_point tStart = Clock::now();
+
+        for ( int i = 0; i < THROUGHPUT_PACKETS; ++i )
+        {
+            // the ring rejects packets when full, retry like a blocking send would
+            while ( !pClient->SendPacket( &packet[0], packet.size() ) && kind.eType == OSCTT_SharedMemory )
+            {
+                std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+            }
+
+            if ( ( i & 63 ) == 63 )
+            {
+                pClient->Flush();
+            }
+        }
+
+        while ( kind.eType == OSCTT_Tcp && pClient->IsOk() && nReceived < THROUGHPUT_PACKETS && Seconds( Clock::now() - tStart ) < 10.0 )
+        {
+            pClient->Flush();
+            std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+        }
+
+        bDone = true;
+        consumer.join();
+
+        double fSeconds = Seconds( tLast - tStart );
+        printf( "%-4s throughput %5zu bytes: %10.0f packets/s %8.1f MB/s loss %5.2f%%\n",
+                kind.sName, packet.size(), nReceived / fSeconds, nReceived * packet.size() / fSeconds / ( 1024.0 * 1024.0 ),
+                100.0 * ( THROUGHPUT_PACKETS - nReceived ) / THROUGHPUT_PACKETS );
+
+        pClient->Release();
+        pServer->Release();
+    }
+
+    bool ReceiveWait( IOSCTransport* pTransport, int nTimeoutMs )
+    {
+        Clock::time_point tStart = Clock::now();
+
+        while ( !pTransport->ReceiveNextPacket() )
+        {
+            if ( Seconds( Clock::now() - tStart ) * 1000 > nTimeoutMs )
+            {
+                return false;
+            }
+
+            pTransport->WaitForPacket( nTimeoutMs );
+        }
+
+        return true;
+    }
+
+    void RunLatency( const STransportKind& kind, size_t nFloats )
+    {
+        // ping goes out on BENCH_PORT, the echo comes back on BENCH_PORT + 1
+        IOSCTransport* pPongServer = OpenTransport( kind.eType, BENCH_PORT + 1, true );
+        std::atomic<bool> bReady( false );
+        std::atomic<bool> bStop( false );
+
+        std::thread echo( [&]()
+        {
+            IOSCTransport* pPingServer = OpenTransport( kind.eType, BENCH_PORT, true );
+            bReady = true;
+            IOSCTransport* pPongClient = OpenTransport( kind.eType, BENCH_PORT + 1, false );
+
+            while ( !bStop )
+            {
+                if ( ReceiveWait( pPingServer, 50 ) )
+                {
+                    pPongClient->SendPacket( pPingServer->GetPacketData(), pPingServer->GetPacketSize() );
+                    pPongClient->Flush();
+                }
+            }
+
+            pPongClient->Release();
+            pPingServer->Release();
+        } );
+
+        while ( !bReady )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+
+        IOSCTransport* pPingClient = OpenTransport( kind.eType, BENCH_PORT, false );
+        std::vector<char> packet = MakePacket( nFloats, 0 );
+        std::vector<double> rtt;
+        rtt.reserve( LATENCY_ROUNDS );
+        int nLost = 0;
+
+        for ( int i = 0; i < LATENCY_ROUNDS; ++i )
+        {
+            Clock::time_point tSend = Clock::now();
+            pPingClient->SendPacket( &packet[0], packet.size() );
+            pPingClient->Flush();
+
+            if ( ReceiveWait( pPongServer, 250 ) )
+            {
+                rtt.push_back( Seconds( Clock::now() - tSend ) * 1e6 );
+            }
+
+            else
+            {
+                ++nLost;
+            }
+        }
+
+        bStop = true;
+        echo.join();
+
+        std::sort( rtt.begin(), rtt.end() );
+
+        if ( !rtt.empty() )
+        {
+            printf( "%-4s latency    %5zu bytes: one way p50 %7.2f us p99 %7.2f us p99.9 %7.2f us (lost %d)\n",
+                    kind.sName, packet.size(), rtt[rtt.size() / 2] / 2, rtt[rtt.size() * 99 / 100] / 2, rtt[rtt.size() * 999 / 1000] / 2, nLost );
+        }
+
+        pPingClient->Release();
+        pPongServer->Release();
+    }
+}
+
+int main( int argc, char** argv )
+{
+    static const STransportKind kinds[] =
+    {
+        { "udp", OSCTT_Udp },
+        { "tcp", OSCTT_Tcp },
+        { "shm", OSCTT_SharedMemory },
+    };
+
+    static const size_t sizes[] = { 4, 64, 1000 };
+
+    for ( size_t k = 0; k < sizeof( kinds ) / sizeof( kinds[0] ); ++k )
+    {
+        bool bSelected = argc <= 1;
+
+        for ( int i = 1; i < argc; ++i )
+        {
+            bSelected |= strcmp( argv[i], kinds[k].sName ) == 0;
+        }
+
+        if ( !bSelected )
+        {
+            continue;
+        }
+
+        for ( size_t s = 0; s < sizeof( sizes ) / sizeof( sizes[0] ); ++s )
+        {
+            RunThroughput( kinds[k], sizes[s] );
+            RunLatency( kinds[k], sizes[s] );
+        }
+    }
+
+    return 0;
+}
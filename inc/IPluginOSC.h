@@ -9,6 +9,64 @@
 */
 namespace OSCPlugin
 {
+    /**
+    * @brief Connection types, same values as the nType port of the Connection node
+    */
+    enum EOSCConnectionType
+    {
+        OSCCT_UdpClient = 0,
+        OSCCT_UdpServer,
+        OSCCT_TcpClient,
+        OSCCT_TcpServer,
+        OSCCT_ShmClient,
+        OSCCT_ShmServer,
+    };
+
+    /**
+    * @brief Typed read access to the arguments of a received message.
+    * Arguments are read in place, pointers returned stay valid until the handler returns.
+    * Reading arguments in order is cheapest, random access is supported.
+    */
+    struct IOSCArgs
+    {
+        virtual const char* GetAddress() const = 0;
+
+        /**
+        * @brief OSC type tag of every argument, e.g. "ifs" for int32, float32, string
+        */
+        virtual const char* GetTypeTags() const = 0;
+        virtual int GetCount() const = 0;
+
+        /**
+        * @brief Timetag of the enclosing bundle, 1 (immediately) for messages outside of bundles
+        */
+        virtual uint64 GetTimeTag() const = 0;
+
+        /**
+        * @brief Typed accessors
+        * @return false if the argument doesn't exist or has another type
+        */
+        virtual bool GetInt32( int nArg, int32& nValue ) const = 0;
+        virtual bool GetInt64( int nArg, int64& nValue ) const = 0;
+        virtual bool GetFloat( int nArg, float& fValue ) const = 0;
+        virtual bool GetDouble( int nArg, double& fValue ) const = 0;
+        virtual bool GetBool( int nArg, bool& bValue ) const = 0;
+        virtual bool GetString( int nArg, const char*& sValue ) const = 0;
+        virtual bool GetBlob( int nArg, const void*& pData, size_t& nSize ) const = 0;
+    };
+
+    /**
+    * @brief Receives the messages of an address registered with IPluginOSC::AddHandler
+    */
+    struct IOSCMessageHandler
+    {
+        /**
+        * @brief Called on the main thread while the connection is updated
+        * @param nConnection handle the handler was registered with
+        */
+        virtual void OnOSCMessage( int nConnection, const IOSCArgs& args ) = 0;
+    };
+
     /**
     * @brief plugin OSC concrete interface
     */
@@ -19,6 +77,42 @@ namespace OSCPlugin
         */
         virtual PluginManager::IPluginBase* GetBase() = 0;
 
-        // TODO: Add your concrete interface declaration here
+        /**
+        * @brief Open a connection, shares the socket with Connection nodes and other users with the same settings
+        * @param nFraming packet framing for TCP: 0 SLIP, 1 int32 length prefix
+        * @return connection handle, valid until CloseConnection
+        */
+        virtual int OpenConnection( const char* sHost, int nPort, EOSCConnectionType eType, int nFraming = 0 ) = 0;
+
+        /**
+        * @brief Release a handle and remove its handlers, the socket is closed with its last user
+        */
+        virtual void CloseConnection( int nConnection ) = 0;
+
+        virtual bool IsConnectionOk( int nConnection ) = 0;
+
+        /**
+        * @brief Call pHandler for every received message matching sAddress (OSC address pattern)
+        */
+        virtual void AddHandler( int nConnection, const char* sAddress, IOSCMessageHandler* pHandler ) = 0;
+        virtual void RemoveHandler( int nConnection, IOSCMessageHandler* pHandler ) = 0;
+
+        /**
+        * @brief Send an encoded OSC packet (message or bundle, e.g. built with oscpkt::PacketWriter).
+        * UDP sends right away, stream transports transmit on the next update of the connection.
+        */
+        virtual bool SendPacket( int nConnection, const void* pData, size_t nSize ) = 0;
+
+        /**
+        * @brief Send an encoded OSC packet only to whoever sent the message being handled, call it from IOSCMessageHandler::OnOSCMessage.
+        * For server connections with bFanOut, where SendPacket goes to every peer.
+        */
+        virtual bool ReplyPacket( int nConnection, const void* pData, size_t nSize ) = 0;
+
+        /**
+        * @brief Receive and send on all open connections.
+        * Connection nodes do this every frame, call it from your update if you don't use one. Runs at most once per frame.
+        */
+        virtual void UpdateConnections() = 0;
     };
-};
\ No newline at end of file
+};
@@ -234,6 +234,7 @@ public:
       if (e != OK_NO_ERROR && err == OK_NO_ERROR) err=e; 
     }
     ArgReader(const ArgReader &other) : msg(other.msg), err(other.err), arg_idx(other.arg_idx) {}
+    ArgReader &operator=(const ArgReader &other) { msg = other.msg; err = other.err; arg_idx = other.arg_idx; return *this; }
     bool isBool() { return currentTypeTag() == TYPE_TAG_TRUE || currentTypeTag() == TYPE_TAG_FALSE; }
     bool isInt32() { return currentTypeTag() == TYPE_TAG_INT32; }
     bool isInt64() { return currentTypeTag() == TYPE_TAG_INT64; }
@@ -265,6 +266,14 @@ public:
       }
       return *this;
     }
+    /** retrieve a string argument without copying it, the pointer stays valid as long as the message */
+    ArgReader &popStr(const char *&s) {
+      s = "";
+      if (precheck(TYPE_TAG_STRING)) {
+        s = argBeg(arg_idx++);
+      }
+      return *this;
+    }
     /** retrieve a binary blob */
     ArgReader &popBlob(std::vector<char> &b) { 
       if (precheck(TYPE_TAG_BLOB)) {
@@ -273,6 +282,16 @@ public:
       }
       return *this;
     }
+    /** retrieve a binary blob without copying it, the pointer stays valid as long as the message */
+    ArgReader &popBlob(const void *&ptr, size_t &num_bytes) { 
+      ptr = 0; num_bytes = 0;
+      if (precheck(TYPE_TAG_BLOB)) {
+        ptr = argBeg(arg_idx)+4;
+        num_bytes = argEnd(arg_idx) - argBeg(arg_idx) - 4;
+        ++arg_idx;
+      }
+      return *this;
+    }
     /** retrieve a boolean argument */
     ArgReader &popBool(bool &b) {
       b = false;
@@ -415,6 +434,15 @@ public:
       memcpy(storage.getBytes(num_bytes), ptr, num_bytes);
     return *this;
   }
+  /** add a blob of num_bytes and return its (zero filled) content so it can be written in place.
+      The pointer is only valid until the next push. */
+  char *pushBlobUninitialized(size_t num_bytes) {
+    assert(num_bytes < 2147483647); // insane values are not welcome
+    type_tags += TYPE_TAG_BLOB; 
+    arguments.push_back(std::make_pair(storage.size(), num_bytes+4));
+    pod2bytes<int32_t>((int32_t)num_bytes, storage.getBytes(4));
+    return num_bytes ? storage.getBytes(num_bytes) : 0;
+  }
 
   /** reset the message to a clean state */
   void clear() { 
@@ -0,0 +1,267 @@
+/**
+   Microbenchmarks for oscpkt: encoding, decoding, nested bundles, address
+   pattern matching and blobs/strings of different sizes.
+
+   Every workload reports ns/op, ops/s and the heap allocations per op
+   (counted by replacing the global operator new).
+
+   build with:
+
+   g++ -O2 -Wall -W -I. oscpkt/oscpkt_bench.cc -o oscpkt_bench
+   cl.exe /O2 /EHsc /I. oscpkt/oscpkt_bench.cc
+
+   usage: oscpkt_bench [--json] [workload name filter]
+
+   --json prints one JSON object per line instead of the table, to track
+   results over time.
+ */
+
+#include "oscpkt.hh"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) || defined(WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+using namespace oscpkt;
+
+/* allocation counting, the benchmark is single threaded */
+static size_t g_allocs = 0;
+static size_t g_alloc_bytes = 0;
+
+/* not inlined, gcc would flag free() on memory from operator new as a mismatch */
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+void *operator new(size_t sz) {
+  ++g_allocs; g_alloc_bytes += sz;
+  void *p = malloc(sz ? sz : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void *operator new[](size_t sz) {
+  ++g_allocs; g_alloc_bytes += sz;
+  void *p = malloc(sz ? sz : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+BENCH_NOINLINE void operator delete(void *p) throw() { free(p); }
+BENCH_NOINLINE void operator delete[](void *p) throw() { free(p); }
+#if __cplusplus >= 201402L
+BENCH_NOINLINE void operator delete(void *p, size_t) throw() { free(p); }
+BENCH_NOINLINE void operator delete[](void *p, size_t) throw() { free(p); }
+#endif
+
+static double nowSeconds() {
+#if defined(_MSC_VER) || defined(WIN32)
+  LARGE_INTEGER f, c;
+  QueryPerformanceFrequency(&f); QueryPerformanceCounter(&c);
+  return double(c.QuadPart) / double(f.QuadPart);
+#else
+  timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+/* keeps the optimizer from dropping the work */
+static volatile size_t g_sink = 0;
+
+struct Workload {
+  const char *name;
+  virtual ~Workload() {}
+  virtual void setup() {}
+  /* one operation */
+  virtual void run() = 0;
+};
+
+/* --- encode --- */
+
+struct EncodeSmall : Workload {
+  Message msg; PacketWriter pw;
+  EncodeSmall() { name = "encode_message"; }
+  void run() {
+    msg.init("/synth/1/freq").pushInt32(42).pushFloat(440.f).pushStr("sine");
+    pw.init().addMessage(msg);
+    g_sink += pw.packetSize();
+  }
+};
+
+struct EncodeNested : Workload {
+  Message msg; PacketWriter pw;
+  EncodeNested() { name = "encode_nested_bundles"; }
+  void run() {
+    /* 3 levels, 8 messages */
+    pw.init().startBundle();
+    for (int i = 0; i < 2; ++i) {
+      pw.startBundle();
+      for (int j = 0; j < 2; ++j) {
+        pw.startBundle();
+        pw.addMessage(msg.init("/a/b").pushInt32(i).pushFloat(1.f));
+        pw.addMessage(msg.init("/a/c").pushInt32(j).pushFloat(2.f));
+        pw.endBundle();
+      }
+      pw.endBundle();
+    }
+    pw.endBundle();
+    g_sink += pw.packetSize();
+  }
+};
+
+/* --- decode --- */
+
+struct DecodeSmall : Workload {
+  PacketWriter pw; PacketReader pr;
+  DecodeSmall() { name = "decode_message"; }
+  void setup() {
+    Message msg("/synth/1/freq"); msg.pushInt32(42).pushFloat(440.f).pushStr("sine");
+    pw.init().addMessage(msg);
+  }
+  void run() {
+    pr.init(pw.packetData(), pw.packetSize());
+    Message *msg = pr.popMessage();
+    int32_t i; float f; std::string s;
+    msg->arg().popInt32(i).popFloat(f).popStr(s);
+    g_sink += i + s.size();
+  }
+};
+
+struct DecodeNested : Workload {
+  EncodeNested enc; PacketReader pr;
+  DecodeNested() { name = "decode_nested_bundles"; }
+  void setup() { enc.run(); }
+  void run() {
+    pr.init(enc.pw.packetData(), enc.pw.packetSize());
+    Message *msg;
+    while (pr.isOk() && (msg = pr.popMessage()) != 0) {
+      int32_t i; float f;
+      msg->arg().popInt32(i).popFloat(f);
+      g_sink += i;
+    }
+  }
+};
+
+/* --- pattern matching --- */
+
+struct Match : Workload {
+  std::string pattern, path;
+  Match(const char *n, const char *pat, const char *p) : pattern(pat), path(p) { name = n; }
+  void run() { g_sink += fullPatternMatch(pattern, path); }
+};
+
+struct MessageMatch : Workload {
+  Message msg; std::string pattern;
+  MessageMatch() : msg("/synth/voice/1/freq"), pattern("/synth/voice/*/freq") { name = "match_message"; }
+  void run() { g_sink += msg.match(pattern).isOk(); }
+};
+
+/* --- blobs and strings --- */
+
+struct BlobRoundTrip : Workload {
+  std::vector<char> data, out; Message msg; PacketWriter pw; PacketReader pr;
+  char label[32];
+  BlobRoundTrip(size_t sz) : data(sz, 'x') {
+    sprintf(label, "blob_%u", unsigned(sz)); name = label;
+  }
+  void run() {
+    msg.init("/blob").pushBlob(&data[0], data.size());
+    pw.init().addMessage(msg);
+    pr.init(pw.packetData(), pw.packetSize());
+    pr.popMessage()->arg().popBlob(out);
+    g_sink += out.size();
+  }
+};
+
+struct StringRoundTrip : Workload {
+  std::string data, out; Message msg; PacketWriter pw; PacketReader pr;
+  char label[32];
+  StringRoundTrip(size_t sz) : data(sz, 'x') {
+    sprintf(label, "string_%u", unsigned(sz)); name = label;
+  }
+  void run() {
+    msg.init("/str").pushStr(data);
+    pw.init().addMessage(msg);
+    pr.init(pw.packetData(), pw.packetSize());
+    pr.popMessage()->arg().popStr(out);
+    g_sink += out.size();
+  }
+};
+
+struct Result {
+  double ns_per_op, ops_per_sec, allocs_per_op, bytes_per_op;
+  size_t iterations;
+};
+
+static Result measure(Workload &w) {
+  w.setup();
+  for (int i = 0; i < 1000; ++i) w.run(); /* warm up, grows the reused buffers */
+
+  Result r;
+  size_t batch = 1000, n = 0;
+  size_t allocs0 = g_allocs, bytes0 = g_alloc_bytes;
+  double t0 = nowSeconds(), t1 = t0;
+  while (t1 - t0 < 0.25) {
+    for (size_t i = 0; i < batch; ++i) w.run();
+    n += batch;
+    t1 = nowSeconds();
+  }
+  r.iterations = n;
+  r.ns_per_op = (t1 - t0) * 1e9 / double(n);
+  r.ops_per_sec = double(n) / (t1 - t0);
+  r.allocs_per_op = double(g_allocs - allocs0) / double(n);
+  r.bytes_per_op = double(g_alloc_bytes - bytes0) / double(n);
+  return r;
+}
+
+int main(int argc, char **argv) {
+  bool json = false;
+  const char *filter = 0;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--json") == 0) json = true;
+    else filter = argv[i];
+  }
+
+  std::vector<Workload*> workloads;
+  workloads.push_back(new EncodeSmall());
+  workloads.push_back(new EncodeNested());
+  workloads.push_back(new DecodeSmall());
+  workloads.push_back(new DecodeNested());
+  workloads.push_back(new Match("match_literal", "/synth/voice/1/freq", "/synth/voice/1/freq"));
+  workloads.push_back(new Match("match_wildcard", "/synth/*/[0-9]/fr?q", "/synth/voice/1/freq"));
+  workloads.push_back(new Match("match_alternatives", "/synth/{bass,lead,voice}/1/freq", "/synth/voice/1/freq"));
+  workloads.push_back(new MessageMatch());
+  workloads.push_back(new BlobRoundTrip(16));
+  workloads.push_back(new BlobRoundTrip(1024));
+  workloads.push_back(new BlobRoundTrip(65536));
+  workloads.push_back(new StringRoundTrip(8));
+  workloads.push_back(new StringRoundTrip(256));
+  workloads.push_back(new StringRoundTrip(4096));
+
+  if (!json) {
+    printf("%-24s %12s %14s %10s %12s\n", "workload", "ns/op", "ops/s", "allocs/op", "bytes/op");
+  }
+
+  for (size_t i = 0; i < workloads.size(); ++i) {
+    Workload &w = *workloads[i];
+    if (filter && !strstr(w.name, filter)) continue;
+    Result r = measure(w);
+    if (json) {
+      printf("{\"workload\":\"%s\",\"ns_per_op\":%.2f,\"ops_per_sec\":%.0f,\"allocs_per_op\":%.3f,\"bytes_per_op\":%.1f,\"iterations\":%lu}\n",
+             w.name, r.ns_per_op, r.ops_per_sec, r.allocs_per_op, r.bytes_per_op, (unsigned long)r.iterations);
+    } else {
+      printf("%-24s %12.1f %14.0f %10.2f %12.1f\n", w.name, r.ns_per_op, r.ops_per_sec, r.allocs_per_op, r.bytes_per_op);
+    }
+  }
+
+  for (size_t i = 0; i < workloads.size(); ++i) delete workloads[i];
+  return g_sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,411 @@
+/**
+   Load generator and round trip latency tool for OSC over UDP, to size
+   hardware and SO_RCVBUF against the plugin's server connections (or any
+   other OSC server).
+
+   build with (Linux):
+
+   g++ -O2 -std=c++11 -Wall -W -I. oscpkt/oscpkt_load.cc -o oscpkt_load -lpthread
+
+   usage: oscpkt_load send|ping|recv|echo [options]
+
+   send   sends the message mix to host:port at the target rate
+   recv   listens on port, reports throughput, loss and reordering every second
+   echo   listens on port and sends every packet back to its origin
+   ping   like send, measures round trip latency through an echo peer
+
+   --host h        target host (default localhost)
+   --port p        target / listen port (default 9109)
+   --rate n        packets per second per socket, 0 as fast as possible (default 1000)
+   --sockets n     concurrent sending sockets, one thread each (default 1)
+   --duration s    seconds to run, 0 until killed (default 10 for send/ping, 0 for recv/echo)
+   --mix spec      comma separated messages, address:types*weight (default "/load:fff")
+                   types: i int32, h int64, f float, d double, s string, b blob, T true
+                   e.g. "/pos:fff*8,/name:s,/frame:b" sends 8 /pos for every /name and /frame
+   --string n      length of string arguments (default 16)
+   --blob n        size of blob arguments (default 64)
+   --messages n    messages per packet (default 1)
+   --bundle n      bundle nesting depth, 0 sends bare messages if --messages is 1 (default 0)
+   --rcvbuf n      SO_RCVBUF of the recv/echo socket in bytes
+
+   Pacing sleeps until 200us before each send and spins the rest, so every
+   sending socket keeps one core busy at high rates.
+
+   The first message of every packet starts with three extra arguments:
+   int32 stream id, int64 sequence number, int64 send time (monotonic ns).
+   recv uses them to count loss and reordering per stream, ping to compute
+   the round trip time of the echoed packets.
+ */
+
+#include "oscpkt/oscpkt.hh"
+#include "oscpkt/udp.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace oscpkt;
+
+static uint64_t nowNs() {
+  timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000u + ts.tv_nsec;
+}
+
+struct MixEntry {
+  std::string address;
+  std::string types;
+  int weight;
+};
+
+struct Options {
+  std::string mode;
+  std::string host;
+  int port;
+  double rate;
+  int sockets;
+  double duration;
+  std::vector<MixEntry> mix;
+  size_t string_size;
+  size_t blob_size;
+  int messages;
+  int bundle;
+  int rcvbuf;
+
+  Options() : host("localhost"), port(9109), rate(1000), sockets(1), duration(-1),
+              string_size(16), blob_size(64), messages(1), bundle(0), rcvbuf(0) {}
+};
+
+static bool parseMix(const std::string &spec, std::vector<MixEntry> &mix) {
+  size_t pos = 0;
+  while (pos < spec.size()) {
+    size_t end = spec.find(',', pos);
+    if (end == std::string::npos) end = spec.size();
+    std::string item = spec.substr(pos, end - pos);
+    pos = end + 1;
+
+    MixEntry e; e.weight = 1;
+    size_t star = item.find('*');
+    if (star != std::string::npos) { e.weight = atoi(item.c_str() + star + 1); item.resize(star); }
+    size_t colon = item.find(':');
+    e.address = item.substr(0, colon);
+    if (colon != std::string::npos) e.types = item.substr(colon + 1);
+    if (e.address.empty() || e.address[0] != '/' || e.weight <= 0) return false;
+    if (e.types.find_first_not_of("ihfdsbT") != std::string::npos) return false;
+    mix.push_back(e);
+  }
+  return !mix.empty();
+}
+
+/* builds the packets of one sending socket, nothing is allocated once the buffers have grown */
+class PacketBuilder {
+  const Options &opt;
+  std::vector<int> schedule; /* index into opt.mix, every entry repeated by its weight */
+  size_t next;
+  std::string str;
+  std::vector<char> blob;
+  Message msg;
+public:
+  PacketWriter pw;
+
+  PacketBuilder(const Options &o) : opt(o), next(0), str(o.string_size, 'x'), blob(o.blob_size, 7) {
+    for (size_t i = 0; i < opt.mix.size(); ++i) {
+      for (int w = 0; w < opt.mix[i].weight; ++w) schedule.push_back(int(i));
+    }
+  }
+
+  void build(int32_t stream, int64_t seq) {
+    pw.init();
+    for (int b = 0; b < opt.bundle; ++b) pw.startBundle();
+    for (int m = 0; m < opt.messages; ++m) {
+      const MixEntry &e = opt.mix[schedule[next]];
+      next = (next + 1) % schedule.size();
+      msg.init(e.address);
+      if (m == 0) msg.pushInt32(stream).pushInt64(seq).pushInt64(int64_t(nowNs()));
+      for (size_t t = 0; t < e.types.size(); ++t) {
+        switch (e.types[t]) {
+          case 'i': msg.pushInt32(int32_t(seq)); break;
+          case 'h': msg.pushInt64(seq); break;
+          case 'f': msg.pushFloat(float(seq) * 0.5f); break;
+          case 'd': msg.pushDouble(double(seq) * 0.5); break;
+          case 's': msg.pushStr(str); break;
+          case 'b': msg.pushBlob(blob.empty() ? 0 : &blob[0], blob.size()); break;
+          case 'T': msg.pushBool(true); break;
+        }
+      }
+      pw.addMessage(msg);
+    }
+    for (int b = 0; b < opt.bundle; ++b) pw.endBundle();
+  }
+};
+
+/* header of the first message, false if the packet wasn't sent by this tool */
+static bool readHeader(PacketReader &pr, int32_t &stream, int64_t &seq, int64_t &sent) {
+  Message *msg = pr.popMessage();
+  return msg && msg->arg().popInt32(stream).popInt64(seq).popInt64(sent).isOk();
+}
+
+static uint64_t percentile(const std::vector<uint64_t> &sorted, double p) {
+  if (sorted.empty()) return 0;
+  size_t i = size_t(p / 100.0 * double(sorted.size() - 1) + 0.5);
+  return sorted[std::min(i, sorted.size() - 1)];
+}
+
+/* UdpSocket::receiveNextPacket allocates per packet, too slow to keep up with the replies at high rates */
+static bool receiveReply(int handle, int timeout_ms, std::vector<char> &buf, size_t &size) {
+  pollfd pfd; pfd.fd = handle; pfd.events = POLLIN;
+  if (timeout_ms > 0 && poll(&pfd, 1, timeout_ms) <= 0) return false;
+  ssize_t n = recv(handle, &buf[0], buf.size(), MSG_DONTWAIT);
+  if (n <= 0) return false;
+  size = size_t(n);
+  return true;
+}
+
+struct SenderResult {
+  uint64_t sent, failed, bytes;
+  std::vector<uint64_t> rtt; /* ns, ping only */
+  SenderResult() : sent(0), failed(0), bytes(0) {}
+};
+
+static void runSender(const Options &opt, int index, SenderResult &res) {
+  UdpSocket sock;
+  sock.connectTo(opt.host, opt.port);
+  if (!sock.isOk()) {
+    fprintf(stderr, "socket %d: error connecting to %s:%d: %s\n", index, opt.host.c_str(), opt.port, sock.errorMessage().c_str());
+    return;
+  }
+
+  bool ping = opt.mode == "ping";
+  std::vector<char> reply(65536);
+  size_t reply_size = 0;
+  int32_t stream = int32_t((getpid() << 8) ^ index ^ int32_t(nowNs()));
+  PacketBuilder builder(opt);
+  if (ping) res.rtt.reserve(size_t(std::min(opt.rate > 0 ? opt.rate * opt.duration : 1e6, 1e7)));
+
+  uint64_t period = opt.rate > 0 ? uint64_t(1e9 / opt.rate) : 0;
+  uint64_t start = nowNs();
+  uint64_t end = start + uint64_t(opt.duration * 1e9);
+  uint64_t drain = ping ? 200000000u : 0; /* wait for the replies still in flight */
+
+  for (int64_t seq = 0; sock.isOk(); ++seq) {
+    uint64_t due = start + uint64_t(seq) * period;
+    if ((period ? due : nowNs()) >= end) break;
+
+    /* coarse wait in select (which also picks up replies), the last 200us are spun for precise pacing */
+    for (uint64_t now = nowNs(); now < due; now = nowNs()) {
+      uint64_t left = due - now;
+      if (receiveReply(sock.socketHandle(), left > 1200000 ? int((left - 200000) / 1000000) : 0, reply, reply_size) && ping) {
+        PacketReader pr(&reply[0], reply_size);
+        int32_t s; int64_t q, t;
+        if (readHeader(pr, s, q, t) && s == stream) res.rtt.push_back(nowNs() - uint64_t(t));
+      }
+    }
+
+    builder.build(stream, seq);
+    if (sock.sendPacket(builder.pw.packetData(), builder.pw.packetSize())) {
+      ++res.sent; res.bytes += builder.pw.packetSize();
+    } else {
+      ++res.failed;
+    }
+
+    if (ping && period == 0) {
+      /* as fast as possible: one packet in flight */
+      if (receiveReply(sock.socketHandle(), 1000, reply, reply_size)) {
+        PacketReader pr(&reply[0], reply_size);
+        int32_t s; int64_t q, t;
+        if (readHeader(pr, s, q, t) && s == stream) res.rtt.push_back(nowNs() - uint64_t(t));
+      }
+    }
+  }
+
+  for (uint64_t stop = nowNs() + drain; ping && nowNs() < stop; ) {
+    if (receiveReply(sock.socketHandle(), 10, reply, reply_size)) {
+      PacketReader pr(&reply[0], reply_size);
+      int32_t s; int64_t q, t;
+      if (readHeader(pr, s, q, t) && s == stream) res.rtt.push_back(nowNs() - uint64_t(t));
+    }
+  }
+}
+
+static int runSend(const Options &opt) {
+  std::vector<SenderResult> results(opt.sockets);
+  std::vector<std::thread> threads;
+  uint64_t start = nowNs();
+  for (int i = 0; i < opt.sockets; ++i) threads.push_back(std::thread(runSender, std::cref(opt), i, std::ref(results[i])));
+  for (size_t i = 0; i < threads.size(); ++i) threads[i].join();
+  double seconds = double(nowNs() - start) * 1e-9;
+
+  SenderResult total;
+  for (size_t i = 0; i < results.size(); ++i) {
+    total.sent += results[i].sent; total.failed += results[i].failed; total.bytes += results[i].bytes;
+    total.rtt.insert(total.rtt.end(), results[i].rtt.begin(), results[i].rtt.end());
+  }
+
+  printf("sent %llu packets (%llu failed) in %.2f s: %.0f packets/s %.2f MB/s, %.0f bytes/packet\n",
+         (unsigned long long)total.sent, (unsigned long long)total.failed, seconds,
+         total.sent / seconds, total.bytes / seconds / 1e6, total.sent ? double(total.bytes) / total.sent : 0.0);
+
+  if (opt.mode == "ping") {
+    std::sort(total.rtt.begin(), total.rtt.end());
+    printf("round trip %llu replies (%.2f%% lost): p50 %.1f us p99 %.1f us p99.9 %.1f us max %.1f us\n",
+           (unsigned long long)total.rtt.size(), total.sent ? 100.0 * (1.0 - double(total.rtt.size()) / total.sent) : 0.0,
+           percentile(total.rtt, 50) / 1000.0, percentile(total.rtt, 99) / 1000.0,
+           percentile(total.rtt, 99.9) / 1000.0, (total.rtt.empty() ? 0 : total.rtt.back()) / 1000.0);
+  }
+  return total.sent ? 0 : 1;
+}
+
+struct StreamState {
+  int64_t max_seq;
+  uint64_t received;
+  uint64_t reordered; /* arrived after a packet with a higher sequence number */
+  StreamState() : max_seq(-1), received(0), reordered(0) {}
+  uint64_t lost() const { return uint64_t(max_seq + 1) > received ? uint64_t(max_seq + 1) - received : 0; }
+};
+
+static int runReceiver(const Options &opt) {
+  UdpSocket sock;
+  sock.bindTo(opt.port);
+  if (!sock.isOk()) {
+    fprintf(stderr, "error opening port %d: %s\n", opt.port, sock.errorMessage().c_str());
+    return 1;
+  }
+
+  if (opt.rcvbuf > 0 && setsockopt(sock.socketHandle(), SOL_SOCKET, SO_RCVBUF, &opt.rcvbuf, sizeof opt.rcvbuf) != 0) {
+    fprintf(stderr, "SO_RCVBUF %d: %s\n", opt.rcvbuf, strerror(errno));
+  }
+  int rcvbuf = 0; socklen_t len = sizeof rcvbuf;
+  getsockopt(sock.socketHandle(), SOL_SOCKET, SO_RCVBUF, &rcvbuf, &len);
+
+  bool echo = opt.mode == "echo";
+  printf("%s on port %d, SO_RCVBUF %d bytes\n", echo ? "echoing" : "receiving", opt.port, rcvbuf);
+  fflush(stdout);
+
+  std::map<int32_t, StreamState> streams;
+  uint64_t packets = 0, messages = 0, bytes = 0, foreign = 0;
+  uint64_t last_packets = 0, last_messages = 0, last_bytes = 0, last_lost = 0, last_reordered = 0;
+  uint64_t start = nowNs(), last = start;
+  uint64_t end = opt.duration > 0 ? start + uint64_t(opt.duration * 1e9) : 0;
+
+  /* batches of datagrams straight from the socket (recvmmsg) so the tool keeps up with more than the peers it measures */
+  enum { BATCH = 64, MAX_DATAGRAM = 65536 };
+  std::vector<char> storage(BATCH * MAX_DATAGRAM);
+  std::vector<mmsghdr> msgs(BATCH);
+  std::vector<iovec> iov(BATCH);
+  std::vector<sockaddr_storage> origins(BATCH);
+  pollfd pfd; pfd.fd = sock.socketHandle(); pfd.events = POLLIN;
+
+  while (!end || nowNs() < end) {
+    for (int i = 0; i < BATCH; ++i) {
+      iov[i].iov_base = &storage[size_t(i) * MAX_DATAGRAM]; iov[i].iov_len = MAX_DATAGRAM;
+      memset(&msgs[i].msg_hdr, 0, sizeof msgs[i].msg_hdr);
+      msgs[i].msg_hdr.msg_iov = &iov[i]; msgs[i].msg_hdr.msg_iovlen = 1;
+      msgs[i].msg_hdr.msg_name = &origins[i]; msgs[i].msg_hdr.msg_namelen = sizeof origins[i];
+    }
+
+    int n = poll(&pfd, 1, 100) > 0 ? recvmmsg(pfd.fd, &msgs[0], BATCH, MSG_DONTWAIT, 0) : 0;
+    if (n < 0 && errno != EAGAIN && errno != EINTR) {
+      fprintf(stderr, "receive error: %s\n", strerror(errno));
+      return 1;
+    }
+
+    for (int i = 0; i < n; ++i) {
+      const char *data = (const char*)iov[i].iov_base;
+      size_t size = msgs[i].msg_len;
+      ++packets; bytes += size;
+      if (echo) sendto(pfd.fd, data, size, 0, (sockaddr*)&origins[i], msgs[i].msg_hdr.msg_namelen);
+
+      PacketReader pr(data, size);
+      int32_t stream; int64_t seq, sent;
+      if (readHeader(pr, stream, seq, sent)) {
+        StreamState &s = streams[stream];
+        ++s.received;
+        if (seq < s.max_seq) ++s.reordered;
+        else s.max_seq = seq;
+        ++messages;
+        while (pr.isOk() && pr.popMessage()) ++messages;
+      } else {
+        ++foreign;
+      }
+    }
+
+    uint64_t now = nowNs();
+    if (now - last >= 1000000000u) {
+      uint64_t lost = 0, reordered = 0;
+      for (std::map<int32_t, StreamState>::const_iterator it = streams.begin(); it != streams.end(); ++it) {
+        lost += it->second.lost(); reordered += it->second.reordered;
+      }
+      double s = double(now - last) * 1e-9;
+      printf("%8.0f packets/s %9.0f messages/s %7.2f MB/s lost %llu reordered %llu (%zu streams)\n",
+             (packets - last_packets) / s, (messages - last_messages) / s, (bytes - last_bytes) / s / 1e6,
+             (unsigned long long)(lost - last_lost), (unsigned long long)(reordered - last_reordered), streams.size());
+      fflush(stdout);
+      last = now; last_packets = packets; last_messages = messages; last_bytes = bytes; last_lost = lost; last_reordered = reordered;
+    }
+  }
+
+  uint64_t lost = 0, reordered = 0;
+  for (std::map<int32_t, StreamState>::const_iterator it = streams.begin(); it != streams.end(); ++it) {
+    lost += it->second.lost(); reordered += it->second.reordered;
+  }
+  double seconds = double(nowNs() - start) * 1e-9;
+  printf("received %llu packets %llu messages in %.2f s: %.0f packets/s, lost %llu (%.3f%%) reordered %llu, %llu packets from other senders\n",
+         (unsigned long long)packets, (unsigned long long)messages, seconds, packets / seconds,
+         (unsigned long long)lost, packets + lost ? 100.0 * lost / double(packets + lost) : 0.0,
+         (unsigned long long)reordered, (unsigned long long)foreign);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  Options opt;
+  std::string mix = "/load:fff";
+  if (argc > 1) opt.mode = argv[1];
+
+  for (int i = 2; i < argc; ++i) {
+    std::string a = argv[i];
+    const char *v = i + 1 < argc ? argv[i + 1] : 0;
+    if (!v) { opt.mode.clear(); break; }
+    if (a == "--host") opt.host = v;
+    else if (a == "--port") opt.port = atoi(v);
+    else if (a == "--rate") opt.rate = atof(v);
+    else if (a == "--sockets") opt.sockets = std::max(1, atoi(v));
+    else if (a == "--duration") opt.duration = atof(v);
+    else if (a == "--mix") mix = v;
+    else if (a == "--string") opt.string_size = size_t(atoi(v));
+    else if (a == "--blob") opt.blob_size = size_t(atoi(v));
+    else if (a == "--messages") opt.messages = std::max(1, atoi(v));
+    else if (a == "--bundle") opt.bundle = std::max(0, atoi(v));
+    else if (a == "--rcvbuf") opt.rcvbuf = atoi(v);
+    else { opt.mode.clear(); break; }
+    ++i;
+  }
+
+  if (!parseMix(mix, opt.mix)) {
+    fprintf(stderr, "bad --mix \"%s\"\n", mix.c_str());
+    return 1;
+  }
+  if (opt.messages > 1 && opt.bundle == 0) opt.bundle = 1; /* several messages need a bundle */
+
+  if (opt.mode == "send" || opt.mode == "ping") {
+    if (opt.duration < 0) opt.duration = 10;
+    if (opt.duration == 0) opt.duration = 1e9;
+    return runSend(opt);
+  } else if (opt.mode == "recv" || opt.mode == "echo") {
+    if (opt.duration < 0) opt.duration = 0;
+    return runReceiver(opt);
+  }
+
+  fprintf(stderr, "usage: oscpkt_load send|ping|recv|echo [--host h] [--port p] [--rate n] [--sockets n] [--duration s]\n"
+                  "       [--mix \"/addr:types*weight,...\"] [--string n] [--blob n] [--messages n] [--bundle n] [--rcvbuf n]\n");
+  return 1;
+}
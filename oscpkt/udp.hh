@@ -42,6 +42,9 @@
 # include <sys/socket.h>
 # include <netdb.h>
 # include <sys/time.h>
+# include <unistd.h>
+# include <sys/uio.h>
+# include <time.h>
 #endif
 #include <cstring>
 #include <cstdio>
@@ -49,8 +52,17 @@
 #include <cerrno>
 #include <cassert>
 #include <string>
+#include <ostream>
 #include <vector>
 
+#ifndef _MSC_VER
+#include <stdint.h>
+#else
+namespace oscpkt {
+  typedef unsigned __int64 uint64_t;
+}
+#endif
+
 namespace oscpkt {
 
 /** a wrapper class for holding an ip address, mostly used internnally */
@@ -124,8 +136,12 @@ struct UdpSocket {
 
   std::vector<char> buffer;
 
+  /* kernel arrival time of the last datagram in nanoseconds since the unix
+     epoch, 0 when the platform does not report it (see enableTimestamps) */
+  uint64_t rx_timestamp_ns;
+
 
-  UdpSocket() : handle(-1) { 
+  UdpSocket() : handle(-1), rx_timestamp_ns(0) { 
 #ifdef WIN32
     WSADATA wsa_data;
     if (WSAStartup(MAKEWORD(2,2), &wsa_data) != 0) {
@@ -199,6 +215,18 @@ struct UdpSocket {
     return openSocket(host, port, options);
   }
 
+  /** ask the kernel to timestamp incoming datagrams (SO_TIMESTAMPNS,
+      linux only). Returns false if the option is not available, in that
+      case packetTimestamp() stays 0. */
+  bool enableTimestamps() {
+#if defined(SO_TIMESTAMPNS)
+    int on = 1;
+    return handle != -1 && setsockopt(handle, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof on) == 0;
+#else
+    return false;
+#endif
+  }
+
   void setErr(const std::string &msg) { 
     if (error_message.empty()) error_message = msg;
   }
@@ -235,9 +263,34 @@ struct UdpSocket {
     }
 
     /* now we should be able to read without blocking.. */
+    rx_timestamp_ns = 0;
+#if defined(SO_TIMESTAMPNS)
+    /* recvmsg so the kernel timestamp comes along with the datagram */
+    struct iovec iov;
+    iov.iov_base = &buffer[0];
+    iov.iov_len = buffer.size();
+    char control[CMSG_SPACE(sizeof(struct timespec))];
+    struct msghdr msg; memset(&msg, 0, sizeof msg);
+    msg.msg_name = &remote_addr.addr();
+    msg.msg_namelen = remote_addr.maxLen();
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof control;
+    int nread = (int)recvmsg(handle, &msg, 0);
+    if (nread >= 0) {
+      for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+          struct timespec ts; memcpy(&ts, CMSG_DATA(cmsg), sizeof ts);
+          rx_timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+        }
+      }
+    }
+#else
     socklen_t len = remote_addr.maxLen();
     int nread = (int)recvfrom(handle, &buffer[0], buffer.size(), 0,
                               &remote_addr.addr(), &len);
+#endif
     if (nread < 0) {       
       // maybe here we should differentiate EAGAIN/EINTR/EWOULDBLOCK from real errors
 #ifdef WIN32
@@ -268,6 +321,7 @@ struct UdpSocket {
   void *packetData() { return buffer.empty() ? 0 : &buffer[0]; }
   size_t packetSize() { return buffer.size(); }
   SockAddr &packetOrigin() { return remote_addr; }
+  uint64_t packetTimestamp() const { return rx_timestamp_ns; }
   
 
   bool sendPacket(const void *ptr, size_t sz) {
@@ -2,20 +2,49 @@
 
 #include <StdAfx.h>
 #include <CPluginOSC.h>
+#include <OSCTrace.h>
 
 namespace OSCPlugin
 {
     CPluginOSC* gPlugin = NULL;
 
+    namespace
+    {
+        void LogToEngine( eOSCLogLevel eLevel, const char* sMessage )
+        {
+            if ( !gPlugin )
+            {
+                return;
+            }
+
+            switch ( eLevel )
+            {
+                case OSCLL_Warning:
+                    gPlugin->LogWarning( "%s", sMessage );
+                    break;
+
+                case OSCLL_Error:
+                    gPlugin->LogError( "%s", sMessage );
+                    break;
+
+                default:
+                    gPlugin->LogAlways( "%s", sMessage );
+                    break;
+            }
+        }
+    }
+
     CPluginOSC::CPluginOSC()
     {
         gPlugin = this;
+        SetOSCLogHandler( LogToEngine );
     }
 
     CPluginOSC::~CPluginOSC()
     {
         Release( true );
 
+        SetOSCLogHandler( NULL );
         gPlugin = NULL;
     }
 
@@ -30,6 +59,22 @@ namespace OSCPlugin
 
             if ( bRet )
             {
+                if ( gEnv && gEnv->pConsole )
+                {
+                    gEnv->pConsole->RemoveCommand( "osc_latency" );
+                    gEnv->pConsole->RemoveCommand( "osc_stats" );
+                    gEnv->pConsole->RemoveCommand( "osc_capture" );
+                    gEnv->pConsole->RemoveCommand( "osc_replay" );
+                    gEnv->pConsole->UnregisterVariable( "osc_max_packets_per_update", true );
+                    gEnv->pConsole->UnregisterVariable( "osc_stats_interval", true );
+                    gEnv->pConsole->UnregisterVariable( "osc_log_interval", true );
+                    gEnv->pConsole->UnregisterVariable( "osc_max_peers", true );
+#if OSC_ENABLE_TRACE
+                    gEnv->pConsole->RemoveCommand( "osc_trace_dump" );
+                    gEnv->pConsole->UnregisterVariable( "osc_trace", true );
+#endif
+                }
+
                 // Depending on your plugin you might not want to unregister anything
                 // if the System is quitting.
                 // if(gEnv && gEnv->pSystem && !gEnv->pSystem->IsQuitting()) {
@@ -52,18 +97,89 @@ namespace OSCPlugin
 
         // Note: Autoregister Flownodes will be automatically registered
 
+        REGISTER_COMMAND( "osc_latency", OSCCmdLatency, VF_NULL, "Log receive latency percentiles of all OSC connections (osc_latency reset to clear them)" );
+        REGISTER_COMMAND( "osc_stats", OSCCmdStats, VF_NULL, "Log traffic counters of all OSC connections (osc_stats reset to clear them)" );
+        REGISTER_COMMAND( "osc_capture", OSCCmdCapture, VF_NULL, "Record the packets an OSC server connection receives (osc_capture port [file], without file recording stops)" );
+        REGISTER_COMMAND( "osc_replay", OSCCmdReplay, VF_NULL, "Feed a capture into an OSC server connection (osc_replay port [file] [speed], speed 0 as fast as possible, without file the socket is used again)" );
+
+        REGISTER_CVAR2( "osc_max_packets_per_update", &g_nOSCMaxPacketsPerUpdate, 0, VF_NULL, "Packets a connection receives per frame at most, the rest waits for the next frame (0 unlimited)" );
+        REGISTER_CVAR2( "osc_stats_interval", &g_fOSCStatsInterval, 0.0f, VF_NULL, "Log the traffic counters of every OSC connection every n seconds (0 off)" );
+        REGISTER_CVAR2( "osc_log_interval", &g_fOSCLogInterval, 5.0f, VF_NULL, "Log a problem of an OSC connection once and then summarize its repeats every n seconds (0 log every occurrence)" );
+        REGISTER_CVAR2( "osc_max_peers", &g_nOSCMaxPeers, 1024, VF_NULL, "Peers a fan out UDP server remembers at most, a new one replaces the one that was silent longest (0 unlimited)" );
+
+#if OSC_ENABLE_TRACE
+        REGISTER_COMMAND( "osc_trace_dump", OSCCmdTraceDump, VF_NULL, "Write the recorded OSC trace spans as Chrome trace JSON (osc_trace_dump [file], default osc_trace.json)" );
+        REGISTER_CVAR2( "osc_trace", &g_nOSCTrace, 0, VF_NULL, "Record trace spans of the OSC connections (1 on), see osc_trace_dump" );
+#endif
+
         return true;
     }
 
     const char* CPluginOSC::ListCVars() const
     {
-        return "";
+        return "osc_max_packets_per_update,\nosc_stats_interval,\nosc_log_interval,\nosc_max_peers,\n"
+#if OSC_ENABLE_TRACE
+               "osc_trace,\n"
+#endif
+               ;
     }
 
     const char* CPluginOSC::GetStatus() const
     {
-        return "OK";
+        SOSCStats stats;
+        int nFailed = OSCGetStats( -1, stats );
+
+        m_sStatus.Format( "%s: %d connections (%d failed), in %llu packets %llu KB, out %llu packets %llu KB, errors: parse %llu unmatched %llu wrong type %llu send %llu",
+                          nFailed ? "Error" : "OK", OSCGetConnectionCount(), nFailed,
+                          ( unsigned long long )stats.nPacketsIn, ( unsigned long long )( stats.nBytesIn / 1024 ),
+                          ( unsigned long long )stats.nPacketsOut, ( unsigned long long )( stats.nBytesOut / 1024 ),
+                          ( unsigned long long )stats.nParseErrors, ( unsigned long long )stats.nUnmatched,
+                          ( unsigned long long )stats.nTypeMismatches, ( unsigned long long )stats.nSendFailures );
+        return m_sStatus.c_str();
     }
 
-    // TODO: Add your plugin concrete interface implementation
-}
\ No newline at end of file
+    void OSCCmdStats( IConsoleCmdArgs* pArgs )
+    {
+        if ( pArgs && pArgs->GetArgCount() > 1 && strcmp( pArgs->GetArg( 1 ), "reset" ) == 0 )
+        {
+            OSCResetStats( -1 );
+            return;
+        }
+
+        OSCLogStats();
+    }
+
+    void OSCCmdLatency( IConsoleCmdArgs* pArgs )
+    {
+        if ( pArgs && pArgs->GetArgCount() > 1 && strcmp( pArgs->GetArg( 1 ), "reset" ) == 0 )
+        {
+            OSCResetLatency();
+            return;
+        }
+
+        OSCLogLatency();
+    }
+
+    void OSCCmdCapture( IConsoleCmdArgs* pArgs )
+    {
+        if ( !pArgs || pArgs->GetArgCount() < 2 )
+        {
+            gPlugin->LogWarning( "usage: osc_capture port [file]" );
+            return;
+        }
+
+        OSCCapture( atoi( pArgs->GetArg( 1 ) ), pArgs->GetArgCount() > 2 ? pArgs->GetArg( 2 ) : NULL );
+    }
+
+    void OSCCmdReplay( IConsoleCmdArgs* pArgs )
+    {
+        if ( !pArgs || pArgs->GetArgCount() < 2 )
+        {
+            gPlugin->LogWarning( "usage: osc_replay port [file] [speed]" );
+            return;
+        }
+
+        float fSpeed = pArgs->GetArgCount() > 3 ? float( atof( pArgs->GetArg( 3 ) ) ) : 1.0f;
+        OSCReplay( atoi( pArgs->GetArg( 1 ) ), pArgs->GetArgCount() > 2 ? pArgs->GetArg( 2 ) : NULL, fSpeed );
+    }
+}
@@ -9,6 +9,7 @@
 
 #include <CPluginBase.hpp>
 #include <IPluginOSC.h>
+#include <OSCCore.h>
 
 #define PLUGIN_NAME "OSC"
 #define PLUGIN_CONSOLE_PREFIX "[" PLUGIN_NAME " " PLUGIN_TEXT "] " //!< Prefix for Logentries by this plugin
@@ -22,6 +23,8 @@ namespace OSCPlugin
         public PluginManager::CPluginBase,
         public IPluginOSC
     {
+            mutable string m_sStatus;
+
         public:
             CPluginOSC();
             ~CPluginOSC();
@@ -62,7 +65,7 @@ namespace OSCPlugin
 
             const char* GetCurrentConcreteInterfaceVersion() const
             {
-                return "1.0";
+                return "1.1";
             };
 
             void* GetConcreteInterface( const char* sInterfaceVersion )
@@ -76,10 +79,68 @@ namespace OSCPlugin
                 return static_cast<IPluginBase*>( this );
             };
 
-            // TODO: Add your concrete interface implementation
+            int OpenConnection( const char* sHost, int nPort, EOSCConnectionType eType, int nFraming = 0 )
+            {
+                return OSCOpenConnection( sHost, nPort, eType, nFraming );
+            };
+
+            void CloseConnection( int nConnection )
+            {
+                OSCCloseConnection( nConnection );
+            };
+
+            bool IsConnectionOk( int nConnection )
+            {
+                return OSCIsConnectionOk( nConnection );
+            };
+
+            void AddHandler( int nConnection, const char* sAddress, IOSCMessageHandler* pHandler )
+            {
+                OSCAddHandler( nConnection, sAddress, pHandler );
+            };
+
+            void RemoveHandler( int nConnection, IOSCMessageHandler* pHandler )
+            {
+                OSCRemoveHandler( nConnection, pHandler );
+            };
+
+            bool SendPacket( int nConnection, const void* pData, size_t nSize )
+            {
+                return OSCSendPacket( nConnection, pData, nSize );
+            };
+
+            bool ReplyPacket( int nConnection, const void* pData, size_t nSize )
+            {
+                return OSCReplyPacket( nConnection, pData, nSize );
+            };
+
+            void UpdateConnections()
+            {
+                OSCUpdateConnections( gEnv->pTimer->GetFrameStartTime().GetValue() );
+            };
     };
 
     extern CPluginOSC* gPlugin;
+
+    /**
+    * @brief Console command osc_latency [reset]: log or reset the receive latency percentiles of all connections
+    */
+    void OSCCmdLatency( IConsoleCmdArgs* pArgs );
+
+    /**
+    * @brief Console command osc_stats [reset]: log or reset the traffic counters of all connections
+    */
+    void OSCCmdStats( IConsoleCmdArgs* pArgs );
+
+    /**
+    * @brief Console command osc_capture port [file]: start or stop recording a server connection
+    */
+    void OSCCmdCapture( IConsoleCmdArgs* pArgs );
+
+    /**
+    * @brief Console command osc_replay port [file] [speed]: play a capture into a server connection or return to the socket
+    */
+    void OSCCmdReplay( IConsoleCmdArgs* pArgs );
 }
 
 /**
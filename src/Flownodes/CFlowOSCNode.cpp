@@ -4,40 +4,12 @@
 #include <CPluginOSC.h>
 #include <Nodes/G2FlowBaseNode.h>
 
-#include <oscpkt/oscpkt.hh>
-#include <oscpkt/udp.hh>
-
-#include <list>
-#include <map>
+#include <OSCConnection.h>
 
 using namespace oscpkt;
 
 namespace OSCPlugin
 {
-    class COSCConnection;
-
-    std::map<int, COSCConnection*> g_OSCConnections;
-    int g_nFreeConnection = 1;
-
-    COSCConnection& GetConnection( int nConnection )
-    {
-        assert( g_OSCConnections.find( nConnection ) != g_OSCConnections.end() );
-        assert( g_OSCConnections[nConnection] != 0 );
-
-        return *g_OSCConnections[nConnection];
-    }
-
-    enum eOSCType
-    {
-        OSCT_String,
-        OSCT_Float32,
-        OSCT_Double64,
-        OSCT_Int32,
-        OSCT_Int64,
-        OSCT_Bool,
-        OSCT_Any,
-    };
-
     template<typename T1>
     T1 InitOSCType()
     {
@@ -92,491 +64,132 @@ namespace OSCPlugin
         return OSCT_Bool;
     };
 
-    struct SOSCValueInfo
-    {
-        eOSCType type;
-        TFlowGraphId graphid;
-        SFlowAddress address;
-
-        SOSCValueInfo( eOSCType _type, TFlowGraphId _id, SFlowAddress& _address ) :
-            type( _type ),
-            graphid( _id ),
-            address( _address )
-        {
-        };
-    };
-
-    class ISendInfo
-    {
-        public:
-            virtual void Send( PacketWriter& pw ) const = 0;
-            virtual void Release() = 0;
-
-            virtual void AddValue( SOSCValueInfo& info ) { };
-    };
-
-    class IReceiveInfo
-    {
-        public:
-            virtual void Receive( Message& msg ) const = 0;
-            virtual void Release() = 0;
-    };
-
-    class COSCBundleStart : public ISendInfo
-    {
-        public:
-            void Send( PacketWriter& pw ) const
-            {
-                pw.startBundle();
-            };
-
-            void Release()
-            {
-                delete this;
-            };
-    };
-
-    class COSCBundleEnd : public ISendInfo
-    {
-        public:
-            void Send( PacketWriter& pw ) const
-            {
-                pw.endBundle();
-            };
-
-            void Release()
-            {
-                delete this;
-            };
-    };
-
-    class COSCMessage : public ISendInfo, public IReceiveInfo
-    {
-            std::string m_sMessage;
-            std::list<SOSCValueInfo> m_OSCValues;
-
-        public:
-            COSCMessage( string sMessage )
-            {
-                m_sMessage = sMessage.c_str();
-            }
-
-            void AddValue( SOSCValueInfo& info )
-            {
-                m_OSCValues.push_back( info );
-            }
-
-            void Send( PacketWriter& pw ) const
-            {
-                Message msg( m_sMessage );
-                std::list<SOSCValueInfo>::const_iterator iter;
-
-                for ( iter = m_OSCValues.begin(); iter != m_OSCValues.end(); ++iter )
-                {
-                    const TFlowInputData* data = gEnv->pFlowSystem->GetGraphById( ( *iter ).graphid )->GetInputValue( ( *iter ).address.node, ( *iter ).address.port );
-                    bool bRet = false;
-
-                    switch ( ( *iter ).type )
-                    {
-                        case OSCT_String:
-                            {
-                                string dat;
-                                bRet = data->GetValueWithConversion( dat );
-                                msg.pushStr( dat.c_str() );
-                                break;
-                            }
-
-                        case OSCT_Int32:
-                            {
-                                int dat;
-                                bRet = data->GetValueWithConversion( dat );
-                                msg.pushInt32( dat );
-                                break;
-                            }
-
-                        case OSCT_Int64:
-                            {
-                                long long dat;
-                                int dat2;
-                                bRet = data->GetValueWithConversion( dat2 );
-                                dat = dat2;
-                                msg.pushInt64( dat );
-                                break;
-                            }
-
-                        case OSCT_Float32:
-                            {
-                                float dat;
-                                bRet = data->GetValueWithConversion( dat );
-                                msg.pushFloat( dat );
-                                break;
-                            }
-
-                        case OSCT_Double64:
-                            {
-                                double dat;
-                                float dat2;
-                                bRet = data->GetValueWithConversion( dat2 );
-                                dat = dat2;
-                                msg.pushDouble( dat );
-                                break;
-                            }
-
-                        case OSCT_Bool:
-                            {
-                                bool dat;
-                                bRet = data->GetValueWithConversion( dat );
-                                msg.pushBool( dat );
-                                break;
-                            }
-                    }
-                }
-
-                pw.addMessage( msg );
-            };
-
-            void Receive( Message& msg ) const
-            {
-                if ( msg.match( m_sMessage ) )
-                {
-                    std::list<SOSCValueInfo>::const_iterator iter;
-
-                    Message::ArgReader arg( msg );
 
-                    for ( iter = m_OSCValues.begin(); iter != m_OSCValues.end(); ++iter )
-                    {
-                        if ( arg.nbArgRemaining() && arg.isOk() )
-                        {
-                            switch ( ( *iter ).type )
-                            {
-                                case OSCT_Any:
-                                    {
-                                        arg.pop();
-                                        break;
-                                    }
-
-                                case OSCT_String:
-                                    {
-                                        if ( arg.isStr() )
-                                        {
-                                            std::string dat;
-                                            arg.popStr( dat );
-                                            gEnv->pFlowSystem->GetGraphById( ( *iter ).graphid )->ActivatePort( ( *iter ).address, string( dat.c_str() ) );
-                                            break;
-                                        }
-
-                                        goto WrongType;
-                                    }
-
-                                case OSCT_Int32:
-                                    {
-                                        if ( arg.isInt32() )
-                                        {
-                                            int dat;
-                                            arg.popInt32( dat );
-                                            gEnv->pFlowSystem->GetGraphById( ( *iter ).graphid )->ActivatePort( ( *iter ).address, dat );
-                                            break;
-                                        }
-
-                                        goto WrongType;
-                                    }
-
-                                case OSCT_Int64:
-                                    {
-                                        if ( arg.isInt64() )
-                                        {
-                                            long long dat;
-                                            int dat2;
-                                            arg.popInt64( dat );
-                                            dat2 = dat;
-                                            gEnv->pFlowSystem->GetGraphById( ( *iter ).graphid )->ActivatePort( ( *iter ).address, dat2 );
-                                            break;
-                                        }
-
-                                        goto WrongType;
-                                    }
-
-                                case OSCT_Float32:
-                                    {
-                                        if ( arg.isFloat() )
-                                        {
-                                            float dat;
-                                            arg.popFloat( dat );
-                                            gEnv->pFlowSystem->GetGraphById( ( *iter ).graphid )->ActivatePort( ( *iter ).address, dat );
-                                            break;
-                                        }
-
-                                        goto WrongType;
-                                    }
-
-                                case OSCT_Double64:
-                                    {
-                                        if ( arg.isDouble() )
-                                        {
-                                            double dat;
-                                            float dat2;
-                                            arg.popDouble( dat );
-                                            dat2 = dat;
-                                            gEnv->pFlowSystem->GetGraphById( ( *iter ).graphid )->ActivatePort( ( *iter ).address, dat2 );
-                                            break;
-                                        }
-
-                                        goto WrongType;
-                                    }
-
-                                case OSCT_Bool:
-                                    {
-                                        if ( arg.isBool() )
-                                        {
-                                            bool dat;
-                                            arg.popBool( dat );
-                                            gEnv->pFlowSystem->GetGraphById( ( *iter ).graphid )->ActivatePort( ( *iter ).address, dat );
-                                            break;
-                                        }
-
-                                        goto WrongType;
-                                    }
-                            }
-                        }
-                    }
-                }
-
-                return;
-WrongType:
-                gPlugin->LogWarning( "message %s received unexpected type", m_sMessage.c_str() );
-            };
-
-            void Release()
-            {
-                delete this;
-            };
-    };
-
-    class COSCPacket
+    /**
+    * @brief Activates the output ports of a receive node with the values of its message
+    */
+    class CFlowOSCValueSink :
+        public IOSCValueSink
     {
-            bool m_bAutoSend;
-            bool m_bSend;
-            std::vector<ISendInfo*> m_Content;
+            IFlowGraph* m_pGraph; //!< set once registered
+            TFlowNodeId m_nodeId;
 
         public:
-            COSCPacket()
+            CFlowOSCValueSink()
             {
-                m_bSend = false;
-                m_bAutoSend = true;
+                m_pGraph = NULL;
+                m_nodeId = 0;
             }
 
-            ~COSCPacket()
+            ~CFlowOSCValueSink()
             {
-                std::vector<ISendInfo*>::const_iterator iter;
-
-                for ( iter = m_Content.begin(); iter != m_Content.end(); ++iter )
+                if ( m_pGraph )
                 {
-                    ( *iter )->Release();
+                    InvalidateOSCValues( this );
                 }
             }
 
-            void SetAutoSend( bool bAutoSend )
-            {
-                m_bAutoSend = true;
-            }
-
-            void NotifyChange()
+            void Bind( SActivationInfo* pActInfo )
             {
-                if ( m_bAutoSend )
-                {
-                    m_bSend = true;
-                }
+                m_pGraph = pActInfo->pGraph;
+                m_nodeId = pActInfo->myID;
             }
 
-            void RequestSend()
+            void OnOSCValue( int nPort, int nValue )
             {
-                m_bSend = true;
+                m_pGraph->ActivatePort( SFlowAddress( m_nodeId, nPort, true ), nValue );
             }
 
-            int AddContent( ISendInfo* content )
+            void OnOSCValue( int nPort, float fValue )
             {
-                m_Content.push_back( content );
-                return m_Content.size() - 1;
+                m_pGraph->ActivatePort( SFlowAddress( m_nodeId, nPort, true ), fValue );
             }
 
-            ISendInfo& GetISendInfo( int nMessage )
+            void OnOSCValue( int nPort, bool bValue )
             {
-                assert( nMessage >= 0 );
-                assert( nMessage < m_Content.size() );
-
-                return *m_Content[nMessage];
+                m_pGraph->ActivatePort( SFlowAddress( m_nodeId, nPort, true ), bValue );
             }
 
-            bool Send( UdpSocket& sock )
+            void OnOSCValue( int nPort, const char* sValue )
             {
-                if ( m_bSend )
-                {
-                    m_bSend = false;
-                    PacketWriter pw;
-
-                    std::vector<ISendInfo*>::const_iterator iter;
-
-                    for ( iter = m_Content.begin(); iter != m_Content.end(); ++iter )
-                    {
-                        ( *iter )->Send( pw );
-                    }
-
-                    return sock.sendPacket( pw.packetData(), pw.packetSize() );
-                }
-
-                return false;
+                m_pGraph->ActivatePort( SFlowAddress( m_nodeId, nPort, true ), string( sValue ) );
             }
     };
 
-    class COSCConnection
+    class CFlowConnectionNode :
+        public CFlowBaseNode<eNCT_Instanced>
     {
-            UdpSocket m_sock;
-
-            std::vector<COSCMessage> m_ReceiveOSCMessages;
-            std::vector<COSCPacket> m_Packets;
-            int m_nConnection;
-
-        public:
-            COSCConnection()
-            {
-                m_nConnection = g_nFreeConnection++;
-                g_OSCConnections[m_nConnection] = this;
-            }
-
-            ~COSCConnection()
-            {
-                Reset();
-                g_OSCConnections.erase( m_nConnection );
-            }
-
-            int GetId()
-            {
-                return m_nConnection;
-            }
-
-            void Reset()
-            {
-                m_sock.close();
-                m_ReceiveOSCMessages.clear();
-                m_Packets.clear();
-            }
-
-            int AddReceiveMessage( string sMessage )
+            enum EInputPorts
             {
-                m_ReceiveOSCMessages.push_back( COSCMessage( sMessage ) );
-                return m_ReceiveOSCMessages.size() - 1;
-            }
+                EIP_INIT = 0,
+                EIP_CLOSE,
+                EIP_HOST,
+                EIP_PORT,
+                EIP_TYPE,
+                EIP_FRAMING,
+                EIP_SENDRATE,
+                EIP_SENDREPEAT,
+                EIP_COALESCE,
+                EIP_SUPPRESSREPEATS,
+                EIP_KEEPALIVE,
+                EIP_TIMETAGCLOCK,
+                EIP_TIMETAGLATENCY,
+                EIP_FANOUT,
+                EIP_PEERTIMEOUT,
+            };
 
-            COSCMessage& GetReceiveMessage( int nMessage )
+            enum EOutputPorts
             {
-                assert( nMessage >= 0 );
-                assert( nMessage < m_ReceiveOSCMessages.size() );
+                EOP_NEXTINIT = 0,
+            };
 
-                return m_ReceiveOSCMessages[nMessage];
-            }
+#define INITIALIZE_OUTPUTS(x) \
+    ActivateOutput(x, EOP_NEXTINIT, Vec3(-1,-1,-1));\
+     
+            int m_nHandle; //!< handle to the pooled connection, -1 while closed
 
-            int AddPacket()
+            SOSCConnectionKey GetKey( SActivationInfo* pActInfo )
             {
-                m_Packets.push_back( COSCPacket() );
-                return m_Packets.size() - 1;
+                return MakeOSCConnectionKey( GetPortString( pActInfo, EIP_HOST ).c_str(), GetPortInt( pActInfo, EIP_PORT ),
+                                             EOSCConnectionType( GetPortInt( pActInfo, EIP_TYPE ) ), GetPortInt( pActInfo, EIP_FRAMING ) );
             }
 
-            COSCPacket& GetPacket( int nPacket )
+            void ApplySendSettings( SActivationInfo* pActInfo )
             {
-                assert( nPacket >= 0 );
-                assert( nPacket < m_Packets.size() );
-
-                return m_Packets[nPacket];
+                COSCConnection& conn = GetConnection( m_nHandle );
+                conn.SetSendRate( GetPortFloat( pActInfo, EIP_SENDRATE ), GetPortBool( pActInfo, EIP_SENDREPEAT ) );
+                conn.SetCoalesceSize( size_t( std::max( 0, GetPortInt( pActInfo, EIP_COALESCE ) ) ) );
+                conn.SetSuppressRepeats( GetPortBool( pActInfo, EIP_SUPPRESSREPEATS ), GetPortFloat( pActInfo, EIP_KEEPALIVE ) );
+                conn.SetTimeTags( eOSCTimeTagClock( GetPortInt( pActInfo, EIP_TIMETAGCLOCK ) ), GetPortFloat( pActInfo, EIP_TIMETAGLATENCY ) );
+                conn.SetFanOut( GetPortBool( pActInfo, EIP_FANOUT ), GetPortFloat( pActInfo, EIP_PEERTIMEOUT ) );
             }
 
-            bool Connect( string sHost, int nPort, bool bServer )
+            /**
+            * @brief (Re)initialize the connection and everything chained to it.
+            * The only user keeps its connection and the ids of its messages and packets, they are registered again in place.
+            */
+            void Connect( SActivationInfo* pActInfo )
             {
-                Reset();
-
-                if ( bServer )
-                {
-                    m_sock.bindTo( nPort );
-                }
-
-                else
-                {
-                    m_sock.connectTo( std::string( sHost.c_str() ), nPort );
-                }
+                SOSCConnectionKey key = GetKey( pActInfo );
 
-                if ( m_sock.isOk() )
+                if ( m_nHandle >= 0 && RebindOSCConnection( m_nHandle, key ) )
                 {
-                    gPlugin->LogAlways( "Socket connected port %d", nPort );
-                    return true;
+                    GetConnection( m_nHandle ).BeginRegistration( m_nHandle );
                 }
 
                 else
                 {
-                    gPlugin->LogError( "Error connection to port %d", nPort );
-                    return false;
+                    // not connected yet, shared with other users or the new settings already have a pooled connection:
+                    // trade the reference for the pooled connection of the new settings
+                    ReleaseOSCConnection( m_nHandle );
+                    m_nHandle = AcquireOSCConnection( key );
                 }
-            }
-
-            void Update()
-            {
-                if ( m_sock.isOk() )
-                {
-                    // Receive Data
-                    while ( m_sock.receiveNextPacket( 0 ) )
-                    {
-                        PacketReader pr( m_sock.packetData(), m_sock.packetSize() );
-                        Message* incoming_msg;
-
-                        while ( pr.isOk() && ( incoming_msg = pr.popMessage() ) != 0 )
-                        {
-                            for ( std::vector<COSCMessage>::const_iterator iter = m_ReceiveOSCMessages.begin(); iter != m_ReceiveOSCMessages.end(); ++iter )
-                            {
-                                ( *iter ).Receive( *incoming_msg );
-                            }
-                        }
-                    }
 
-                    // Send Data
-                    for ( std::vector<COSCPacket>::iterator iter = m_Packets.begin(); m_sock.isOk() && iter != m_Packets.end(); ++iter )
-                    {
-                        ( *iter ).Send( m_sock );
-                    }
-                }
+                ApplySendSettings( pActInfo );
 
-                else
-                {
-                    gPlugin->LogError( "Sock error: %s - is the server running?", m_sock.errorMessage().c_str() );
-                }
+                ActivateOutput( pActInfo, EOP_NEXTINIT, Vec3( m_nHandle, -1, -1 ) );
+                pActInfo->pGraph->SetRegularlyUpdated( pActInfo->myID, true );
             }
-    };
-
-    class CFlowConnectionNode :
-        public CFlowBaseNode<eNCT_Instanced>
-    {
-            enum EInputPorts
-            {
-                EIP_INIT = 0,
-                EIP_CLOSE,
-                EIP_HOST,
-                EIP_PORT,
-                EIP_TYPE,
-            };
-
-            enum EOutputPorts
-            {
-                EOP_NEXTINIT = 0,
-            };
-
-#define INITIALIZE_OUTPUTS(x) \
-    ActivateOutput(x, EOP_NEXTINIT, Vec3(-1,-1,-1));\
-     
-            enum EConnectionType
-            {
-                CT_Client = 0,
-                CT_Server,
-                CT_Default = CT_Client,
-            };
-
-            COSCConnection m_conn;
 
         public:
             virtual void GetMemoryUsage( ICrySizer* s ) const
@@ -591,7 +204,12 @@ WrongType:
 
             CFlowConnectionNode( SActivationInfo* pActInfo )
             {
+                m_nHandle = -1;
+            }
 
+            ~CFlowConnectionNode()
+            {
+                ReleaseOSCConnection( m_nHandle );
             }
 
             virtual void GetConfiguration( SFlowNodeConfig& config )
@@ -603,7 +221,17 @@ WrongType:
 
                     InputPortConfig<string>( "sHost", "localhost", _HELP( "host/ip to bind/connect" ), "sHost", _UICONFIG( "" ) ),
                     InputPortConfig<int>( "nPort", 7777, _HELP( "port to listen/connect" ), "nPort", _UICONFIG( "" ) ),
-                    InputPortConfig<int>( "nType", int( CT_Default ), _HELP( "type" ), "nType", _UICONFIG( "enum_int:UDP-Client=0,UDP-Server=1" ) ),
+                    InputPortConfig<int>( "nType", int( OSCCT_UdpClient ), _HELP( "type" ), "nType", _UICONFIG( "enum_int:UDP-Client=0,UDP-Server=1,TCP-Client=2,TCP-Server=3,SHM-Client=4,SHM-Server=5" ) ),
+                    InputPortConfig<int>( "nFraming", int( OSCSF_Slip ), _HELP( "packet framing for TCP connections" ), "nFraming", _UICONFIG( "enum_int:SLIP=0,LengthPrefix=1" ) ),
+                    InputPortConfig<float>( "fSendRate", 0.0f, _HELP( "packets per second sent from a separate thread, 0 sends changed packets every frame" ), "fSendRate", _UICONFIG( "" ) ),
+                    InputPortConfig<bool>( "bSendRepeat", false, _HELP( "with fSendRate resend unchanged packets on every tick" ), "bSendRepeat", _UICONFIG( "" ) ),
+                    InputPortConfig<int>( "nCoalesceSize", 0, _HELP( "send changed packets together in bundles of up to this many bytes (1472 fits an Ethernet MTU), 0 sends each packet on its own" ), "nCoalesceSize", _UICONFIG( "" ) ),
+                    InputPortConfig<bool>( "bSuppressRepeats", false, _HELP( "skip sending a packet if it is byte for byte the same as the last time it was sent" ), "bSuppressRepeats", _UICONFIG( "" ) ),
+                    InputPortConfig<float>( "fKeepAlive", 0.0f, _HELP( "with bSuppressRepeats send a repeated packet anyway after this many seconds, 0 never" ), "fKeepAlive", _UICONFIG( "" ) ),
+                    InputPortConfig<int>( "nTimeTagClock", int( OSCTC_Immediate ), _HELP( "timetag of sent bundles" ), "nTimeTagClock", _UICONFIG( "enum_int:Immediate=0,FrameStart=1,Monotonic=2" ) ),
+                    InputPortConfig<float>( "fTimeTagLatency", 0.0f, _HELP( "seconds added to the timetags, receivers schedule the bundles that far ahead" ), "fTimeTagLatency", _UICONFIG( "" ) ),
+                    InputPortConfig<bool>( "bFanOut", false, _HELP( "UDP server: send to everyone that sent something instead of only the last sender" ), "bFanOut", _UICONFIG( "" ) ),
+                    InputPortConfig<float>( "fPeerTimeout", 10.0f, _HELP( "with bFanOut seconds after which a peer that sent nothing is dropped, 0 never" ), "fPeerTimeout", _UICONFIG( "" ) ),
                     InputPortConfig_Null(),
                 };
 
@@ -639,23 +267,49 @@ WrongType:
                     case eFE_Activate:
                         if ( IsPortActive( pActInfo, EIP_CLOSE ) )
                         {
+                            ReleaseOSCConnection( m_nHandle );
+                            m_nHandle = -1;
+
                             INITIALIZE_OUTPUTS( pActInfo );
                             pActInfo->pGraph->SetRegularlyUpdated( pActInfo->myID, false );
                         }
 
                         if ( IsPortActive( pActInfo, EIP_INIT ) )
                         {
-                            m_conn.Connect( GetPortString( pActInfo, EIP_HOST ), GetPortInt( pActInfo, EIP_PORT ), ( bool )GetPortInt( pActInfo, EIP_TYPE ) );
+                            Connect( pActInfo );
+                        }
 
-                            ActivateOutput( pActInfo, EOP_NEXTINIT, Vec3( m_conn.GetId(), -1, -1 ) );
-                            pActInfo->pGraph->SetRegularlyUpdated( pActInfo->myID, true );
+                        else if ( m_nHandle >= 0 && ( IsPortActive( pActInfo, EIP_HOST ) || IsPortActive( pActInfo, EIP_PORT )
+                                                      || IsPortActive( pActInfo, EIP_TYPE ) || IsPortActive( pActInfo, EIP_FRAMING ) ) )
+                        {
+                            // hot rebind, the registrations stay so there's nothing to initialize again
+                            if ( !RebindOSCConnection( m_nHandle, GetKey( pActInfo ) ) )
+                            {
+                                Connect( pActInfo );
+                            }
+                        }
+
+                        else if ( m_nHandle >= 0 && ( IsPortActive( pActInfo, EIP_SENDRATE ) || IsPortActive( pActInfo, EIP_SENDREPEAT ) || IsPortActive( pActInfo, EIP_COALESCE )
+                                                      || IsPortActive( pActInfo, EIP_SUPPRESSREPEATS ) || IsPortActive( pActInfo, EIP_KEEPALIVE )
+                                                      || IsPortActive( pActInfo, EIP_TIMETAGCLOCK ) || IsPortActive( pActInfo, EIP_TIMETAGLATENCY )
+                                                      || IsPortActive( pActInfo, EIP_FANOUT ) || IsPortActive( pActInfo, EIP_PEERTIMEOUT ) ) )
+                        {
+                            ApplySendSettings( pActInfo );
                         }
 
                         break;
 
                     case eFE_Update:
-                        m_conn.Update();
-                        break;
+                        {
+                            COSCConnection* pConn = FindConnection( m_nHandle );
+
+                            if ( pConn )
+                            {
+                                pConn->Update( gEnv->pTimer->GetFrameStartTime().GetValue() );
+                            }
+
+                            break;
+                        }
                 }
             }
     };
@@ -719,17 +373,8 @@ WrongType:
                         if ( IsPortActive( pActInfo, EIP_INIT ) )
                         {
                             Vec3 initializer = GetPortVec3( pActInfo, EIP_INIT );
-                            GetConnection( initializer[0] ).GetReceiveMessage( initializer[2] ).AddValue(
-                                SOSCValueInfo(
-                                    OSCT_Any,
-                                    pActInfo->pGraph->GetGraphId(),
-                                    SFlowAddress( pActInfo->myID,
-                                                  -1,
-                                                  true
-                                                )
-                                )
-                            );
-
+                            // skips the argument, nothing to output
+                            GetConnection( initializer[0] ).GetReceiveMessage( initializer[2] ).AddValue( SOSCValueInfo( OSCT_Any, NULL, -1 ) );
                             ActivateOutput( pActInfo, EOP_NEXTINIT, initializer );
                         }
 
@@ -751,6 +396,7 @@ WrongType:
             {
                 EOP_NEXTINIT = 0,
                 EOP_VALUE,
+                EOP_EXACT, //!< only on 64 bit types, activated by COSCMessage::Receive after EOP_VALUE
             };
 
         public:
@@ -764,6 +410,8 @@ WrongType:
                 return new CFlowReceiveValueNode( pActInfo );
             }
 
+            CFlowOSCValueSink m_Sink;
+
             CFlowReceiveValueNode( SActivationInfo* pActInfo )
             {
 
@@ -784,8 +432,16 @@ WrongType:
                     OutputPortConfig_Null(),
                 };
 
+                static const SOutputPortConfig outputsExact[] =
+                {
+                    OutputPortConfig<Vec3>( "InitNextRValue", _HELP( "for initialization of next receive value" ) ),
+                    OutputPortConfig<T1>( "Value", _HELP( "value" ) ),
+                    OutputPortConfig<string>( "sExact", _HELP( "value as text with the full 64 bit precision" ) ),
+                    OutputPortConfig_Null(),
+                };
+
                 config.pInputPorts = inputs;
-                config.pOutputPorts = outputs;
+                config.pOutputPorts = T2 == OSCT_Int64 || T2 == OSCT_Double64 ? outputsExact : outputs;
                 config.sDescription = _HELP( PLUGIN_CONSOLE_PREFIX " Receive Type" );
 
                 config.SetCategory( EFLN_APPROVED );
@@ -800,15 +456,8 @@ WrongType:
                         if ( IsPortActive( pActInfo, EIP_INIT ) )
                         {
                             Vec3 initializer = GetPortVec3( pActInfo, EIP_INIT );
-                            GetConnection( initializer[0] ).GetReceiveMessage( initializer[2] ).AddValue(
-                                SOSCValueInfo( T2, //ToOSCType<T1>(),
-                                               pActInfo->pGraph->GetGraphId(),
-                                               SFlowAddress( pActInfo->myID,
-                                                             EOP_VALUE,
-                                                             true
-                                                           )
-                                             )
-                            );
+                            m_Sink.Bind( pActInfo );
+                            GetConnection( initializer[0] ).GetReceiveMessage( initializer[2] ).AddValue( SOSCValueInfo( T2, &m_Sink, EOP_VALUE ) );
 
                             ActivateOutput( pActInfo, EOP_NEXTINIT, initializer );
                         }
@@ -825,6 +474,9 @@ WrongType:
             {
                 EIP_INIT = 0,
                 EIP_MESSAGE,
+                EIP_JITTERBUFFER,
+                EIP_MAXDELAY,
+                EIP_MAXEXTRAPOLATION,
             };
 
             enum EOutputPorts
@@ -854,6 +506,9 @@ WrongType:
                 {
                     InputPortConfig<Vec3>( "InitFromConnection", _HELP( "Initialize" ) ),
                     InputPortConfig<string>( "sMessage", "/", _HELP( "Message" ), "sMessage", _UICONFIG( "" ) ),
+                    InputPortConfig<bool>( "bJitterBuffer", false, _HELP( "delay the numeric values slightly and interpolate them every frame, for streams of continuous values (positions, sensors)" ), "bJitterBuffer", _UICONFIG( "" ) ),
+                    InputPortConfig<float>( "fMaxDelay", 0.1f, _HELP( "with bJitterBuffer the most the values are delayed in seconds, the delay adapts to the arrival jitter below that" ), "fMaxDelay", _UICONFIG( "" ) ),
+                    InputPortConfig<float>( "fMaxExtrapolation", 0.05f, _HELP( "with bJitterBuffer seconds to continue the last trend when no message arrives, then the value is held" ), "fMaxExtrapolation", _UICONFIG( "" ) ),
                     InputPortConfig_Null(),
                 };
 
@@ -879,7 +534,9 @@ WrongType:
                         if ( IsPortActive( pActInfo, EIP_INIT ) )
                         {
                             Vec3 initializer = GetPortVec3( pActInfo, EIP_INIT );
-                            initializer[2] = GetConnection( initializer[0] ).AddReceiveMessage( GetPortString( pActInfo, EIP_MESSAGE ) );
+                            COSCConnection& conn = GetConnection( initializer[0] );
+                            initializer[2] = conn.AddReceiveMessage( GetPortString( pActInfo, EIP_MESSAGE ), int( initializer[0] ) );
+                            conn.SetJitterBuffer( int( initializer[2] ), GetPortBool( pActInfo, EIP_JITTERBUFFER ), GetPortFloat( pActInfo, EIP_MAXDELAY ), GetPortFloat( pActInfo, EIP_MAXEXTRAPOLATION ) );
                             ActivateOutput( pActInfo, EOP_NEXTINIT, initializer );
                         }
 
@@ -952,7 +609,7 @@ WrongType:
 
                         if ( IsPortActive( pActInfo, EIP_INIT ) )
                         {
-                            initializer[1] = m_pkt = GetConnection( initializer[0] ).AddPacket();
+                            initializer[1] = m_pkt = GetConnection( initializer[0] ).AddPacket( int( initializer[0] ) );
 
                             GetConnection( initializer[0] ).GetPacket( m_pkt ).SetAutoSend( GetPortBool( pActInfo, EIP_AUTOSEND ) );
 
@@ -1035,7 +692,7 @@ WrongType:
 
                         if ( IsPortActive( pActInfo, EIP_INIT ) )
                         {
-                            initializer[2] = GetConnection( initializer[0] ).GetPacket( initializer[1] ).AddContent( new COSCMessage( GetPortString( pActInfo, EIP_MESSAGE ) ) );
+                            initializer[2] = GetConnection( initializer[0] ).GetPacket( initializer[1] ).AddMessage( GetPortString( pActInfo, EIP_MESSAGE ) );
                             ActivateOutput( pActInfo, EOP_NEXTINIT, initializer );
                         }
 
@@ -1052,6 +709,7 @@ WrongType:
             {
                 EIP_INIT = 0,
                 EIP_VALUE,
+                EIP_EXACT, //!< only on 64 bit types
             };
 
             enum EOutputPorts
@@ -1060,6 +718,12 @@ WrongType:
             };
 
             T1 m_value;
+            int m_nSlot;
+
+            COSCPacket& GetPacket( const Vec3& initializer )
+            {
+                return GetConnection( initializer[0] ).GetPacket( initializer[1] );
+            }
 
         public:
             virtual void GetMemoryUsage( ICrySizer* s ) const
@@ -1075,6 +739,7 @@ WrongType:
             CFlowSendValueNode( SActivationInfo* pActInfo )
             {
                 m_value = InitOSCType<T1>();
+                m_nSlot = -1;
             }
 
             virtual void GetConfiguration( SFlowNodeConfig& config )
@@ -1086,13 +751,21 @@ WrongType:
                     InputPortConfig_Null(),
                 };
 
+                static const SInputPortConfig inputsExact[] =
+                {
+                    InputPortConfig<Vec3>( "InitFromSMessageOrSValue", _HELP( "Initialize" ) ),
+                    InputPortConfig<T1>( "Value", _HELP( "value" ) ),
+                    InputPortConfig<string>( "sExact", _HELP( "value as text, keeps the full 64 bit precision" ) ),
+                    InputPortConfig_Null(),
+                };
+
                 static const SOutputPortConfig outputs[] =
                 {
                     OutputPortConfig<Vec3>( "InitNextSValueOrSMessageOrSBundle", _HELP( "for initialization of next send value or message or bundle" ) ),
                     OutputPortConfig_Null(),
                 };
 
-                config.pInputPorts = inputs;
+                config.pInputPorts = T2 == OSCT_Int64 || T2 == OSCT_Double64 ? inputsExact : inputs;
                 config.pOutputPorts = outputs;
                 config.sDescription = _HELP( PLUGIN_CONSOLE_PREFIX " Send Type" );
 
@@ -1108,19 +781,21 @@ WrongType:
 
                         if ( IsPortActive( pActInfo, EIP_INIT ) )
                         {
-                            GetConnection( initializer[0] ).GetPacket( initializer[1] ).GetISendInfo( initializer[2] ).AddValue(
-                                SOSCValueInfo( T2,
-                                               pActInfo->pGraph->GetGraphId(),
-                                               SFlowAddress( pActInfo->myID,
-                                                             EIP_VALUE,
-                                                             false
-                                                           )
-                                             ) );
+                            m_nSlot = GetConnection( initializer[0] ).GetPacket( initializer[1] ).AddValue( initializer[2], T2 );
+
+                            // start with what is on the port, later changes are pushed on activation
+                            GetPortAny( pActInfo, EIP_VALUE ).GetValueWithConversion( m_value );
+                            GetPacket( initializer ).SetValue( m_nSlot, m_value );
 
                             ActivateOutput( pActInfo, EOP_NEXTINIT, initializer );
                         }
 
-                        if ( IsPortActive( pActInfo, EIP_VALUE ) && initializer[0] > 0 && initializer[1] >= 0 )
+                        if ( m_nSlot < 0 || initializer[0] <= 0 || initializer[1] < 0 )
+                        {
+                            break;
+                        }
+
+                        if ( IsPortActive( pActInfo, EIP_VALUE ) )
                         {
                             const TFlowInputData& val = GetPortAny( pActInfo, EIP_VALUE );
                             T1 curval;
@@ -1130,11 +805,18 @@ WrongType:
                                 if ( m_value != curval )
                                 {
                                     m_value = curval;
-                                    GetConnection( initializer[0] ).GetPacket( initializer[1] ).NotifyChange();
+                                    GetPacket( initializer ).SetValue( m_nSlot, curval );
+                                    GetPacket( initializer ).NotifyChange();
                                 }
                             }
                         }
 
+                        if ( ( T2 == OSCT_Int64 || T2 == OSCT_Double64 ) && IsPortActive( pActInfo, EIP_EXACT ) )
+                        {
+                            GetPacket( initializer ).SetValueExact( m_nSlot, GetPortString( pActInfo, EIP_EXACT ) );
+                            GetPacket( initializer ).NotifyChange();
+                        }
+
                         break;
                 }
             }
@@ -1200,7 +882,7 @@ WrongType:
                         if ( IsPortActive( pActInfo, EIP_INIT ) )
                         {
                             initializer[2] = -1;
-                            GetConnection( initializer[0] ).GetPacket( initializer[1] ).AddContent( new COSCBundleStart() );
+                            GetConnection( initializer[0] ).GetPacket( initializer[1] ).AddBundleStart();
                             ActivateOutput( pActInfo, EOP_NEXTINIT, initializer );
                         }
 
@@ -1269,7 +951,7 @@ WrongType:
                         if ( IsPortActive( pActInfo, EIP_INIT ) )
                         {
                             initializer[2] = -1;
-                            GetConnection( initializer[0] ).GetPacket( initializer[1] ).AddContent( new COSCBundleEnd() );
+                            GetConnection( initializer[0] ).GetPacket( initializer[1] ).AddBundleEnd();
                             ActivateOutput( pActInfo, EOP_NEXTINIT, initializer );
                         }
 
@@ -1277,9 +959,720 @@ WrongType:
                 }
             }
     };
+    /**
+    * @brief Outputs the traffic counters of a connection or of all connections
+    */
+    class CFlowStatsNode :
+        public CFlowBaseNode<eNCT_Instanced>
+    {
+            enum EInputPorts
+            {
+                EIP_INIT = 0,
+                EIP_GET,
+                EIP_RESET,
+                EIP_INTERVAL,
+            };
+
+            enum EOutputPorts
+            {
+                EOP_OK = 0,
+                EOP_PACKETSIN,
+                EOP_PACKETSOUT,
+                EOP_KBYTESIN,
+                EOP_KBYTESOUT,
+                EOP_PARSEERRORS,
+                EOP_UNMATCHED,
+                EOP_TYPEMISMATCHES,
+                EOP_SENDFAILURES,
+                EOP_PACKETSINRATE,
+                EOP_PACKETSOUTRATE,
+                EOP_UPDATEMS,
+                EOP_UPDATEMAXMS,
+                EOP_SUPPRESSED,
+            };
+
+            int m_nConnection; //!< -1 for all connections
+            SOSCStats m_Last; //!< counters at the last output, for the rates
+            float m_fLastTime;
+            float m_fNextTime;
+
+            static float Rate( uint64 nNow, uint64 nBefore, float fSeconds )
+            {
+                return nNow >= nBefore && fSeconds > 0 ? float( nNow - nBefore ) / fSeconds : 0.0f;
+            }
+
+            void Output( SActivationInfo* pActInfo )
+            {
+                SOSCStats stats;
+                int nFailed = OSCGetStats( m_nConnection, stats );
+                float fNow = gEnv->pTimer->GetAsyncCurTime();
+                float fElapsed = m_fLastTime > 0 ? fNow - m_fLastTime : 0.0f;
+
+                ActivateOutput( pActInfo, EOP_OK, nFailed == 0 );
+                ActivateOutput( pActInfo, EOP_PACKETSIN, int( stats.nPacketsIn ) );
+                ActivateOutput( pActInfo, EOP_PACKETSOUT, int( stats.nPacketsOut ) );
+                ActivateOutput( pActInfo, EOP_KBYTESIN, int( stats.nBytesIn / 1024 ) );
+                ActivateOutput( pActInfo, EOP_KBYTESOUT, int( stats.nBytesOut / 1024 ) );
+                ActivateOutput( pActInfo, EOP_PARSEERRORS, int( stats.nParseErrors ) );
+                ActivateOutput( pActInfo, EOP_UNMATCHED, int( stats.nUnmatched ) );
+                ActivateOutput( pActInfo, EOP_TYPEMISMATCHES, int( stats.nTypeMismatches ) );
+                ActivateOutput( pActInfo, EOP_SENDFAILURES, int( stats.nSendFailures ) );
+                ActivateOutput( pActInfo, EOP_PACKETSINRATE, Rate( stats.nPacketsIn, m_Last.nPacketsIn, fElapsed ) );
+                ActivateOutput( pActInfo, EOP_PACKETSOUTRATE, Rate( stats.nPacketsOut, m_Last.nPacketsOut, fElapsed ) );
+
+                uint64 nUpdates = stats.nUpdates >= m_Last.nUpdates ? stats.nUpdates - m_Last.nUpdates : 0;
+                uint64 nUpdateNs = stats.nUpdateNs >= m_Last.nUpdateNs ? stats.nUpdateNs - m_Last.nUpdateNs : 0;
+                ActivateOutput( pActInfo, EOP_UPDATEMS, nUpdates ? float( nUpdateNs / 1e6 / nUpdates ) : 0.0f );
+                ActivateOutput( pActInfo, EOP_UPDATEMAXMS, float( stats.nUpdateMaxNs / 1e6 ) );
+                ActivateOutput( pActInfo, EOP_SUPPRESSED, int( stats.nSuppressed ) );
+
+                m_Last = stats;
+                m_fLastTime = fNow;
+            }
+
+        public:
+            virtual void GetMemoryUsage( ICrySizer* s ) const
+            {
+                s->Add( *this );
+            }
+
+            virtual IFlowNodePtr Clone( SActivationInfo* pActInfo )
+            {
+                return new CFlowStatsNode( pActInfo );
+            }
+
+            CFlowStatsNode( SActivationInfo* pActInfo )
+            {
+                m_nConnection = -1;
+                m_fLastTime = 0;
+                m_fNextTime = 0;
+            }
+
+            virtual void GetConfiguration( SFlowNodeConfig& config )
+            {
+                static const SInputPortConfig inputs[] =
+                {
+                    InputPortConfig<Vec3>( "InitFromConnection", _HELP( "Initialize, without it the sum of all connections is reported" ) ),
+                    InputPortConfig_Void( "Get", _HELP( "output the counters now" ) ),
+                    InputPortConfig_Void( "Reset", _HELP( "reset the counters" ) ),
+                    InputPortConfig<float>( "fInterval", 1.0f, _HELP( "output the counters every n seconds (0 only on Get)" ) ),
+                    InputPortConfig_Null(),
+                };
+
+                static const SOutputPortConfig outputs[] =
+                {
+                    OutputPortConfig<bool>( "bOk", _HELP( "false if a connection failed" ) ),
+                    OutputPortConfig<int>( "nPacketsIn", _HELP( "packets received" ) ),
+                    OutputPortConfig<int>( "nPacketsOut", _HELP( "packets sent" ) ),
+                    OutputPortConfig<int>( "nKBytesIn", _HELP( "KB received" ) ),
+                    OutputPortConfig<int>( "nKBytesOut", _HELP( "KB sent" ) ),
+                    OutputPortConfig<int>( "nParseErrors", _HELP( "received packets that were not valid OSC" ) ),
+                    OutputPortConfig<int>( "nUnmatched", _HELP( "received messages nothing was registered for" ) ),
+                    OutputPortConfig<int>( "nTypeMismatches", _HELP( "received values dropped because of their type" ) ),
+                    OutputPortConfig<int>( "nSendFailures", _HELP( "packets that could not be sent" ) ),
+                    OutputPortConfig<float>( "fPacketsInPerSec", _HELP( "packets received per second since the last output" ) ),
+                    OutputPortConfig<float>( "fPacketsOutPerSec", _HELP( "packets sent per second since the last output" ) ),
+                    OutputPortConfig<float>( "fUpdateMs", _HELP( "average time of a connection update since the last output" ) ),
+                    OutputPortConfig<float>( "fUpdateMaxMs", _HELP( "longest connection update" ) ),
+                    OutputPortConfig<int>( "nSuppressed", _HELP( "sends skipped because the packet didn't change (bSuppressRepeats)" ) ),
+                    OutputPortConfig_Null(),
+                };
+
+                config.pInputPorts = inputs;
+                config.pOutputPorts = outputs;
+                config.sDescription = _HELP( PLUGIN_CONSOLE_PREFIX " Stats" );
+
+                config.SetCategory( EFLN_APPROVED );
+            }
+
+            virtual void ProcessEvent( EFlowEvent evt, SActivationInfo* pActInfo )
+            {
+                switch ( evt )
+                {
+                    case eFE_Initialize:
+                        pActInfo->pGraph->SetRegularlyUpdated( pActInfo->myID, true );
+                        break;
+
+                    case eFE_Activate:
+                        if ( IsPortActive( pActInfo, EIP_INIT ) )
+                        {
+                            m_nConnection = int( GetPortVec3( pActInfo, EIP_INIT )[0] );
+                            m_fLastTime = 0;
+                        }
+
+                        if ( IsPortActive( pActInfo, EIP_RESET ) )
+                        {
+                            OSCResetStats( m_nConnection );
+                            m_Last.Reset();
+                            m_fLastTime = 0;
+                        }
+
+                        if ( IsPortActive( pActInfo, EIP_GET ) )
+                        {
+                            Output( pActInfo );
+                        }
+
+                        break;
+
+                    case eFE_Update:
+                        {
+                            float fInterval = GetPortFloat( pActInfo, EIP_INTERVAL );
+                            float fNow = gEnv->pTimer->GetAsyncCurTime();
+
+                            if ( fInterval > 0 && fNow >= m_fNextTime )
+                            {
+                                m_fNextTime = fNow + fInterval;
+                                Output( pActInfo );
+                            }
+
+                            break;
+                        }
+                }
+            }
+    };
+
+    inline uint32 ToOSCWord( float fValue )
+    {
+        uint32 nWord;
+        memcpy( &nWord, &fValue, 4 );
+        return nWord;
+    }
+
+    inline uint32 ToOSCWord( int nValue )
+    {
+        return uint32( nValue );
+    }
+
+    inline void FromOSCWord( uint32 nWord, float& fValue )
+    {
+        memcpy( &fValue, &nWord, 4 );
+    }
+
+    inline void FromOSCWord( uint32 nWord, int& nValue )
+    {
+        nValue = int( nWord );
+    }
+
+    /**
+    * @brief Receives a float32/int32 array blob, elements are read back by index
+    */
+    template<typename T1, eOSCType T2>
+    class CFlowReceiveArrayNode :
+        public CFlowBaseNode<eNCT_Instanced>
+    {
+            enum EInputPorts
+            {
+                EIP_INIT = 0,
+                EIP_INDEX,
+                EIP_GET,
+            };
+
+            enum EOutputPorts
+            {
+                EOP_NEXTINIT = 0,
+                EOP_COUNT,
+                EOP_VALUE,
+            };
+
+            std::vector<uint32> m_Words; //!< last received array, host byte order
+            CFlowOSCValueSink m_Sink; //!< after m_Words, so it is unregistered before the array goes away
+
+        public:
+            virtual void GetMemoryUsage( ICrySizer* s ) const
+            {
+                s->Add( *this );
+            }
+
+            virtual IFlowNodePtr Clone( SActivationInfo* pActInfo )
+            {
+                return new CFlowReceiveArrayNode( pActInfo );
+            }
+
+            CFlowReceiveArrayNode( SActivationInfo* pActInfo )
+            {
+
+            }
+
+            virtual void GetConfiguration( SFlowNodeConfig& config )
+            {
+                static const SInputPortConfig inputs[] =
+                {
+                    InputPortConfig<Vec3>( "InitFromRMessageOrRValue", _HELP( "Initialize" ) ),
+                    InputPortConfig<int>( "nIndex", 0, _HELP( "element to output" ) ),
+                    InputPortConfig_Void( "Get", _HELP( "output the element at nIndex" ) ),
+                    InputPortConfig_Null(),
+                };
+
+                static const SOutputPortConfig outputs[] =
+                {
+                    OutputPortConfig<Vec3>( "InitNextRValue", _HELP( "for initialization of next receive value" ) ),
+                    OutputPortConfig<int>( "nCount", _HELP( "number of elements, activated when an array was received" ) ),
+                    OutputPortConfig<T1>( "Value", _HELP( "element at nIndex" ) ),
+                    OutputPortConfig_Null(),
+                };
+
+                config.pInputPorts = inputs;
+                config.pOutputPorts = outputs;
+                config.sDescription = _HELP( PLUGIN_CONSOLE_PREFIX " Receive Array" );
+
+                config.SetCategory( EFLN_APPROVED );
+            }
+
+            virtual void ProcessEvent( EFlowEvent evt, SActivationInfo* pActInfo )
+            {
+                switch ( evt )
+                {
+                    case eFE_Activate:
+
+                        if ( IsPortActive( pActInfo, EIP_INIT ) )
+                        {
+                            Vec3 initializer = GetPortVec3( pActInfo, EIP_INIT );
+                            m_Sink.Bind( pActInfo );
+                            GetConnection( initializer[0] ).GetReceiveMessage( initializer[2] ).AddValue( SOSCValueInfo( T2, &m_Sink, EOP_COUNT, &m_Words ) );
+
+                            ActivateOutput( pActInfo, EOP_NEXTINIT, initializer );
+                        }
+
+                        if ( IsPortActive( pActInfo, EIP_INDEX ) || IsPortActive( pActInfo, EIP_GET ) )
+                        {
+                            int nIndex = GetPortInt( pActInfo, EIP_INDEX );
+
+                            if ( nIndex >= 0 && nIndex < int( m_Words.size() ) )
+                            {
+                                T1 value;
+                                FromOSCWord( m_Words[nIndex], value );
+                                ActivateOutput( pActInfo, EOP_VALUE, value );
+                            }
+                        }
+
+                        break;
+                }
+            }
+    };
+
+    /**
+    * @brief Sends a float32/int32 array blob, elements are set by index
+    */
+    template<typename T1, eOSCType T2>
+    class CFlowSendArrayNode :
+        public CFlowBaseNode<eNCT_Instanced>
+    {
+            enum EInputPorts
+            {
+                EIP_INIT = 0,
+                EIP_SIZE,
+                EIP_INDEX,
+                EIP_VALUE,
+            };
+
+            enum EOutputPorts
+            {
+                EOP_NEXTINIT = 0,
+            };
+
+            int m_nSlot;
+
+            COSCPacket& GetPacket( const Vec3& initializer )
+            {
+                return GetConnection( initializer[0] ).GetPacket( initializer[1] );
+            }
+
+        public:
+            virtual void GetMemoryUsage( ICrySizer* s ) const
+            {
+                s->Add( *this );
+            }
+
+            virtual IFlowNodePtr Clone( SActivationInfo* pActInfo )
+            {
+                return new CFlowSendArrayNode( pActInfo );
+            }
+
+            CFlowSendArrayNode( SActivationInfo* pActInfo )
+            {
+                m_nSlot = -1;
+            }
+
+            virtual void GetConfiguration( SFlowNodeConfig& config )
+            {
+                static const SInputPortConfig inputs[] =
+                {
+                    InputPortConfig<Vec3>( "InitFromSMessageOrSValue", _HELP( "Initialize" ) ),
+                    InputPortConfig<int>( "nSize", 0, _HELP( "number of elements (at most 16384)" ) ),
+                    InputPortConfig<int>( "nIndex", 0, _HELP( "element Value is written to" ) ),
+                    InputPortConfig<T1>( "Value", _HELP( "value of the element at nIndex" ) ),
+                    InputPortConfig_Null(),
+                };
+
+                static const SOutputPortConfig outputs[] =
+                {
+                    OutputPortConfig<Vec3>( "InitNextSValueOrSMessageOrSBundle", _HELP( "for initialization of next send value or message or bundle" ) ),
+                    OutputPortConfig_Null(),
+                };
+
+                config.pInputPorts = inputs;
+                config.pOutputPorts = outputs;
+                config.sDescription = _HELP( PLUGIN_CONSOLE_PREFIX " Send Array" );
+
+                config.SetCategory( EFLN_APPROVED );
+            }
+
+            virtual void ProcessEvent( EFlowEvent evt, SActivationInfo* pActInfo )
+            {
+                switch ( evt )
+                {
+                    case eFE_Activate:
+                        Vec3 initializer = GetPortVec3( pActInfo, EIP_INIT );
+
+                        if ( IsPortActive( pActInfo, EIP_INIT ) )
+                        {
+                            m_nSlot = GetPacket( initializer ).AddValue( initializer[2], T2 );
+                            GetPacket( initializer ).SetArraySize( m_nSlot, std::max( 0, GetPortInt( pActInfo, EIP_SIZE ) ) );
+                            ActivateOutput( pActInfo, EOP_NEXTINIT, initializer );
+                        }
+
+                        if ( m_nSlot < 0 || initializer[0] <= 0 || initializer[1] < 0 )
+                        {
+                            break;
+                        }
+
+                        if ( IsPortActive( pActInfo, EIP_SIZE ) )
+                        {
+                            GetPacket( initializer ).SetArraySize( m_nSlot, std::max( 0, GetPortInt( pActInfo, EIP_SIZE ) ) );
+                            GetPacket( initializer ).NotifyChange();
+                        }
+
+                        if ( IsPortActive( pActInfo, EIP_VALUE ) && GetPortInt( pActInfo, EIP_INDEX ) >= 0 )
+                        {
+                            T1 value;
+
+                            if ( GetPortAny( pActInfo, EIP_VALUE ).GetValueWithConversion( value )
+                                    && GetPacket( initializer ).SetArrayElement( m_nSlot, GetPortInt( pActInfo, EIP_INDEX ), ToOSCWord( value ) ) )
+                            {
+                                GetPacket( initializer ).NotifyChange();
+                            }
+                        }
+
+                        break;
+                }
+            }
+    };
+
+    /**
+    * @brief Streams the world transforms of many entities, changed entities are sent together once per frame.
+    * Every entity becomes one message in a bundle: int32 entity id, float32 position x y z, float32 rotation w x y z.
+    * The bundles are sent right away when the node updates, so the send rate, coalescing, repeat suppression and timetag
+    * settings of the connection don't apply to them. Entities of a bundle that failed to send are sent again on the next update.
+    */
+    class CFlowSendEntityTransformsNode :
+        public CFlowBaseNode<eNCT_Instanced>
+    {
+            enum EInputPorts
+            {
+                EIP_INIT = 0,
+                EIP_MESSAGE,
+                EIP_CLASS,
+                EIP_RESCAN,
+                EIP_ADD,
+                EIP_REMOVE,
+                EIP_CLEAR,
+                EIP_POSDEADBAND,
+                EIP_ROTDEADBAND,
+                EIP_FORCE,
+            };
+
+            enum EOutputPorts
+            {
+                EOP_SENT = 0,
+            };
+
+            enum
+            {
+                MAX_PACKET_SIZE = 8192, //!< bundles are split so they fit into a datagram most receivers accept
+            };
+
+            struct STrackedEntity
+            {
+                EntityId id;
+                bool bSent;
+                Vec3 pos; //!< last sent transform
+                Quat rot;
+            };
+
+            int m_nConnection;
+            std::string m_sMessage;
+            std::vector<STrackedEntity> m_Entities;
+            float m_fPosDeadbandSq;
+            float m_fRotDeadbandDot; //!< cos of half the rotation deadband angle
+            bool m_bForce;
+
+            PacketWriter m_pw;
+            Message m_msg;
+            std::vector<size_t> m_Bundled; //!< entities in the open bundle
+
+            void Track( EntityId id )
+            {
+                for ( std::vector<STrackedEntity>::const_iterator iter = m_Entities.begin(); iter != m_Entities.end(); ++iter )
+                {
+                    if ( ( *iter ).id == id )
+                    {
+                        return;
+                    }
+                }
+
+                STrackedEntity entity;
+                entity.id = id;
+                entity.bSent = false;
+                m_Entities.push_back( entity );
+            }
+
+            void Untrack( EntityId id )
+            {
+                for ( size_t i = 0; i < m_Entities.size(); ++i )
+                {
+                    if ( m_Entities[i].id == id )
+                    {
+                        m_Entities[i] = m_Entities.back();
+                        m_Entities.pop_back();
+                        return;
+                    }
+                }
+            }
+
+            void ScanClass( const string& sClass )
+            {
+                if ( sClass.empty() )
+                {
+                    return;
+                }
+
+                IEntityItPtr pIter = gEnv->pEntitySystem->GetEntityIterator();
+                pIter->MoveFirst();
+
+                while ( !pIter->IsEnd() )
+                {
+                    IEntity* pEntity = pIter->Next();
+
+                    if ( pEntity && pEntity->GetClass() && strcmp( pEntity->GetClass()->GetName(), sClass.c_str() ) == 0 )
+                    {
+                        Track( pEntity->GetId() );
+                    }
+                }
+            }
+
+            void SetDeadband( SActivationInfo* pActInfo )
+            {
+                float fPos = GetPortFloat( pActInfo, EIP_POSDEADBAND );
+                m_fPosDeadbandSq = fPos * fPos;
+                m_fRotDeadbandDot = cosf( DEG2RAD( GetPortFloat( pActInfo, EIP_ROTDEADBAND ) ) * 0.5f );
+            }
+
+            /**
+            * @return number of entities sent
+            */
+            int Flush( COSCConnection& conn )
+            {
+                m_pw.endBundle();
+                int nSent = int( m_Bundled.size() );
+
+                if ( !conn.SendPacket( m_pw.packetData(), m_pw.packetSize() ) )
+                {
+                    for ( size_t i = 0; i < m_Bundled.size(); ++i )
+                    {
+                        m_Entities[m_Bundled[i]].bSent = false;
+                    }
+
+                    nSent = 0;
+                }
+
+                m_Bundled.clear();
+                return nSent;
+            }
+
+            int SendChanged()
+            {
+                COSCConnection* pConn = FindConnection( m_nConnection );
+
+                if ( !pConn )
+                {
+                    return 0;
+                }
+
+                int nSent = 0;
+                bool bOpen = false;
+
+                for ( size_t i = 0; i < m_Entities.size(); )
+                {
+                    STrackedEntity& entity = m_Entities[i];
+                    IEntity* pEntity = gEnv->pEntitySystem->GetEntity( entity.id );
+
+                    if ( !pEntity )
+                    {
+                        // removed from the level
+                        entity = m_Entities.back();
+                        m_Entities.pop_back();
+                        continue;
+                    }
+
+                    ++i;
+
+                    Vec3 pos = pEntity->GetWorldPos();
+                    Quat rot = pEntity->GetWorldRotation();
+
+                    if ( entity.bSent && !m_bForce && ( pos - entity.pos ).GetLengthSquared() <= m_fPosDeadbandSq && fabsf( rot | entity.rot ) >= m_fRotDeadbandDot )
+                    {
+                        continue;
+                    }
+
+                    entity.bSent = true;
+                    entity.pos = pos;
+                    entity.rot = rot;
+
+                    if ( bOpen && m_pw.packetSize() + 64 + m_sMessage.size() > MAX_PACKET_SIZE )
+                    {
+                        nSent += Flush( *pConn );
+                        bOpen = false;
+                    }
+
+                    if ( !bOpen )
+                    {
+                        m_pw.init().startBundle();
+                        bOpen = true;
+                    }
+
+                    m_msg.init( m_sMessage );
+                    m_msg.pushInt32( int32( entity.id ) );
+                    m_msg.pushFloat( pos.x ).pushFloat( pos.y ).pushFloat( pos.z );
+                    m_msg.pushFloat( rot.w ).pushFloat( rot.v.x ).pushFloat( rot.v.y ).pushFloat( rot.v.z );
+                    m_pw.addMessage( m_msg );
+                    m_Bundled.push_back( i - 1 ); // i already moved on to the next entity
+                }
+
+                if ( bOpen )
+                {
+                    nSent += Flush( *pConn );
+                }
+
+                m_bForce = false;
+                return nSent;
+            }
+
+        public:
+            virtual void GetMemoryUsage( ICrySizer* s ) const
+            {
+                s->Add( *this );
+            }
+
+            virtual IFlowNodePtr Clone( SActivationInfo* pActInfo )
+            {
+                return new CFlowSendEntityTransformsNode( pActInfo );
+            }
+
+            CFlowSendEntityTransformsNode( SActivationInfo* pActInfo )
+            {
+                m_nConnection = -1;
+                m_fPosDeadbandSq = 0;
+                m_fRotDeadbandDot = 1;
+                m_bForce = false;
+            }
+
+            virtual void GetConfiguration( SFlowNodeConfig& config )
+            {
+                static const SInputPortConfig inputs[] =
+                {
+                    InputPortConfig<Vec3>( "InitFromConnection", _HELP( "Initialize" ) ),
+                    InputPortConfig<string>( "sMessage", "/entity/transform", _HELP( "Message sent for every entity" ), "sMessage", _UICONFIG( "" ) ),
+                    InputPortConfig<string>( "sClass", "", _HELP( "stream all entities of this class (scanned on Init and Rescan)" ), "sClass", _UICONFIG( "" ) ),
+                    InputPortConfig_Void( "Rescan", _HELP( "add entities of sClass spawned since the last scan" ) ),
+                    InputPortConfig<EntityId>( "Add", _HELP( "stream this entity" ) ),
+                    InputPortConfig<EntityId>( "Remove", _HELP( "stop streaming this entity" ) ),
+                    InputPortConfig_Void( "Clear", _HELP( "stop streaming all entities" ) ),
+                    InputPortConfig<float>( "fPosDeadband", 0.001f, _HELP( "minimum position change in meters before an entity is sent again" ) ),
+                    InputPortConfig<float>( "fRotDeadband", 0.1f, _HELP( "minimum rotation change in degrees before an entity is sent again" ) ),
+                    InputPortConfig_Void( "Force", _HELP( "send all entities in the next frame" ) ),
+                    InputPortConfig_Null(),
+                };
+
+                static const SOutputPortConfig outputs[] =
+                {
+                    OutputPortConfig<int>( "nSent", _HELP( "entities sent this frame" ) ),
+                    OutputPortConfig_Null(),
+                };
+
+                config.pInputPorts = inputs;
+                config.pOutputPorts = outputs;
+                config.sDescription = _HELP( PLUGIN_CONSOLE_PREFIX " Send Entity Transforms" );
+
+                config.SetCategory( EFLN_APPROVED );
+            }
+
+            virtual void ProcessEvent( EFlowEvent evt, SActivationInfo* pActInfo )
+            {
+                switch ( evt )
+                {
+                    case eFE_Activate:
+                        if ( IsPortActive( pActInfo, EIP_INIT ) )
+                        {
+                            m_nConnection = int( GetPortVec3( pActInfo, EIP_INIT )[0] );
+                            m_sMessage = GetPortString( pActInfo, EIP_MESSAGE ).c_str();
+                            m_bForce = true;
+                            SetDeadband( pActInfo );
+                            ScanClass( GetPortString( pActInfo, EIP_CLASS ) );
+                            pActInfo->pGraph->SetRegularlyUpdated( pActInfo->myID, true );
+                        }
+
+                        if ( IsPortActive( pActInfo, EIP_MESSAGE ) )
+                        {
+                            m_sMessage = GetPortString( pActInfo, EIP_MESSAGE ).c_str();
+                        }
+
+                        if ( IsPortActive( pActInfo, EIP_RESCAN ) || IsPortActive( pActInfo, EIP_CLASS ) )
+                        {
+                            ScanClass( GetPortString( pActInfo, EIP_CLASS ) );
+                        }
+
+                        if ( IsPortActive( pActInfo, EIP_CLEAR ) )
+                        {
+                            m_Entities.clear();
+                        }
+
+                        if ( IsPortActive( pActInfo, EIP_ADD ) )
+                        {
+                            Track( GetPortEntityId( pActInfo, EIP_ADD ) );
+                        }
+
+                        if ( IsPortActive( pActInfo, EIP_REMOVE ) )
+                        {
+                            Untrack( GetPortEntityId( pActInfo, EIP_REMOVE ) );
+                        }
+
+                        if ( IsPortActive( pActInfo, EIP_POSDEADBAND ) || IsPortActive( pActInfo, EIP_ROTDEADBAND ) )
+                        {
+                            SetDeadband( pActInfo );
+                        }
+
+                        if ( IsPortActive( pActInfo, EIP_FORCE ) )
+                        {
+                            m_bForce = true;
+                        }
+
+                        break;
+
+                    case eFE_Update:
+                        if ( !m_Entities.empty() )
+                        {
+                            ActivateOutput( pActInfo, EOP_SENT, SendChanged() );
+                        }
+
+                        break;
+                }
+            }
+    };
+
 }
 
 REGISTER_FLOW_NODE_EX( "OSC_Plugin:Connection", OSCPlugin::CFlowConnectionNode, CFlowConnectionNode );
+REGISTER_FLOW_NODE_EX( "OSC_Plugin:Stats", OSCPlugin::CFlowStatsNode, CFlowStatsNode );
 
 REGISTER_FLOW_NODE_EX( "OSC_Plugin:Receive:Message", OSCPlugin::CFlowReceiveMessageNode, CFlowReceiveMessageNode );
 REGISTER_FLOW_NODE_EX( "OSC_Plugin:Receive:Value:Any", OSCPlugin::CFlowReceiveValueNodeAny, CFlowReceiveValueNodeAny );
@@ -1296,11 +1689,16 @@ typedef OSCPlugin::CFlowReceiveValueNode<string, OSCPlugin::OSCT_String> CFlowRe
 REGISTER_FLOW_NODE_EX( "OSC_Plugin:Receive:Value:String", CFlowReceiveValueNodeString, CFlowReceiveValueNodeString );
 typedef OSCPlugin::CFlowReceiveValueNode<bool, OSCPlugin::OSCT_Bool> CFlowReceiveValueNodeBool;
 REGISTER_FLOW_NODE_EX( "OSC_Plugin:Receive:Value:Bool", CFlowReceiveValueNodeBool, CFlowReceiveValueNodeBool );
+typedef OSCPlugin::CFlowReceiveArrayNode<float, OSCPlugin::OSCT_Float32Array> CFlowReceiveArrayNodeFloat32;
+REGISTER_FLOW_NODE_EX( "OSC_Plugin:Receive:Array:Float32", CFlowReceiveArrayNodeFloat32, CFlowReceiveArrayNodeFloat32 );
+typedef OSCPlugin::CFlowReceiveArrayNode<int, OSCPlugin::OSCT_Int32Array> CFlowReceiveArrayNodeInt32;
+REGISTER_FLOW_NODE_EX( "OSC_Plugin:Receive:Array:Int32", CFlowReceiveArrayNodeInt32, CFlowReceiveArrayNodeInt32 );
 
 REGISTER_FLOW_NODE_EX( "OSC_Plugin:Send:Packet", OSCPlugin::CFlowSendPacketNode, CFlowSendPacketNode );
 REGISTER_FLOW_NODE_EX( "OSC_Plugin:Send:Message", OSCPlugin::CFlowSendMessageNode, CFlowSendMessageNode );
 REGISTER_FLOW_NODE_EX( "OSC_Plugin:Send:BundleStart", OSCPlugin::CFlowSendBundleStartNode, CFlowSendBundleStartNode );
 REGISTER_FLOW_NODE_EX( "OSC_Plugin:Send:BundleEnd", OSCPlugin::CFlowSendBundleEndNode, CFlowSendBundleEndNode );
+REGISTER_FLOW_NODE_EX( "OSC_Plugin:Send:EntityTransforms", OSCPlugin::CFlowSendEntityTransformsNode, CFlowSendEntityTransformsNode );
 
 typedef OSCPlugin::CFlowSendValueNode<int, OSCPlugin::OSCT_Int32> CFlowSendValueNodeInt32;
 REGISTER_FLOW_NODE_EX( "OSC_Plugin:Send:Value:Int32", CFlowSendValueNodeInt32, CFlowSendValueNodeInt32 );
@@ -1314,3 +1712,7 @@ typedef OSCPlugin::CFlowSendValueNode<string, OSCPlugin::OSCT_String>  CFlowSend
 REGISTER_FLOW_NODE_EX( "OSC_Plugin:Send:Value:String",  CFlowSendValueNodeString, CFlowSendValueNodeString );
 typedef OSCPlugin::CFlowSendValueNode<bool, OSCPlugin::OSCT_Bool> CFlowSendValueNodeBool;
 REGISTER_FLOW_NODE_EX( "OSC_Plugin:Send:Value:Bool", CFlowSendValueNodeBool, CFlowSendValueNodeBool );
+typedef OSCPlugin::CFlowSendArrayNode<float, OSCPlugin::OSCT_Float32Array> CFlowSendArrayNodeFloat32;
+REGISTER_FLOW_NODE_EX( "OSC_Plugin:Send:Array:Float32", CFlowSendArrayNodeFloat32, CFlowSendArrayNodeFloat32 );
+typedef OSCPlugin::CFlowSendArrayNode<int, OSCPlugin::OSCT_Int32Array> CFlowSendArrayNodeInt32;
+REGISTER_FLOW_NODE_EX( "OSC_Plugin:Send:Array:Int32", CFlowSendArrayNodeInt32, CFlowSendArrayNodeInt32 );
@@ -0,0 +1,67 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#include <StdAfx.h>
+#include <OSCByteSwap.h>
+
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#   include <emmintrin.h>
+#   define OSC_SSE2
+#endif
+
+namespace OSCPlugin
+{
+    namespace
+    {
+        inline bool IsBigEndianHost()
+        {
+            const unsigned int nProbe = 1;
+            return *( const unsigned char* )&nProbe == 0;
+        }
+
+        inline unsigned int Swap32( unsigned int n )
+        {
+            return ( n >> 24 ) | ( ( n >> 8 ) & 0xFF00 ) | ( ( n << 8 ) & 0xFF0000 ) | ( n << 24 );
+        }
+    }
+
+    void OSCCopyNetwork32( void* pDst, const void* pSrc, size_t nCount )
+    {
+        if ( IsBigEndianHost() )
+        {
+            if ( pDst != pSrc )
+            {
+                memmove( pDst, pSrc, nCount * 4 );
+            }
+
+            return;
+        }
+
+        char* pOut = ( char* )pDst;
+        const char* pIn = ( const char* )pSrc;
+        size_t i = 0;
+
+#ifdef OSC_SSE2
+
+        // swap the bytes of each 16 bit half, then the halves of each 32 bit word (SSE2 has no byte shuffle)
+        for ( ; i + 4 <= nCount; i += 4 )
+        {
+            __m128i v = _mm_loadu_si128( ( const __m128i* )( pIn + i * 4 ) );
+            v = _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+            v = _mm_shufflelo_epi16( v, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+            v = _mm_shufflehi_epi16( v, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+            _mm_storeu_si128( ( __m128i* )( pOut + i * 4 ), v );
+        }
+
+#endif
+
+        for ( ; i < nCount; ++i )
+        {
+            unsigned int n;
+            memcpy( &n, pIn + i * 4, 4 );
+            n = Swap32( n );
+            memcpy( pOut + i * 4, &n, 4 );
+        }
+    }
+}
@@ -0,0 +1,16 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <cstddef>
+
+namespace OSCPlugin
+{
+    /**
+    * @brief Copy 32 bit words converting between host and network (big endian) byte order.
+    * Used for the float32/int32 array blobs, 16 bytes at a time with SSE2 where available.
+    * pDst and pSrc may be the same buffer, they don't need to be aligned.
+    * @param nCount number of 32 bit words
+    */
+    void OSCCopyNetwork32( void* pDst, const void* pSrc, size_t nCount );
+}
@@ -0,0 +1,373 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#include <StdAfx.h>
+#include <OSCCapture.h>
+
+#if defined(_MSC_VER) || defined(WIN32)
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <cerrno>
+#endif
+
+#include <cstring>
+
+namespace OSCPlugin
+{
+    namespace
+    {
+        inline size_t RecordSize( const SOSCCaptureRecord& record )
+        {
+            return ( sizeof( SOSCCaptureRecord ) + record.nSenderSize + record.nSize + 7 ) & ~size_t( 7 );
+        }
+    }
+
+    COSCCaptureWriter::COSCCaptureWriter() :
+        m_pFile( NULL ),
+        m_nPackets( 0 )
+    {
+    }
+
+    COSCCaptureWriter::~COSCCaptureWriter()
+    {
+        Close();
+    }
+
+    bool COSCCaptureWriter::Open( const std::string& sPath )
+    {
+        Close();
+        m_sError.clear();
+        m_sPath = sPath;
+        m_nPackets = 0;
+
+        m_pFile = fopen( sPath.c_str(), "wb" );
+
+        if ( !m_pFile )
+        {
+            m_sError = "can't create " + sPath;
+            return false;
+        }
+
+        setvbuf( m_pFile, NULL, _IOFBF, 1024 * 1024 );
+
+        SOSCCaptureHeader header;
+        header.nMagic = OSC_CAPTURE_MAGIC;
+        header.nVersion = OSC_CAPTURE_VERSION;
+        header.nCreated = GetOSCWallClockNs();
+
+        if ( fwrite( &header, sizeof( header ), 1, m_pFile ) != 1 )
+        {
+            m_sError = "can't write " + sPath;
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void COSCCaptureWriter::Close()
+    {
+        if ( m_pFile )
+        {
+            fclose( m_pFile );
+            m_pFile = NULL;
+        }
+    }
+
+    bool COSCCaptureWriter::Write( uint64 nTimestamp, const std::string& sSender, const void* pData, size_t nSize )
+    {
+        if ( !m_pFile )
+        {
+            return false;
+        }
+
+        SOSCCaptureRecord record;
+        record.nTimestamp = nTimestamp;
+        record.nSize = ( unsigned int )nSize;
+        record.nSenderSize = ( unsigned short )std::min<size_t>( sSender.size(), 0xFFFF );
+        record.nReserved = 0;
+
+        static const char padding[8] = { 0 };
+        size_t nPadding = RecordSize( record ) - sizeof( record ) - record.nSenderSize - nSize;
+
+        if ( fwrite( &record, sizeof( record ), 1, m_pFile ) != 1
+                || fwrite( sSender.data(), 1, record.nSenderSize, m_pFile ) != record.nSenderSize
+                || fwrite( pData, 1, nSize, m_pFile ) != nSize
+                || fwrite( padding, 1, nPadding, m_pFile ) != nPadding )
+        {
+            m_sError = "can't write " + m_sPath;
+            Close();
+            return false;
+        }
+
+        ++m_nPackets;
+        return true;
+    }
+
+    COSCCaptureFile::COSCCaptureFile() :
+        m_pData( NULL ),
+        m_nSize( 0 )
+    {
+#if defined(_MSC_VER) || defined(WIN32)
+        m_hFile = INVALID_HANDLE_VALUE;
+        m_hMapping = NULL;
+#else
+        m_nHandle = -1;
+#endif
+    }
+
+    COSCCaptureFile::~COSCCaptureFile()
+    {
+        Close();
+    }
+
+    bool COSCCaptureFile::Open( const std::string& sPath )
+    {
+        Close();
+        m_sError.clear();
+
+#if defined(_MSC_VER) || defined(WIN32)
+        m_hFile = CreateFileA( sPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+
+        if ( m_hFile == INVALID_HANDLE_VALUE )
+        {
+            m_sError = "can't open " + sPath;
+            return false;
+        }
+
+        LARGE_INTEGER nFileSize;
+        GetFileSizeEx( m_hFile, &nFileSize );
+        m_nSize = ( size_t )nFileSize.QuadPart;
+
+        if ( m_nSize >= sizeof( SOSCCaptureHeader ) )
+        {
+            m_hMapping = CreateFileMappingA( m_hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+            m_pData = m_hMapping ? ( const char* )MapViewOfFile( m_hMapping, FILE_MAP_READ, 0, 0, 0 ) : NULL;
+        }
+
+#else
+        m_nHandle = open( sPath.c_str(), O_RDONLY );
+
+        if ( m_nHandle == -1 )
+        {
+            m_sError = "can't open " + sPath + ": " + strerror( errno );
+            return false;
+        }
+
+        struct stat st;
+
+        if ( fstat( m_nHandle, &st ) != 0 )
+        {
+            m_sError = strerror( errno );
+            Close();
+            return false;
+        }
+
+        m_nSize = st.st_size;
+
+        if ( m_nSize >= sizeof( SOSCCaptureHeader ) )
+        {
+            void* pMemory = mmap( 0, m_nSize, PROT_READ, MAP_PRIVATE, m_nHandle, 0 );
+
+            if ( pMemory != MAP_FAILED )
+            {
+                madvise( pMemory, m_nSize, MADV_SEQUENTIAL );
+                m_pData = ( const char* )pMemory;
+            }
+        }
+
+#endif
+
+        if ( !m_pData )
+        {
+            m_sError = "can't map " + sPath;
+            Close();
+            return false;
+        }
+
+        const SOSCCaptureHeader* pHeader = ( const SOSCCaptureHeader* )m_pData;
+
+        if ( pHeader->nMagic != OSC_CAPTURE_MAGIC || pHeader->nVersion != OSC_CAPTURE_VERSION )
+        {
+            m_sError = sPath + " is no capture file (or was written with another byte order or version)";
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void COSCCaptureFile::Close()
+    {
+#if defined(_MSC_VER) || defined(WIN32)
+
+        if ( m_pData )
+        {
+            UnmapViewOfFile( m_pData );
+        }
+
+        if ( m_hMapping )
+        {
+            CloseHandle( m_hMapping );
+            m_hMapping = NULL;
+        }
+
+        if ( m_hFile != INVALID_HANDLE_VALUE )
+        {
+            CloseHandle( m_hFile );
+            m_hFile = INVALID_HANDLE_VALUE;
+        }
+
+#else
+
+        if ( m_pData )
+        {
+            munmap( ( void* )m_pData, m_nSize );
+        }
+
+        if ( m_nHandle != -1 )
+        {
+            ::close( m_nHandle );
+            m_nHandle = -1;
+        }
+
+#endif
+        m_pData = NULL;
+        m_nSize = 0;
+    }
+
+    bool COSCCaptureFile::Next( size_t& nOffset, const SOSCCaptureRecord*& pRecord, const char*& pSender, const void*& pData ) const
+    {
+        if ( !m_pData || nOffset + sizeof( SOSCCaptureRecord ) > m_nSize )
+        {
+            return false;
+        }
+
+        pRecord = ( const SOSCCaptureRecord* )( m_pData + nOffset );
+
+        // a capture that was still being written can end in the middle of a record
+        if ( nOffset + sizeof( SOSCCaptureRecord ) + pRecord->nSenderSize + pRecord->nSize > m_nSize )
+        {
+            return false;
+        }
+
+        pSender = m_pData + nOffset + sizeof( SOSCCaptureRecord );
+        pData = pSender + pRecord->nSenderSize;
+        nOffset += RecordSize( *pRecord );
+        return true;
+    }
+
+    COSCReplayTransport::COSCReplayTransport( float fSpeed ) :
+        m_fSpeed( fSpeed ),
+        m_nOffset( 0 ),
+        m_nStart( 0 ),
+        m_nFirst( 0 ),
+        m_pRecord( NULL ),
+        m_pSender( NULL ),
+        m_pData( NULL ),
+        m_nTimestamp( 0 ),
+        m_pPacket( NULL ),
+        m_nPacketSize( 0 )
+    {
+    }
+
+    bool COSCReplayTransport::Open( const std::string& sHost, int /* nPort */, bool /* bServer */ )
+    {
+        Close();
+
+        if ( !m_File.Open( sHost ) )
+        {
+            return false;
+        }
+
+        m_nOffset = m_File.Begin();
+
+        if ( !m_File.Next( m_nOffset, m_pRecord, m_pSender, m_pData ) )
+        {
+            m_pRecord = NULL;
+        }
+
+        m_nFirst = m_pRecord ? m_pRecord->nTimestamp : 0;
+        m_nStart = GetOSCWallClockNs();
+        return true;
+    }
+
+    void COSCReplayTransport::Close()
+    {
+        m_File.Close();
+        m_pRecord = NULL;
+        m_pPacket = NULL;
+        m_nPacketSize = 0;
+    }
+
+    uint64 COSCReplayTransport::GetDueTime( const SOSCCaptureRecord* pRecord ) const
+    {
+        if ( m_fSpeed <= 0 || pRecord->nTimestamp <= m_nFirst )
+        {
+            return m_nStart;
+        }
+
+        return m_nStart + uint64( double( pRecord->nTimestamp - m_nFirst ) / m_fSpeed );
+    }
+
+    bool COSCReplayTransport::ReceiveNextPacket()
+    {
+        if ( !m_pRecord )
+        {
+            return false;
+        }
+
+        uint64 nNow = GetOSCWallClockNs();
+        uint64 nDue = GetDueTime( m_pRecord );
+
+        if ( nDue > nNow )
+        {
+            return false;
+        }
+
+        // arrival as it would have been at this pacing, so stalls show up in the latency histograms
+        m_nTimestamp = m_fSpeed > 0 ? nDue : nNow;
+        m_sSender.assign( m_pSender, m_pRecord->nSenderSize );
+        m_pPacket = m_pData;
+        m_nPacketSize = m_pRecord->nSize;
+
+        if ( !m_File.Next( m_nOffset, m_pRecord, m_pSender, m_pData ) )
+        {
+            m_pRecord = NULL;
+        }
+
+        return true;
+    }
+
+    bool COSCReplayTransport::WaitForPacket( int nTimeoutMs )
+    {
+        if ( !m_pRecord )
+        {
+            return false;
+        }
+
+        uint64 nNow = GetOSCWallClockNs();
+        uint64 nDue = GetDueTime( m_pRecord );
+
+        if ( nDue > nNow )
+        {
+            uint64 nWaitMs = ( nDue - nNow + 999999 ) / 1000000;
+
+            if ( nTimeoutMs >= 0 && nWaitMs > uint64( nTimeoutMs ) )
+            {
+                CrySleep( nTimeoutMs );
+                return false;
+            }
+
+            CrySleep( ( unsigned int )nWaitMs );
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,212 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <OSCTransport.h>
+
+#include <cstdio>
+#include <string>
+
+namespace OSCPlugin
+{
+    /**
+    * @brief Header of a capture file, everything is in host byte order (a file from a machine with another byte order is rejected).
+    * Followed by records: SOSCCaptureRecord, sender text, packet data, padded to 8 bytes.
+    */
+    struct SOSCCaptureHeader
+    {
+        unsigned int nMagic;
+        unsigned int nVersion;
+        uint64 nCreated; //!< see GetOSCWallClockNs
+    };
+
+    struct SOSCCaptureRecord
+    {
+        uint64 nTimestamp; //!< arrival time, kernel timestamp if the transport had one
+        unsigned int nSize; //!< of the packet
+        unsigned short nSenderSize; //!< of the sender text (ip:port), not terminated
+        unsigned short nReserved;
+    };
+
+    enum
+    {
+        OSC_CAPTURE_MAGIC = 0x4F534343, //!< 'OSCC'
+        OSC_CAPTURE_VERSION = 1,
+    };
+
+    /**
+    * @brief Appends received packets to a capture file, buffered so recording costs a memcpy per packet
+    */
+    class COSCCaptureWriter
+    {
+            FILE* m_pFile;
+            std::string m_sPath;
+            std::string m_sError;
+            uint64 m_nPackets;
+
+        public:
+            COSCCaptureWriter();
+            ~COSCCaptureWriter();
+
+            bool Open( const std::string& sPath );
+            void Close();
+
+            bool IsOpen() const
+            {
+                return m_pFile != NULL;
+            }
+
+            const std::string& GetError() const
+            {
+                return m_sError;
+            }
+
+            const std::string& GetPath() const
+            {
+                return m_sPath;
+            }
+
+            uint64 GetPacketCount() const
+            {
+                return m_nPackets;
+            }
+
+            /**
+            * @return false if writing failed, the file is closed then
+            */
+            bool Write( uint64 nTimestamp, const std::string& sSender, const void* pData, size_t nSize );
+    };
+
+    /**
+    * @brief Read only memory mapping of a capture file
+    */
+    class COSCCaptureFile
+    {
+            const char* m_pData;
+            size_t m_nSize;
+            std::string m_sError;
+
+#if defined(_MSC_VER) || defined(WIN32)
+            void* m_hFile;
+            void* m_hMapping;
+#else
+            int m_nHandle;
+#endif
+
+        public:
+            COSCCaptureFile();
+            ~COSCCaptureFile();
+
+            bool Open( const std::string& sPath );
+            void Close();
+
+            const std::string& GetError() const
+            {
+                return m_sError;
+            }
+
+            /**
+            * @brief Offset of the first record
+            */
+            size_t Begin() const
+            {
+                return sizeof( SOSCCaptureHeader );
+            }
+
+            /**
+            * @brief Read the record at nOffset, pointers stay valid until Close
+            * @param nOffset advanced to the next record
+            * @return false at the end of the file or if the record is truncated
+            */
+            bool Next( size_t& nOffset, const SOSCCaptureRecord*& pRecord, const char*& pSender, const void*& pData ) const;
+    };
+
+    /**
+    * @brief Transport that plays a capture file back instead of receiving from a socket.
+    * Packets are released at their original pacing scaled by the speed, sends are dropped.
+    */
+    class COSCReplayTransport : public IOSCTransport
+    {
+            COSCCaptureFile m_File;
+            float m_fSpeed;
+            size_t m_nOffset;
+            uint64 m_nStart; //!< wall clock time the replay started
+            uint64 m_nFirst; //!< timestamp of the first record
+
+            const SOSCCaptureRecord* m_pRecord; //!< next record, NULL at the end
+            const char* m_pSender;
+            const void* m_pData;
+
+            uint64 m_nTimestamp; //!< replayed arrival time of the current packet
+            std::string m_sSender;
+            const void* m_pPacket;
+            size_t m_nPacketSize;
+
+            uint64 GetDueTime( const SOSCCaptureRecord* pRecord ) const;
+
+        public:
+            /**
+            * @param fSpeed 1 original pacing, 2 twice as fast, 0 as fast as possible
+            */
+            COSCReplayTransport( float fSpeed );
+
+            /**
+            * @brief All packets have been played back
+            */
+            bool IsFinished() const
+            {
+                return m_pRecord == NULL;
+            }
+
+            // IOSCTransport, sHost is the path of the capture file
+            bool Open( const std::string& sHost, int nPort, bool bServer );
+            void Close();
+
+            bool IsOk() const
+            {
+                return m_File.GetError().empty();
+            }
+
+            std::string GetErrorMessage() const
+            {
+                return m_File.GetError();
+            }
+
+            bool ReceiveNextPacket();
+
+            const void* GetPacketData() const
+            {
+                return m_pPacket;
+            }
+
+            size_t GetPacketSize() const
+            {
+                return m_nPacketSize;
+            }
+
+            uint64 GetPacketTimestamp() const
+            {
+                return m_nTimestamp;
+            }
+
+            std::string GetPacketSender() const
+            {
+                return m_sSender;
+            }
+
+            bool WaitForPacket( int nTimeoutMs );
+
+            /**
+            * @brief Dropped on purpose, a replayed server has nobody to answer, so this isn't a send failure
+            */
+            bool SendPacket( const void* /* pData */, size_t /* nSize */ )
+            {
+                return true;
+            }
+
+            void Release()
+            {
+                delete this;
+            }
+    };
+}
@@ -0,0 +1,77 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#include <StdAfx.h>
+#include <OSCCoalescer.h>
+
+#include <cstring>
+
+namespace OSCPlugin
+{
+    namespace
+    {
+        const size_t BUNDLE_HEADER_SIZE = 16; //!< "#bundle\0" and the timetag
+        const size_t ELEMENT_HEADER_SIZE = 4; //!< int32 size
+
+        const char BUNDLE_HEADER[BUNDLE_HEADER_SIZE] = { '#', 'b', 'u', 'n', 'd', 'l', 'e', 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+    }
+
+    COSCCoalescer::COSCCoalescer()
+    {
+        m_nMaxSize = 0;
+        m_nElements = 0;
+    }
+
+    bool COSCCoalescer::Add( const void* pData, size_t nSize )
+    {
+        size_t nUsed = m_nElements ? m_Data.size() : BUNDLE_HEADER_SIZE;
+
+        if ( nUsed + ELEMENT_HEADER_SIZE + nSize > m_nMaxSize )
+        {
+            return false;
+        }
+
+        if ( !m_nElements )
+        {
+            m_Data.assign( BUNDLE_HEADER, BUNDLE_HEADER + BUNDLE_HEADER_SIZE );
+        }
+
+        size_t nOffset = m_Data.size();
+        m_Data.resize( nOffset + ELEMENT_HEADER_SIZE + nSize );
+
+        char* pElement = &m_Data[nOffset];
+        pElement[0] = char( ( nSize >> 24 ) & 0xFF );
+        pElement[1] = char( ( nSize >> 16 ) & 0xFF );
+        pElement[2] = char( ( nSize >> 8 ) & 0xFF );
+        pElement[3] = char( nSize & 0xFF );
+        memcpy( pElement + ELEMENT_HEADER_SIZE, pData, nSize );
+
+        ++m_nElements;
+        return true;
+    }
+
+    const void* COSCCoalescer::GetData() const
+    {
+        if ( m_nElements == 1 )
+        {
+            return &m_Data[BUNDLE_HEADER_SIZE + ELEMENT_HEADER_SIZE];
+        }
+
+        return m_nElements ? &m_Data[0] : NULL;
+    }
+
+    size_t COSCCoalescer::GetSize() const
+    {
+        if ( m_nElements == 1 )
+        {
+            return m_Data.size() - BUNDLE_HEADER_SIZE - ELEMENT_HEADER_SIZE;
+        }
+
+        return m_nElements ? m_Data.size() : 0;
+    }
+
+    void COSCCoalescer::Clear()
+    {
+        m_Data.clear();
+        m_nElements = 0;
+    }
+}
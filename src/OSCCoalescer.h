@@ -0,0 +1,65 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace OSCPlugin
+{
+    enum
+    {
+        OSC_COALESCE_UDP_SIZE = 1472, //!< largest datagram that fits a 1500 byte Ethernet MTU without fragmentation (IPv4)
+    };
+
+    /**
+    * @brief Groups encoded packets for one destination into a top-level bundle with immediate timetag.
+    * The packets are copied as bundle elements unchanged, so their own bundles and timetags stay nested inside.
+    */
+    class COSCCoalescer
+    {
+            std::vector<char> m_Data; //!< "#bundle", timetag and the elements
+            size_t m_nMaxSize;
+            int m_nElements;
+
+        public:
+            COSCCoalescer();
+
+            /**
+            * @param nMaxSize of the datagrams built, 0 disables coalescing
+            */
+            void SetMaxSize( size_t nMaxSize )
+            {
+                m_nMaxSize = nMaxSize;
+            }
+
+            size_t GetMaxSize() const
+            {
+                return m_nMaxSize;
+            }
+
+            bool IsEmpty() const
+            {
+                return m_nElements == 0;
+            }
+
+            /**
+            * @return false if the packet doesn't fit, send and Clear what was added and try again;
+            * if it still doesn't fit the packet alone is larger than the limit and has to be sent by itself
+            */
+            bool Add( const void* pData, size_t nSize );
+
+            /**
+            * @brief The datagram to send, a single packet is not wrapped
+            */
+            const void* GetData() const;
+            size_t GetSize() const;
+
+            int GetPacketCount() const
+            {
+                return m_nElements;
+            }
+
+            void Clear();
+    };
+}
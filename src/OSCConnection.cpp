@@ -0,0 +1,2018 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#include <StdAfx.h>
+#include <OSCConnection.h>
+#include <OSCByteSwap.h>
+#include <OSCCapture.h>
+#include <OSCSendScheduler.h>
+#include <OSCTrace.h>
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace oscpkt;
+
+namespace OSCPlugin
+{
+    int g_nOSCMaxPacketsPerUpdate = 0;
+    float g_fOSCStatsInterval = 0;
+    float g_fOSCLogInterval = 5;
+    int g_nOSCMaxPeers = 1024;
+
+    namespace
+    {
+        TOSCLogHandler g_pOSCLogHandler = NULL;
+
+        std::map<SOSCConnectionKey, COSCConnection*> g_OSCConnectionPool; //!< open sockets, reference counted
+        std::map<int, COSCConnection*> g_OSCConnections; //!< handle of a Connection node -> pooled connection
+        int g_nFreeConnection = 1;
+        unsigned int g_nPoolGeneration = 1; //!< changed whenever a connection is added to or removed from the pool or gets a new transport
+
+        int64 g_nTimeTagFrame = -1;
+        uint64 g_nTimeTagFrameNs = 0; //!< start of g_nTimeTagFrame, shared by all connections
+
+        inline bool IsLoopbackHost( const std::string& sHost )
+        {
+            return sHost == "localhost" || sHost == "::1" || strncmp( sHost.c_str(), "127.", 4 ) == 0;
+        }
+
+        /**
+        * @brief FNV-1a, only compared against the last send of the same packet
+        */
+        uint64 HashPacket( const void* pData, size_t nSize )
+        {
+            const unsigned char* pBytes = ( const unsigned char* )pData;
+            uint64 nHash = 14695981039346656037ULL;
+
+            for ( size_t i = 0; i < nSize; ++i )
+            {
+                nHash ^= pBytes[i];
+                nHash *= 1099511628211ULL;
+            }
+
+            return nHash;
+        }
+
+        /**
+        * @brief IOSCArgs on top of a parsed message, remembers its position so reading in order doesn't rescan
+        */
+        class COSCArgs :
+            public IOSCArgs
+        {
+                const Message& m_msg;
+                mutable Message::ArgReader m_arg; //!< positioned on argument m_nArg
+                mutable int m_nArg;
+
+                /**
+                * @return reader positioned on nArg if it exists and has the type tag cType
+                */
+                Message::ArgReader* Seek( int nArg, char cType ) const
+                {
+                    if ( nArg < 0 || nArg >= GetCount() || m_msg.typeTags()[nArg] != cType )
+                    {
+                        return NULL;
+                    }
+
+                    if ( nArg < m_nArg )
+                    {
+                        m_arg = m_msg.arg();
+                        m_nArg = 0;
+                    }
+
+                    for ( ; m_nArg < nArg; ++m_nArg )
+                    {
+                        m_arg.pop();
+                    }
+
+                    ++m_nArg; // the caller pops it
+                    return &m_arg;
+                }
+
+            public:
+                COSCArgs( const Message& msg ) :
+                    m_msg( msg ),
+                    m_arg( msg.arg() )
+                {
+                    m_nArg = 0;
+                }
+
+                const char* GetAddress() const
+                {
+                    return m_msg.addressPattern().c_str();
+                }
+
+                const char* GetTypeTags() const
+                {
+                    return m_msg.typeTags().c_str();
+                }
+
+                int GetCount() const
+                {
+                    return int( m_msg.typeTags().size() );
+                }
+
+                uint64 GetTimeTag() const
+                {
+                    return m_msg.timeTag();
+                }
+
+                bool GetInt32( int nArg, int32& nValue ) const
+                {
+                    Message::ArgReader* pArg = Seek( nArg, TYPE_TAG_INT32 );
+                    int32_t n = 0;
+                    return pArg && pArg->popInt32( n ) && ( nValue = n, true );
+                }
+
+                bool GetInt64( int nArg, int64& nValue ) const
+                {
+                    Message::ArgReader* pArg = Seek( nArg, TYPE_TAG_INT64 );
+                    int64_t n = 0;
+                    return pArg && pArg->popInt64( n ) && ( nValue = n, true );
+                }
+
+                bool GetFloat( int nArg, float& fValue ) const
+                {
+                    Message::ArgReader* pArg = Seek( nArg, TYPE_TAG_FLOAT );
+                    return pArg && pArg->popFloat( fValue );
+                }
+
+                bool GetDouble( int nArg, double& fValue ) const
+                {
+                    Message::ArgReader* pArg = Seek( nArg, TYPE_TAG_DOUBLE );
+                    return pArg && pArg->popDouble( fValue );
+                }
+
+                bool GetBool( int nArg, bool& bValue ) const
+                {
+                    Message::ArgReader* pArg = Seek( nArg, TYPE_TAG_TRUE );
+
+                    if ( !pArg )
+                    {
+                        pArg = Seek( nArg, TYPE_TAG_FALSE );
+                    }
+
+                    return pArg && pArg->popBool( bValue );
+                }
+
+                bool GetString( int nArg, const char*& sValue ) const
+                {
+                    Message::ArgReader* pArg = Seek( nArg, TYPE_TAG_STRING );
+                    return pArg && pArg->popStr( sValue );
+                }
+
+                bool GetBlob( int nArg, const void*& pData, size_t& nSize ) const
+                {
+                    Message::ArgReader* pArg = Seek( nArg, TYPE_TAG_BLOB );
+                    return pArg && pArg->popBlob( pData, nSize );
+                }
+        };
+    }
+
+    void SetOSCLogHandler( TOSCLogHandler pHandler )
+    {
+        g_pOSCLogHandler = pHandler;
+    }
+
+    void OSCLog( eOSCLogLevel eLevel, const char* sFormat, ... )
+    {
+        char sMessage[1024];
+        va_list args;
+        va_start( args, sFormat );
+        vsnprintf( sMessage, sizeof( sMessage ), sFormat, args );
+        va_end( args );
+        sMessage[sizeof( sMessage ) - 1] = 0;
+
+        if ( g_pOSCLogHandler )
+        {
+            g_pOSCLogHandler( eLevel, sMessage );
+        }
+
+        else
+        {
+            fprintf( stderr, "%s%s\n", eLevel == OSCLL_Error ? "[Error] " : eLevel == OSCLL_Warning ? "[Warning] " : "", sMessage );
+        }
+    }
+
+    void COSCMessage::InvalidateValues( IOSCValueSink* pSink )
+    {
+        for ( std::list<SOSCValueInfo>::iterator iter = m_OSCValues.begin(); iter != m_OSCValues.end(); ++iter )
+        {
+            if ( ( *iter ).pSink == pSink )
+            {
+                ( *iter ).pSink = NULL;
+            }
+        }
+    }
+
+    namespace
+    {
+        inline bool IsNumeric( eOSCType type )
+        {
+            return type == OSCT_Int32 || type == OSCT_Int64 || type == OSCT_Float32 || type == OSCT_Double64;
+        }
+    }
+
+    bool COSCMessage::Receive( Message& msg, SOSCStats& stats, COSCJitterBuffer* pJitter, uint64 nArrival ) const
+    {
+        bool bMatch;
+
+        {
+            OSC_TRACE_SCOPE( "Match" );
+            bMatch = msg.match( m_sMessage );
+        }
+
+        if ( bMatch )
+        {
+            OSC_TRACE_SCOPE( "ActivatePorts" );
+            std::list<SOSCValueInfo>::const_iterator iter;
+
+            Message::ArgReader arg( msg );
+
+            if ( pJitter )
+            {
+                pJitter->GetInput().clear();
+            }
+
+            for ( iter = m_OSCValues.begin(); iter != m_OSCValues.end(); ++iter )
+            {
+                if ( arg.nbArgRemaining() && arg.isOk() )
+                {
+                    IOSCValueSink* pSink = ( *iter ).pSink;
+
+                    if ( pJitter && IsNumeric( ( *iter ).type ) )
+                    {
+                        // every numeric value is a channel, so Output finds them in the same order
+                        float dat = 0;
+
+                        if ( arg.isFloat() )
+                        {
+                            arg.popFloat( dat );
+                        }
+
+                        else if ( arg.isDouble() )
+                        {
+                            double d;
+                            arg.popDouble( d );
+                            dat = float( d );
+                        }
+
+                        else if ( arg.isInt32() )
+                        {
+                            int32_t n;
+                            arg.popInt32( n );
+                            dat = float( n );
+                        }
+
+                        else if ( arg.isInt64() )
+                        {
+                            int64_t n;
+                            arg.popInt64( n );
+                            dat = float( n );
+                        }
+
+                        else
+                        {
+                            goto WrongType;
+                        }
+
+                        pJitter->GetInput().push_back( dat );
+                        continue;
+                    }
+
+                    if ( !pSink )
+                    {
+                        arg.pop();
+                        continue;
+                    }
+
+                    switch ( ( *iter ).type )
+                    {
+                        case OSCT_Any:
+                            {
+                                arg.pop();
+                                break;
+                            }
+
+                        case OSCT_String:
+                            {
+                                if ( arg.isStr() )
+                                {
+                                    const char* dat;
+                                    arg.popStr( dat );
+                                    pSink->OnOSCValue( ( *iter ).nPort, dat );
+                                    break;
+                                }
+
+                                goto WrongType;
+                            }
+
+                        case OSCT_Int32:
+                            {
+                                if ( arg.isInt32() )
+                                {
+                                    int dat;
+                                    arg.popInt32( dat );
+                                    pSink->OnOSCValue( ( *iter ).nPort, dat );
+                                    break;
+                                }
+
+                                goto WrongType;
+                            }
+
+                        case OSCT_Int64:
+                            {
+                                if ( arg.isInt64() )
+                                {
+                                    int64_t dat;
+                                    arg.popInt64( dat );
+                                    pSink->OnOSCValue( ( *iter ).nPort, int( dat ) );
+
+                                    // full precision as text on the port after Value
+                                    char sExact[32];
+                                    snprintf( sExact, sizeof( sExact ), "%lld", ( long long )dat );
+                                    pSink->OnOSCValue( ( *iter ).nPort + 1, sExact );
+                                    break;
+                                }
+
+                                goto WrongType;
+                            }
+
+                        case OSCT_Float32:
+                            {
+                                if ( arg.isFloat() )
+                                {
+                                    float dat;
+                                    arg.popFloat( dat );
+                                    pSink->OnOSCValue( ( *iter ).nPort, dat );
+                                    break;
+                                }
+
+                                goto WrongType;
+                            }
+
+                        case OSCT_Double64:
+                            {
+                                if ( arg.isDouble() )
+                                {
+                                    double dat;
+                                    arg.popDouble( dat );
+                                    pSink->OnOSCValue( ( *iter ).nPort, float( dat ) );
+
+                                    char sExact[32];
+                                    snprintf( sExact, sizeof( sExact ), "%.17g", dat );
+                                    pSink->OnOSCValue( ( *iter ).nPort + 1, sExact );
+                                    break;
+                                }
+
+                                goto WrongType;
+                            }
+
+                        case OSCT_Float32Array:
+                        case OSCT_Int32Array:
+                            {
+                                if ( arg.isBlob() )
+                                {
+                                    // straight from the parsed message into the sink, converting on the way
+                                    const void* pBlob;
+                                    size_t nBytes;
+                                    arg.popBlob( pBlob, nBytes );
+
+                                    std::vector<uint32>& words = *( *iter ).pArray;
+                                    words.resize( nBytes / 4 );
+
+                                    if ( !words.empty() )
+                                    {
+                                        OSCCopyNetwork32( &words[0], pBlob, words.size() );
+                                    }
+
+                                    pSink->OnOSCValue( ( *iter ).nPort, int( words.size() ) );
+                                    break;
+                                }
+
+                                goto WrongType;
+                            }
+
+                        case OSCT_Bool:
+                            {
+                                if ( arg.isBool() )
+                                {
+                                    bool dat;
+                                    arg.popBool( dat );
+                                    pSink->OnOSCValue( ( *iter ).nPort, dat );
+                                    break;
+                                }
+
+                                goto WrongType;
+                            }
+                    }
+                }
+            }
+
+            if ( pJitter )
+            {
+                pJitter->Push( nArrival );
+            }
+
+            return true;
+        }
+
+        return false;
+WrongType:
+        ++stats.nTypeMismatches;
+        return true;
+    }
+
+    void COSCMessage::Output( const float* pValues ) const
+    {
+        OSC_TRACE_SCOPE( "ActivatePorts" );
+        int nChannel = 0;
+
+        for ( std::list<SOSCValueInfo>::const_iterator iter = m_OSCValues.begin(); iter != m_OSCValues.end(); ++iter )
+        {
+            if ( !IsNumeric( ( *iter ).type ) )
+            {
+                continue;
+            }
+
+            float fValue = pValues[nChannel++];
+            IOSCValueSink* pSink = ( *iter ).pSink;
+
+            if ( !pSink )
+            {
+                continue;
+            }
+
+            switch ( ( *iter ).type )
+            {
+                case OSCT_Int32:
+                    pSink->OnOSCValue( ( *iter ).nPort, int( floor( fValue + 0.5f ) ) );
+                    break;
+
+                case OSCT_Int64:
+                    {
+                        // interpolated, so the exact text has no more precision than the value
+                        char sExact[32];
+                        snprintf( sExact, sizeof( sExact ), "%.0f", fValue );
+                        pSink->OnOSCValue( ( *iter ).nPort, int( floor( fValue + 0.5f ) ) );
+                        pSink->OnOSCValue( ( *iter ).nPort + 1, sExact );
+                        break;
+                    }
+
+                case OSCT_Double64:
+                    {
+                        char sExact[32];
+                        snprintf( sExact, sizeof( sExact ), "%.9g", fValue );
+                        pSink->OnOSCValue( ( *iter ).nPort, fValue );
+                        pSink->OnOSCValue( ( *iter ).nPort + 1, sExact );
+                        break;
+                    }
+
+                default:
+                    pSink->OnOSCValue( ( *iter ).nPort, fValue );
+                    break;
+            }
+        }
+    }
+
+    int COSCPacket::AddValue( int nMessage, eOSCType type )
+    {
+        assert( nMessage >= 0 );
+        assert( nMessage < m_Program.size() );
+        assert( m_Program[nMessage].op == OSCOP_Message );
+
+        // keep the values of every message contiguous, later ranges move up by one
+        SOSCOp& message = m_Program[nMessage];
+        int nValue = message.nFirstValue + message.nValues;
+
+        for ( std::vector<SOSCOp>::iterator iter = m_Program.begin(); iter != m_Program.end(); ++iter )
+        {
+            if ( &( *iter ) != &message && ( *iter ).nFirstValue >= nValue )
+            {
+                ++( *iter ).nFirstValue;
+            }
+        }
+
+        for ( std::vector<int>::iterator iter = m_SlotValues.begin(); iter != m_SlotValues.end(); ++iter )
+        {
+            if ( *iter >= nValue )
+            {
+                ++( *iter );
+            }
+        }
+
+        ++message.nValues;
+        m_Types.insert( m_Types.begin() + nValue, ( unsigned char )type );
+        m_Ints.insert( m_Ints.begin() + nValue, 0 );
+        m_Floats.insert( m_Floats.begin() + nValue, 0.0 );
+        m_Strings.insert( m_Strings.begin() + nValue, std::string() );
+        m_Arrays.insert( m_Arrays.begin() + nValue, std::vector<uint32>() );
+
+        m_SlotValues.push_back( nValue );
+        return m_SlotValues.size() - 1;
+    }
+
+    void COSCPacket::SetValueExact( int nSlot, const char* sValue )
+    {
+        switch ( m_Types[m_SlotValues[nSlot]] )
+        {
+            case OSCT_Int64:
+                {
+                    long long nValue = 0;
+                    sscanf( sValue, "%lld", &nValue );
+                    SetValue( nSlot, int64( nValue ) );
+                    break;
+                }
+
+            case OSCT_Double64:
+                SetValue( nSlot, strtod( sValue, NULL ) );
+                break;
+
+            default:
+                SetValue( nSlot, sValue );
+                break;
+        }
+    }
+
+    bool COSCPacket::SetArrayElement( int nSlot, size_t nIndex, uint32 nWord )
+    {
+        if ( nIndex >= size_t( MAX_ARRAY_ELEMENTS ) )
+        {
+            OSCLog( OSCLL_Warning, "array element %u rejected, arrays hold at most %d elements", unsigned( nIndex ), int( MAX_ARRAY_ELEMENTS ) );
+            return false;
+        }
+
+        std::vector<uint32>& words = m_Arrays[m_SlotValues[nSlot]];
+
+        if ( nIndex >= words.size() )
+        {
+            words.resize( nIndex + 1 );
+        }
+
+        words[nIndex] = nWord;
+        return true;
+    }
+
+    void COSCPacket::Clear()
+    {
+        m_bSend = false;
+        m_bAutoSend = true;
+        m_Program.clear();
+        m_Addresses.clear();
+        m_Types.clear();
+        m_Ints.clear();
+        m_Floats.clear();
+        m_Strings.clear();
+        m_Arrays.clear();
+        m_SlotValues.clear();
+    }
+
+    bool COSCPacket::Encode( PacketWriter& pw, uint64 nTimeTag )
+    {
+        if ( !m_bSend )
+        {
+            return false;
+        }
+
+        OSC_TRACE_SCOPE( "Encode" );
+        m_bSend = false;
+        pw.init();
+
+        for ( std::vector<SOSCOp>::const_iterator iter = m_Program.begin(); iter != m_Program.end(); ++iter )
+        {
+            switch ( ( *iter ).op )
+            {
+                case OSCOP_BundleStart:
+                    pw.startBundle( TimeTag( nTimeTag ) );
+                    break;
+
+                case OSCOP_BundleEnd:
+                    pw.endBundle();
+                    break;
+
+                case OSCOP_Message:
+                    {
+                        m_msg.init( m_Addresses[( *iter ).nAddress] );
+                        int nEnd = ( *iter ).nFirstValue + ( *iter ).nValues;
+
+                        for ( int i = ( *iter ).nFirstValue; i < nEnd; ++i )
+                        {
+                            switch ( m_Types[i] )
+                            {
+                                case OSCT_String:
+                                    m_msg.pushStr( m_Strings[i] );
+                                    break;
+
+                                case OSCT_Int32:
+                                    m_msg.pushInt32( int32( m_Ints[i] ) );
+                                    break;
+
+                                case OSCT_Int64:
+                                    m_msg.pushInt64( m_Ints[i] );
+                                    break;
+
+                                case OSCT_Float32:
+                                    m_msg.pushFloat( float( m_Floats[i] ) );
+                                    break;
+
+                                case OSCT_Double64:
+                                    m_msg.pushDouble( m_Floats[i] );
+                                    break;
+
+                                case OSCT_Bool:
+                                    m_msg.pushBool( m_Ints[i] != 0 );
+                                    break;
+
+                                case OSCT_Float32Array:
+                                case OSCT_Int32Array:
+                                    {
+                                        const std::vector<uint32>& words = m_Arrays[i];
+                                        char* pBlob = m_msg.pushBlobUninitialized( words.size() * 4 );
+
+                                        if ( pBlob )
+                                        {
+                                            OSCCopyNetwork32( pBlob, &words[0], words.size() );
+                                        }
+
+                                        break;
+                                    }
+                            }
+                        }
+
+                        pw.addMessage( m_msg );
+                        break;
+                    }
+            }
+        }
+
+        return pw.packetSize() > 0;
+    }
+
+    COSCConnection::COSCConnection()
+    {
+        m_pTransport = NULL;
+        m_eTransport = OSCTT_Udp;
+        m_nPort = 0;
+        m_bServer = false;
+        m_nRefs = 0;
+        m_nLastUpdate = -1;
+        m_pScheduler = NULL;
+        m_fSendRate = 0;
+        m_bSendRepeat = false;
+        m_bSuppressRepeats = false;
+        m_nKeepAliveNs = 0;
+        m_eTimeTagClock = OSCTC_Immediate;
+        m_nTimeTagLatencyNs = 0;
+        m_bFanOut = false;
+        m_nPeerTimeoutNs = 0;
+        m_eFraming = OSCSF_Slip;
+        m_nLastStatsLog = 0;
+        m_pCapture = NULL;
+        m_pReplay = NULL;
+        m_bReplayFinished = false;
+        m_pLoopbackServer = NULL;
+        m_nLoopbackGeneration = 0;
+    }
+
+    COSCConnection::~COSCConnection()
+    {
+        Reset();
+    }
+
+    COSCConnection* COSCConnection::FindLoopbackServer() const
+    {
+        // shared memory is always on this machine, its host is ignored
+        if ( m_bServer || ( !IsLoopbackHost( m_sHost ) && m_eTransport != OSCTT_SharedMemory ) )
+        {
+            return NULL;
+        }
+
+        // called for every packet sent, only search the pool again once it changed or the server's socket failed
+        if ( m_nLoopbackGeneration == g_nPoolGeneration && ( !m_pLoopbackServer || m_pLoopbackServer->IsOk() ) )
+        {
+            return m_pLoopbackServer;
+        }
+
+        m_pLoopbackServer = NULL;
+        m_nLoopbackGeneration = g_nPoolGeneration;
+
+        for ( std::map<SOSCConnectionKey, COSCConnection*>::const_iterator iter = g_OSCConnectionPool.begin(); iter != g_OSCConnectionPool.end(); ++iter )
+        {
+            const COSCConnection* pConn = iter->second;
+
+            if ( pConn != this && pConn->m_bServer && pConn->m_nPort == m_nPort && pConn->m_eTransport == m_eTransport
+                    && pConn->IsOk() )
+            {
+                m_pLoopbackServer = iter->second;
+                break;
+            }
+        }
+
+        return m_pLoopbackServer;
+    }
+
+    void COSCConnection::QueueLoopbackPacket( const void* pData, size_t nSize )
+    {
+        SLoopbackPacket packet;
+        packet.nOffset = m_LoopbackData.size();
+        packet.nSize = nSize;
+        packet.nTimestamp = GetOSCWallClockNs();
+        m_LoopbackPackets.push_back( packet );
+        m_LoopbackData.insert( m_LoopbackData.end(), ( const char* )pData, ( const char* )pData + nSize );
+    }
+
+    void COSCConnection::Dispatch( const void* pData, size_t nSize, uint64 nArrival )
+    {
+        OSC_TRACE_SCOPE( "Dispatch" );
+        PacketReader pr;
+
+        {
+            OSC_TRACE_SCOPE( "Parse" );
+            pr.init( pData, nSize );
+        }
+
+        Message* incoming_msg;
+        uint64 nNow = GetOSCWallClockNs();
+
+        ++m_Stats.nPacketsIn;
+        m_Stats.nBytesIn += nSize;
+
+        while ( pr.isOk() && ( incoming_msg = pr.popMessage() ) != 0 )
+        {
+            ++m_Stats.nMessagesIn;
+            bool bMatched = false;
+
+            if ( nArrival && nArrival <= nNow )
+            {
+                m_ArrivalLatency.Record( nNow - nArrival );
+            }
+
+            // timetags in the future are scheduled, not late
+            uint64 nSent = incoming_msg->timeTag() == TimeTag::immediate() ? 0 : OSCTimeTagToUnixNs( incoming_msg->timeTag() );
+
+            if ( nSent && nSent <= nNow )
+            {
+                m_TimeTagLatency.Record( nNow - nSent );
+            }
+
+            for ( size_t i = 0; i < m_ReceiveOSCMessages.size(); ++i )
+            {
+                // released entries keep their address but nobody listens anymore
+                if ( m_ReceiveOwners[i] >= 0 )
+                {
+                    COSCJitterBuffer* pJitter = m_JitterBuffers[i].IsEnabled() ? &m_JitterBuffers[i] : NULL;
+                    uint64 nMismatches = m_Stats.nTypeMismatches;
+                    bMatched |= m_ReceiveOSCMessages[i].Receive( *incoming_msg, m_Stats, pJitter, nArrival ? nArrival : nNow );
+
+                    if ( m_Stats.nTypeMismatches != nMismatches && m_Diagnostics.Report( OSCD_WrongType, int( i ), m_ReceiveOSCMessages[i].GetAddress().c_str(), nNow ) )
+                    {
+                        COSCDiagnostics::Log( OSCD_WrongType, m_ReceiveOSCMessages[i].GetAddress().c_str() );
+                    }
+                }
+            }
+
+            if ( !m_Handlers.empty() )
+            {
+                OSC_TRACE_SCOPE( "Handlers" );
+                COSCArgs args( *incoming_msg );
+
+                // by index, handlers may add others while being called
+                for ( size_t i = 0; i < m_Handlers.size(); ++i )
+                {
+                    IOSCMessageHandler* pHandler = m_Handlers[i].pHandler;
+
+                    if ( pHandler && incoming_msg->match( m_Handlers[i].sAddress ) )
+                    {
+                        bMatched = true;
+                        pHandler->OnOSCMessage( m_Handlers[i].nOwner, args );
+                    }
+                }
+            }
+
+            if ( !bMatched )
+            {
+                ++m_Stats.nUnmatched;
+            }
+        }
+
+        if ( !pr.isOk() )
+        {
+            ++m_Stats.nParseErrors;
+        }
+    }
+
+    void COSCConnection::CapturePacket( const void* pData, size_t nSize, uint64 nArrival, const std::string& sSender )
+    {
+        OSC_TRACE_SCOPE( "Capture" );
+
+        if ( !m_pCapture->Write( nArrival ? nArrival : GetOSCWallClockNs(), sSender, pData, nSize ) )
+        {
+            OSCLog( OSCLL_Error, "Capture of port %d stopped: %s", m_nPort, m_pCapture->GetError().c_str() );
+            Capture( NULL );
+        }
+    }
+
+    COSCConnection::SOSCRegistration* COSCConnection::FindRegistration( int nOwner )
+    {
+        for ( std::vector<SOSCRegistration>::iterator iter = m_Registrations.begin(); iter != m_Registrations.end(); ++iter )
+        {
+            if ( ( *iter ).nOwner == nOwner )
+            {
+                return &( *iter );
+            }
+        }
+
+        return NULL;
+    }
+
+    void COSCConnection::BeginRegistration( int nOwner )
+    {
+        SOSCRegistration* pPending = FindRegistration( nOwner );
+
+        if ( pPending )
+        {
+            EndRegistration( *pPending );
+            m_Registrations.erase( m_Registrations.begin() + ( pPending - &m_Registrations[0] ) );
+        }
+
+        SOSCRegistration reg;
+        reg.nOwner = nOwner;
+        reg.nReceive = 0;
+        reg.nPackets = 0;
+        reg.nUpdates = 0;
+
+        for ( size_t i = 0; i < m_ReceiveOwners.size(); ++i )
+        {
+            if ( m_ReceiveOwners[i] == nOwner )
+            {
+                reg.receive.push_back( int( i ) );
+            }
+        }
+
+        for ( size_t i = 0; i < m_PacketOwners.size(); ++i )
+        {
+            if ( m_PacketOwners[i] == nOwner )
+            {
+                reg.packets.push_back( int( i ) );
+            }
+        }
+
+        m_Registrations.push_back( reg );
+    }
+
+    void COSCConnection::ClearPacket( int nPacket )
+    {
+        m_Packets[nPacket].Clear();
+
+        if ( nPacket < int( m_Sent.size() ) )
+        {
+            m_Sent[nPacket].bValid = false;
+        }
+
+        if ( m_pScheduler )
+        {
+            m_pScheduler->Commit( nPacket, NULL, 0 );
+        }
+    }
+
+    void COSCConnection::EndRegistration( const SOSCRegistration& reg )
+    {
+        for ( size_t i = reg.nReceive; i < reg.receive.size(); ++i )
+        {
+            m_ReceiveOSCMessages[reg.receive[i]].ClearValues();
+            m_JitterBuffers[reg.receive[i]].Configure( false, 0, 0 );
+            m_ReceiveOwners[reg.receive[i]] = -1;
+        }
+
+        for ( size_t i = reg.nPackets; i < reg.packets.size(); ++i )
+        {
+            ClearPacket( reg.packets[i] );
+            m_PacketOwners[reg.packets[i]] = -1;
+        }
+    }
+
+    int COSCConnection::AddReceiveMessage( const char* sMessage, int nOwner )
+    {
+        SOSCRegistration* pReg = m_Registrations.empty() ? NULL : FindRegistration( nOwner );
+
+        if ( pReg && pReg->nReceive < pReg->receive.size() )
+        {
+            int nMessage = pReg->receive[pReg->nReceive++];
+            COSCMessage& message = m_ReceiveOSCMessages[nMessage];
+
+            // the value nodes register again on the handle chain
+            if ( message.GetAddress() == sMessage )
+            {
+                message.ClearValues();
+                m_JitterBuffers[nMessage].Clear();
+            }
+
+            else
+            {
+                message = COSCMessage( sMessage );
+                m_JitterBuffers[nMessage].Configure( false, 0, 0 );
+                m_Diagnostics.Forget( OSCD_WrongType, nMessage );
+            }
+
+            return nMessage;
+        }
+
+        m_ReceiveOSCMessages.push_back( COSCMessage( sMessage ) );
+        m_ReceiveOwners.push_back( nOwner );
+        m_JitterBuffers.push_back( COSCJitterBuffer() );
+        return m_ReceiveOSCMessages.size() - 1;
+    }
+
+    void COSCConnection::SetJitterBuffer( int nMessage, bool bEnable, float fMaxDelay, float fMaxExtrapolation )
+    {
+        m_JitterBuffers[nMessage].Configure( bEnable, fMaxDelay, fMaxExtrapolation );
+    }
+
+    int COSCConnection::AddPacket( int nOwner )
+    {
+        SOSCRegistration* pReg = m_Registrations.empty() ? NULL : FindRegistration( nOwner );
+
+        if ( pReg && pReg->nPackets < pReg->packets.size() )
+        {
+            int nPacket = pReg->packets[pReg->nPackets++];
+            ClearPacket( nPacket );
+            return nPacket;
+        }
+
+        m_Packets.push_back( COSCPacket() );
+        m_PacketOwners.push_back( nOwner );
+        return m_Packets.size() - 1;
+    }
+
+    bool COSCConnection::Release( int nOwner )
+    {
+        SOSCRegistration* pPending = FindRegistration( nOwner );
+
+        if ( pPending )
+        {
+            m_Registrations.erase( m_Registrations.begin() + ( pPending - &m_Registrations[0] ) );
+        }
+
+        // indices handed out to other users have to stay valid, so only empty the entries
+        for ( size_t i = 0; i < m_ReceiveOwners.size(); ++i )
+        {
+            if ( m_ReceiveOwners[i] == nOwner )
+            {
+                m_ReceiveOSCMessages[i].ClearValues();
+                m_JitterBuffers[i].Configure( false, 0, 0 );
+                m_ReceiveOwners[i] = -1;
+            }
+        }
+
+        for ( size_t i = 0; i < m_PacketOwners.size(); ++i )
+        {
+            if ( m_PacketOwners[i] == nOwner )
+            {
+                ClearPacket( int( i ) );
+                m_PacketOwners[i] = -1;
+            }
+        }
+
+        for ( std::vector<SOSCHandler>::iterator iter = m_Handlers.begin(); iter != m_Handlers.end(); ++iter )
+        {
+            if ( ( *iter ).nOwner == nOwner )
+            {
+                ( *iter ).pHandler = NULL;
+            }
+        }
+
+        return --m_nRefs <= 0;
+    }
+
+    void COSCConnection::SetSendRate( float fRate, bool bRepeat )
+    {
+        m_fSendRate = fRate;
+        m_bSendRepeat = bRepeat;
+
+        if ( fRate <= 0 || !m_pTransport )
+        {
+            StopScheduler();
+            return;
+        }
+
+        if ( !m_pScheduler )
+        {
+            m_pScheduler = new COSCSendScheduler( m_pTransport, m_TransportLock );
+            m_pScheduler->SetRate( fRate, bRepeat );
+            m_pScheduler->SetCoalesceSize( m_Coalescer.GetMaxSize() );
+            m_pScheduler->Start( 0, "OSCSendScheduler" );
+        }
+
+        else
+        {
+            m_pScheduler->SetRate( fRate, bRepeat );
+        }
+    }
+
+    void COSCConnection::SetCoalesceSize( size_t nMaxSize )
+    {
+        m_Coalescer.SetMaxSize( nMaxSize );
+
+        if ( m_pScheduler )
+        {
+            m_pScheduler->SetCoalesceSize( nMaxSize );
+        }
+    }
+
+    void COSCConnection::SetSuppressRepeats( bool bSuppress, float fKeepAlive )
+    {
+        m_bSuppressRepeats = bSuppress;
+        m_nKeepAliveNs = fKeepAlive > 0 ? uint64( double( fKeepAlive ) * 1e9 ) : 0;
+        m_Sent.clear();
+    }
+
+    void COSCConnection::SetTimeTags( eOSCTimeTagClock eClock, float fLatency )
+    {
+        m_eTimeTagClock = eClock;
+        m_nTimeTagLatencyNs = fLatency > 0 ? uint64( double( fLatency ) * 1e9 ) : 0;
+    }
+
+    bool COSCConnection::SetFanOut( bool bFanOut, float fPeerTimeout )
+    {
+        CryAutoLock<CryMutex> lock( m_TransportLock );
+        m_bFanOut = bFanOut;
+        m_nPeerTimeoutNs = fPeerTimeout > 0 ? uint64( double( fPeerTimeout ) * 1e9 ) : 0;
+        return !m_pTransport || m_pTransport->SetFanOut( m_bFanOut, m_nPeerTimeoutNs );
+    }
+
+    int COSCConnection::GetPeerCount() const
+    {
+        // the scheduler thread evicts idle peers when it sends
+        CryAutoLock<CryMutex> lock( m_TransportLock );
+        return m_pTransport ? m_pTransport->GetPeerCount() : 0;
+    }
+
+    bool COSCConnection::IsRepeat( size_t nPacket, const void* pData, size_t nSize, uint64 nNow )
+    {
+        if ( nPacket >= m_Sent.size() )
+        {
+            SOSCSentPacket unsent = { 0, 0, false };
+            m_Sent.resize( nPacket + 1, unsent );
+        }
+
+        SOSCSentPacket& sent = m_Sent[nPacket];
+        uint64 nHash = HashPacket( pData, nSize );
+
+        if ( sent.bValid && sent.nHash == nHash && ( !m_nKeepAliveNs || nNow - sent.nTime < m_nKeepAliveNs ) )
+        {
+            return true;
+        }
+
+        sent.nHash = nHash;
+        sent.nTime = nNow;
+        sent.bValid = true;
+        return false;
+    }
+
+    void COSCConnection::SendCoalesced()
+    {
+        if ( m_Coalescer.IsEmpty() )
+        {
+            return;
+        }
+
+        OSC_TRACE_SCOPE( "Send" );
+
+        if ( m_Coalescer.GetPacketCount() > 1 )
+        {
+            m_Stats.nCoalesced += m_Coalescer.GetPacketCount();
+        }
+
+        CryAutoLock<CryMutex> lock( m_TransportLock );
+        m_Stats.CountSend( m_Coalescer.GetSize(), m_pTransport->IsOk() && m_pTransport->SendPacket( m_Coalescer.GetData(), m_Coalescer.GetSize() ) );
+        m_Coalescer.Clear();
+    }
+
+    void COSCConnection::StopScheduler()
+    {
+        if ( m_pScheduler )
+        {
+            m_pScheduler->Cancel();
+            m_pScheduler->WaitForThread();
+
+            // keep what the thread sent
+            SOSCStats sent = m_pScheduler->GetStats();
+            sent.Subtract( m_SchedulerBase );
+            m_Stats.Add( sent );
+            m_SchedulerBase.Reset();
+
+            delete m_pScheduler;
+            m_pScheduler = NULL;
+        }
+    }
+
+    void COSCConnection::Reset()
+    {
+        FlushDiagnostics( GetOSCWallClockNs() );
+        m_Diagnostics.Clear();
+        StopScheduler();
+        Capture( NULL );
+
+        if ( m_pTransport )
+        {
+            m_pTransport->Release();
+            m_pTransport = NULL;
+            m_pReplay = NULL;
+        }
+
+        m_fSendRate = 0;
+        m_Coalescer.SetMaxSize( 0 );
+        m_Coalescer.Clear();
+        m_bSuppressRepeats = false;
+        m_nKeepAliveNs = 0;
+        m_Sent.clear();
+        m_eTimeTagClock = OSCTC_Immediate;
+        m_nTimeTagLatencyNs = 0;
+        m_bFanOut = false;
+        m_nPeerTimeoutNs = 0;
+        m_ReceiveOSCMessages.clear();
+        m_Packets.clear();
+        m_ReceiveOwners.clear();
+        m_JitterBuffers.clear();
+        m_PacketOwners.clear();
+        m_Registrations.clear();
+        m_Handlers.clear();
+        m_LoopbackData.clear();
+        m_LoopbackPackets.clear();
+        m_nPort = 0;
+        ResetLatency();
+    }
+
+    void COSCConnection::InvalidateValues( IOSCValueSink* pSink )
+    {
+        for ( std::vector<COSCMessage>::iterator iter = m_ReceiveOSCMessages.begin(); iter != m_ReceiveOSCMessages.end(); ++iter )
+        {
+            ( *iter ).InvalidateValues( pSink );
+        }
+    }
+
+    void COSCConnection::GetStats( SOSCStats& stats ) const
+    {
+        stats = m_Stats;
+
+        if ( m_pScheduler )
+        {
+            SOSCStats sent = m_pScheduler->GetStats();
+            sent.Subtract( m_SchedulerBase );
+            stats.Add( sent );
+        }
+    }
+
+    void COSCConnection::ResetStats()
+    {
+        m_Stats.Reset();
+
+        if ( m_pScheduler )
+        {
+            m_SchedulerBase = m_pScheduler->GetStats();
+        }
+    }
+
+    void COSCConnection::LogStats() const
+    {
+        SOSCStats stats;
+        GetStats( stats );
+
+        OSCLog( OSCLL_Always, "Connection %s %s:%d (%d users): in %llu packets %llu messages %llu bytes, out %llu packets %llu bytes (%llu coalesced, %llu repeats suppressed)",
+                m_bServer ? "server" : "client", m_sHost.c_str(), m_nPort, m_nRefs,
+                ( unsigned long long )stats.nPacketsIn, ( unsigned long long )stats.nMessagesIn, ( unsigned long long )stats.nBytesIn,
+                ( unsigned long long )stats.nPacketsOut, ( unsigned long long )stats.nBytesOut, ( unsigned long long )stats.nCoalesced,
+                ( unsigned long long )stats.nSuppressed );
+        OSCLog( OSCLL_Always, "  errors: parse %llu, unmatched %llu, wrong type %llu, send %llu; update avg %.1fus max %.1fus",
+                ( unsigned long long )stats.nParseErrors, ( unsigned long long )stats.nUnmatched,
+                ( unsigned long long )stats.nTypeMismatches, ( unsigned long long )stats.nSendFailures,
+                stats.nUpdates ? stats.nUpdateNs / 1000.0 / stats.nUpdates : 0.0, stats.nUpdateMaxNs / 1000.0 );
+
+        if ( m_bFanOut )
+        {
+            OSCLog( OSCLL_Always, "  fan out to %d peers (timeout %.1fs)", GetPeerCount(), m_nPeerTimeoutNs / 1e9 );
+        }
+    }
+
+    void COSCConnection::ResetLatency()
+    {
+        m_ArrivalLatency.Reset();
+        m_TimeTagLatency.Reset();
+    }
+
+    void COSCConnection::LogLatency() const
+    {
+        const COSCLatencyHistogram* pHistograms[] = { &m_ArrivalLatency, &m_TimeTagLatency };
+        const char* sNames[] = { "arrival->dispatch", "timetag->dispatch" };
+
+        OSCLog( OSCLL_Always, "Connection %s %s:%d (%d users)", m_bServer ? "server" : "client", m_sHost.c_str(), m_nPort, m_nRefs );
+
+        for ( int i = 0; i < 2; ++i )
+        {
+            const COSCLatencyHistogram& h = *pHistograms[i];
+            OSCLog( OSCLL_Always, "  %s: count %u p50 %.1fus p90 %.1fus p99 %.1fus p99.9 %.1fus max %.1fus", sNames[i], unsigned( h.GetCount() ),
+                    h.GetPercentile( 50 ) / 1000.0, h.GetPercentile( 90 ) / 1000.0, h.GetPercentile( 99 ) / 1000.0,
+                    h.GetPercentile( 99.9 ) / 1000.0, h.GetMax() / 1000.0 );
+        }
+    }
+
+    void COSCConnection::AddHandler( const char* sAddress, IOSCMessageHandler* pHandler, int nOwner )
+    {
+        SOSCHandler handler;
+        handler.sAddress = sAddress;
+        handler.pHandler = pHandler;
+        handler.nOwner = nOwner;
+        m_Handlers.push_back( handler );
+    }
+
+    void COSCConnection::RemoveHandler( IOSCMessageHandler* pHandler, int nOwner )
+    {
+        for ( std::vector<SOSCHandler>::iterator iter = m_Handlers.begin(); iter != m_Handlers.end(); ++iter )
+        {
+            if ( ( *iter ).pHandler == pHandler && ( *iter ).nOwner == nOwner )
+            {
+                ( *iter ).pHandler = NULL;
+            }
+        }
+    }
+
+    bool COSCConnection::Connect( const char* sHost, int nPort, bool bServer, eOSCTransportType eTransport, eOSCStreamFraming eFraming )
+    {
+        Reset();
+
+        m_eTransport = eTransport;
+        m_eFraming = eFraming;
+        m_sHost = sHost;
+        m_nPort = nPort;
+        m_bServer = bServer;
+
+        m_pTransport = CreateOSCTransport( eTransport, eFraming );
+        m_pTransport->Open( m_sHost, nPort, bServer );
+
+        if ( m_pTransport->IsOk() )
+        {
+            OSCLog( OSCLL_Always, "Socket connected port %d", nPort );
+            return true;
+        }
+
+        else
+        {
+            OSCLog( OSCLL_Error, "Error connection to port %d: %s", nPort, m_pTransport->GetErrorMessage().c_str() );
+            return false;
+        }
+    }
+
+    bool COSCConnection::Rebind( const char* sHost, int nPort, bool bServer, eOSCTransportType eTransport, eOSCStreamFraming eFraming )
+    {
+        Capture( NULL );
+
+        m_eTransport = eTransport;
+        m_eFraming = eFraming;
+        m_sHost = sHost;
+        m_nPort = nPort;
+        m_bServer = bServer;
+        m_LoopbackData.clear();
+        m_LoopbackPackets.clear();
+
+        // packets sent on the old transport go out again on the new one
+        for ( std::vector<COSCPacket>::iterator iter = m_Packets.begin(); iter != m_Packets.end(); ++iter )
+        {
+            ( *iter ).NotifyChange();
+        }
+
+        // the old socket has to be closed first, it might be bound to the same port
+        float fRate = m_fSendRate;
+        StopScheduler();
+
+        {
+            CryAutoLock<CryMutex> lock( m_TransportLock );
+
+            if ( m_pTransport )
+            {
+                m_pTransport->Release();
+            }
+
+            m_pTransport = CreateOSCTransport( eTransport, eFraming );
+            m_pTransport->Open( m_sHost, nPort, bServer );
+            m_pTransport->SetFanOut( m_bFanOut, m_nPeerTimeoutNs );
+            m_pReplay = NULL;
+            m_bReplayFinished = false;
+        }
+
+        ++g_nPoolGeneration; // clients in this process look for their server again
+
+        m_Sent.clear();
+        SetSendRate( fRate, m_bSendRepeat );
+
+        if ( m_pTransport->IsOk() )
+        {
+            OSCLog( OSCLL_Always, "Socket rebound to port %d", nPort );
+            return true;
+        }
+
+        OSCLog( OSCLL_Error, "Error rebinding to port %d: %s", nPort, m_pTransport->GetErrorMessage().c_str() );
+        return false;
+    }
+
+    bool COSCConnection::SwapTransport( IOSCTransport* pTransport, COSCReplayTransport* pReplay )
+    {
+        // the scheduler thread holds on to the old transport
+        float fRate = m_fSendRate;
+        StopScheduler();
+
+        {
+            CryAutoLock<CryMutex> lock( m_TransportLock );
+
+            if ( m_pTransport )
+            {
+                m_pTransport->Release();
+            }
+
+            m_pTransport = pTransport;
+            m_pTransport->SetFanOut( m_bFanOut, m_nPeerTimeoutNs );
+            m_pReplay = pReplay;
+            m_bReplayFinished = false;
+        }
+
+        ++g_nPoolGeneration; // clients in this process look for their server again
+        m_Sent.clear();
+
+        SetSendRate( fRate, m_bSendRepeat );
+        return m_pTransport->IsOk();
+    }
+
+    bool COSCConnection::Capture( const char* sFile )
+    {
+        if ( !sFile )
+        {
+            if ( m_pCapture )
+            {
+                OSCLog( OSCLL_Always, "Captured %llu packets of port %d to %s", ( unsigned long long )m_pCapture->GetPacketCount(), m_nPort, m_pCapture->GetPath().c_str() );
+                delete m_pCapture;
+                m_pCapture = NULL;
+            }
+
+            return true;
+        }
+
+        if ( !m_pCapture )
+        {
+            m_pCapture = new COSCCaptureWriter();
+        }
+
+        if ( !m_pCapture->Open( sFile ) )
+        {
+            OSCLog( OSCLL_Error, "Capture of port %d failed: %s", m_nPort, m_pCapture->GetError().c_str() );
+            delete m_pCapture;
+            m_pCapture = NULL;
+            return false;
+        }
+
+        OSCLog( OSCLL_Always, "Capturing port %d to %s", m_nPort, sFile );
+        return true;
+    }
+
+    bool COSCConnection::Replay( const char* sFile, float fSpeed )
+    {
+        if ( !sFile )
+        {
+            if ( !m_pReplay )
+            {
+                return true;
+            }
+
+            IOSCTransport* pTransport = CreateOSCTransport( m_eTransport, m_eFraming );
+            pTransport->Open( m_sHost, m_nPort, m_bServer );
+            OSCLog( OSCLL_Always, "Replay stopped, port %d receives from its socket again", m_nPort );
+            return SwapTransport( pTransport, NULL );
+        }
+
+        COSCReplayTransport* pReplay = new COSCReplayTransport( fSpeed );
+
+        if ( !pReplay->Open( sFile, m_nPort, m_bServer ) )
+        {
+            OSCLog( OSCLL_Error, "Replay on port %d failed: %s", m_nPort, pReplay->GetErrorMessage().c_str() );
+            pReplay->Release();
+            return false;
+        }
+
+        OSCLog( OSCLL_Always, "Replaying %s on port %d at speed %g", sFile, m_nPort, fSpeed );
+        return SwapTransport( pReplay, pReplay );
+    }
+
+    bool COSCConnection::SendPacket( const void* pData, size_t nSize )
+    {
+        if ( !m_pTransport )
+        {
+            return false;
+        }
+
+        CryAutoLock<CryMutex> lock( m_TransportLock );
+
+        if ( !m_pTransport->IsOk() )
+        {
+            return false;
+        }
+
+        COSCConnection* pLoopback = FindLoopbackServer();
+
+        if ( pLoopback )
+        {
+            pLoopback->QueueLoopbackPacket( pData, nSize );
+            m_Stats.CountSend( nSize, true );
+            return true;
+        }
+
+        bool bSent = m_pTransport->SendPacket( pData, nSize );
+        m_Stats.CountSend( nSize, bSent );
+        return bSent;
+    }
+
+    bool COSCConnection::ReplyPacket( const void* pData, size_t nSize )
+    {
+        if ( !m_pTransport )
+        {
+            return false;
+        }
+
+        CryAutoLock<CryMutex> lock( m_TransportLock );
+
+        if ( !m_pTransport->IsOk() )
+        {
+            return false;
+        }
+
+        bool bSent = m_pTransport->ReplyPacket( pData, nSize );
+        m_Stats.CountSend( nSize, bSent );
+        return bSent;
+    }
+
+    void COSCConnection::Update( int64 nFrame )
+    {
+        if ( !m_pTransport )
+        {
+            return;
+        }
+
+        // shared connections are updated by every user, only the first one each frame does the work
+        if ( nFrame == m_nLastUpdate )
+        {
+            return;
+        }
+
+        m_nLastUpdate = nFrame;
+
+        // the owners had a frame to register again
+        for ( size_t i = 0; i < m_Registrations.size(); )
+        {
+            if ( ++m_Registrations[i].nUpdates >= 2 )
+            {
+                EndRegistration( m_Registrations[i] );
+                m_Registrations.erase( m_Registrations.begin() + i );
+            }
+
+            else
+            {
+                ++i;
+            }
+        }
+
+        for ( size_t i = 0; i < m_Handlers.size(); )
+        {
+            if ( m_Handlers[i].pHandler )
+            {
+                ++i;
+            }
+
+            else
+            {
+                m_Handlers.erase( m_Handlers.begin() + i );
+            }
+        }
+
+        OSC_TRACE_SCOPE( "Connection Update" );
+        uint64 nStart = GetOSCWallClockNs();
+        bool bOk;
+
+        // the transport lock is only held for transport calls, so the scheduler thread never waits for a dispatch or an encode
+        {
+            CryAutoLock<CryMutex> lock( m_TransportLock );
+            bOk = m_pTransport->IsOk();
+        }
+
+        if ( bOk )
+        {
+            // Receive Data from connections in this process first, they were sent earlier.
+            // Handlers may queue more while they are dispatched, those wait for the next update.
+            std::vector<char> loopbackData;
+            std::vector<SLoopbackPacket> loopbackPackets;
+            loopbackData.swap( m_LoopbackData );
+            loopbackPackets.swap( m_LoopbackPackets );
+
+            for ( size_t i = 0; i < loopbackPackets.size(); ++i )
+            {
+                const SLoopbackPacket& packet = loopbackPackets[i];
+
+                if ( m_pCapture )
+                {
+                    CapturePacket( &loopbackData[packet.nOffset], packet.nSize, packet.nTimestamp, "loopback" );
+                }
+
+                Dispatch( &loopbackData[packet.nOffset], packet.nSize, packet.nTimestamp );
+            }
+
+            // hand the storage back unless new packets arrived meanwhile
+            if ( m_LoopbackPackets.empty() )
+            {
+                loopbackData.clear();
+                loopbackPackets.clear();
+                loopbackData.swap( m_LoopbackData );
+                loopbackPackets.swap( m_LoopbackPackets );
+            }
+
+            // a flood of packets is spread over several frames when limited
+            for ( int nReceived = 0; g_nOSCMaxPacketsPerUpdate <= 0 || nReceived < g_nOSCMaxPacketsPerUpdate; ++nReceived )
+            {
+                uint64 nArrival;
+                std::string sSender;
+
+                {
+                    CryAutoLock<CryMutex> lock( m_TransportLock );
+                    bool bReceived;
+
+                    {
+                        OSC_TRACE_SCOPE( "Receive" );
+                        bReceived = m_pTransport->ReceiveNextPacket();
+                    }
+
+                    if ( !bReceived )
+                    {
+                        break;
+                    }
+
+                    const char* pData = ( const char* )m_pTransport->GetPacketData();
+                    m_Received.assign( pData, pData + m_pTransport->GetPacketSize() );
+                    nArrival = m_pTransport->GetPacketTimestamp();
+
+                    if ( m_pCapture )
+                    {
+                        sSender = m_pTransport->GetPacketSender();
+                    }
+                }
+
+                const char* pPacket = m_Received.empty() ? NULL : &m_Received[0];
+
+                if ( m_pCapture )
+                {
+                    CapturePacket( pPacket, m_Received.size(), nArrival, sSender );
+                }
+
+                Dispatch( pPacket, m_Received.size(), nArrival );
+            }
+
+            // smoothed values are output every frame, at the frame time
+            uint64 nNow = GetOSCWallClockNs();
+
+            for ( size_t i = 0; i < m_JitterBuffers.size(); ++i )
+            {
+                const float* pValues = m_JitterBuffers[i].IsEnabled() && m_ReceiveOwners[i] >= 0 ? m_JitterBuffers[i].Sample( nNow ) : NULL;
+
+                if ( pValues )
+                {
+                    m_ReceiveOSCMessages[i].Output( pValues );
+                }
+            }
+
+            if ( m_pReplay && !m_bReplayFinished )
+            {
+                CryAutoLock<CryMutex> lock( m_TransportLock );
+
+                if ( m_pReplay->IsFinished() )
+                {
+                    m_bReplayFinished = true;
+                    OSCLog( OSCLL_Always, "Replay on port %d finished", m_nPort );
+                }
+            }
+
+            // Send Data, straight into the receive queue if the server lives in this process
+            COSCConnection* pLoopback = m_Packets.empty() ? NULL : FindLoopbackServer();
+
+            uint64 nTimeTag = 1;
+
+            if ( m_eTimeTagClock == OSCTC_FrameStart )
+            {
+                if ( nFrame != g_nTimeTagFrame )
+                {
+                    g_nTimeTagFrame = nFrame;
+                    g_nTimeTagFrameNs = GetOSCMonotonicClockNs();
+                }
+
+                nTimeTag = OSCUnixNsToTimeTag( g_nTimeTagFrameNs + m_nTimeTagLatencyNs );
+            }
+
+            for ( std::vector<COSCPacket>::iterator iter = m_Packets.begin(); bOk && iter != m_Packets.end(); ++iter )
+            {
+                if ( m_eTimeTagClock == OSCTC_Monotonic )
+                {
+                    nTimeTag = OSCUnixNsToTimeTag( GetOSCMonotonicClockNs() + m_nTimeTagLatencyNs );
+                }
+
+                if ( ( *iter ).Encode( m_pw, nTimeTag ) )
+                {
+                    if ( m_bSuppressRepeats && IsRepeat( iter - m_Packets.begin(), m_pw.packetData(), m_pw.packetSize(), nStart ) )
+                    {
+                        // the receiver already has these bytes
+                        ++m_Stats.nSuppressed;
+                    }
+
+                    else if ( pLoopback )
+                    {
+                        pLoopback->QueueLoopbackPacket( m_pw.packetData(), m_pw.packetSize() );
+                        m_Stats.CountSend( m_pw.packetSize(), true );
+                    }
+
+                    else if ( m_pScheduler )
+                    {
+                        // goes out with the next tick of the scheduler
+                        m_pScheduler->Commit( int( iter - m_Packets.begin() ), m_pw.packetData(), m_pw.packetSize() );
+                    }
+
+                    else if ( m_Coalescer.GetMaxSize() && m_Coalescer.Add( m_pw.packetData(), m_pw.packetSize() ) )
+                    {
+                        // goes out with the other changed packets below
+                    }
+
+                    else
+                    {
+                        SendCoalesced();
+
+                        // a packet can still start the next bundle, unless it's too large on its own
+                        if ( !m_Coalescer.GetMaxSize() || !m_Coalescer.Add( m_pw.packetData(), m_pw.packetSize() ) )
+                        {
+                            OSC_TRACE_SCOPE( "Send" );
+                            CryAutoLock<CryMutex> lock( m_TransportLock );
+                            bOk = m_pTransport->IsOk();
+                            m_Stats.CountSend( m_pw.packetSize(), bOk && m_pTransport->SendPacket( m_pw.packetData(), m_pw.packetSize() ) );
+                        }
+                    }
+                }
+            }
+
+            SendCoalesced();
+
+            // Stream transports write everything queued above in one go
+            OSC_TRACE_SCOPE( "Flush" );
+            CryAutoLock<CryMutex> lock( m_TransportLock );
+            m_pTransport->Flush();
+        }
+
+        else
+        {
+            std::string sError;
+
+            {
+                CryAutoLock<CryMutex> lock( m_TransportLock );
+                sError = m_pTransport->GetErrorMessage();
+            }
+
+            // a socket stays broken for many frames, only the first one is logged
+            if ( m_Diagnostics.Report( OSCD_SocketError, 0, sError.c_str(), nStart ) )
+            {
+                COSCDiagnostics::Log( OSCD_SocketError, sError.c_str() );
+            }
+        }
+
+        uint64 nEnd = GetOSCWallClockNs();
+        uint64 nTime = nEnd - nStart;
+        ++m_Stats.nUpdates;
+        m_Stats.nUpdateNs += nTime;
+        m_Stats.nUpdateMaxNs = nTime > m_Stats.nUpdateMaxNs ? nTime : m_Stats.nUpdateMaxNs;
+
+        if ( g_fOSCStatsInterval > 0 && nEnd - m_nLastStatsLog >= uint64( g_fOSCStatsInterval * 1e9 ) )
+        {
+            if ( m_nLastStatsLog )
+            {
+                LogStats();
+            }
+
+            m_nLastStatsLog = nEnd;
+        }
+
+        if ( m_Diagnostics.IsDue( nEnd ) )
+        {
+            FlushDiagnostics( nEnd );
+        }
+    }
+
+    void COSCConnection::FlushDiagnostics( uint64 nNow )
+    {
+        char sName[512];
+        snprintf( sName, sizeof( sName ), "Connection %s %s:%d", m_bServer ? "server" : "client", m_sHost.c_str(), m_nPort );
+        sName[sizeof( sName ) - 1] = 0;
+        m_Diagnostics.Flush( sName, nNow );
+    }
+
+    SOSCConnectionKey MakeOSCConnectionKey( const char* sHost, int nPort, EOSCConnectionType eType, int nFraming )
+    {
+        SOSCConnectionKey key;
+        key.sHost = sHost;
+        key.nPort = nPort;
+        key.bServer = eType == OSCCT_UdpServer || eType == OSCCT_TcpServer || eType == OSCCT_ShmServer;
+
+        switch ( eType )
+        {
+            case OSCCT_TcpClient:
+            case OSCCT_TcpServer:
+                key.eTransport = OSCTT_Tcp;
+                break;
+
+            case OSCCT_ShmClient:
+            case OSCCT_ShmServer:
+                key.eTransport = OSCTT_SharedMemory;
+                break;
+
+            default:
+                key.eTransport = OSCTT_Udp;
+                break;
+        }
+
+        key.eFraming = key.eTransport == OSCTT_Tcp ? eOSCStreamFraming( nFraming ) : OSCSF_Slip;
+
+        // a ring has one producer and one consumer per port, whatever host the nodes name
+        if ( key.eTransport == OSCTT_SharedMemory )
+        {
+            key.sHost.clear();
+        }
+
+        return key;
+    }
+
+    int AcquireOSCConnection( const SOSCConnectionKey& key )
+    {
+        COSCConnection*& pConn = g_OSCConnectionPool[key];
+
+        if ( !pConn )
+        {
+            pConn = new COSCConnection();
+            pConn->Connect( key.sHost.c_str(), key.nPort, key.bServer, key.eTransport, key.eFraming );
+            ++g_nPoolGeneration;
+        }
+
+        pConn->AddRef();
+
+        int nHandle = g_nFreeConnection++;
+        g_OSCConnections[nHandle] = pConn;
+        return nHandle;
+    }
+
+    bool RebindOSCConnection( int nHandle, const SOSCConnectionKey& key )
+    {
+        COSCConnection* pConn = FindConnection( nHandle );
+
+        if ( !pConn )
+        {
+            return false;
+        }
+
+        std::map<SOSCConnectionKey, COSCConnection*>::iterator pool = g_OSCConnectionPool.begin();
+
+        while ( pool != g_OSCConnectionPool.end() && pool->second != pConn )
+        {
+            ++pool;
+        }
+
+        if ( pool == g_OSCConnectionPool.end() )
+        {
+            return false;
+        }
+
+        bool bSameKey = !( pool->first < key ) && !( key < pool->first );
+
+        if ( bSameKey && ( pConn->GetRefCount() > 1 || pConn->IsOk() ) )
+        {
+            // nothing changed, the socket stays open as it is (a socket that failed to open is tried again)
+            return true;
+        }
+
+        if ( !bSameKey )
+        {
+            // other users keep their settings, and two connections with one key can't be pooled
+            if ( pConn->GetRefCount() != 1 || g_OSCConnectionPool.find( key ) != g_OSCConnectionPool.end() )
+            {
+                return false;
+            }
+
+            g_OSCConnectionPool.erase( pool );
+            g_OSCConnectionPool[key] = pConn;
+        }
+
+        pConn->Rebind( key.sHost.c_str(), key.nPort, key.bServer, key.eTransport, key.eFraming );
+        return true;
+    }
+
+    void ReleaseOSCConnection( int nHandle )
+    {
+        std::map<int, COSCConnection*>::iterator iter = g_OSCConnections.find( nHandle );
+
+        if ( iter == g_OSCConnections.end() )
+        {
+            return;
+        }
+
+        COSCConnection* pConn = iter->second;
+        g_OSCConnections.erase( iter );
+
+        if ( pConn->Release( nHandle ) )
+        {
+            for ( std::map<SOSCConnectionKey, COSCConnection*>::iterator pool = g_OSCConnectionPool.begin(); pool != g_OSCConnectionPool.end(); ++pool )
+            {
+                if ( pool->second == pConn )
+                {
+                    g_OSCConnectionPool.erase( pool );
+                    break;
+                }
+            }
+
+            ++g_nPoolGeneration;
+            delete pConn;
+        }
+    }
+
+    COSCConnection& GetConnection( int nConnection )
+    {
+        assert( g_OSCConnections.find( nConnection ) != g_OSCConnections.end() );
+        assert( g_OSCConnections[nConnection] != 0 );
+
+        return *g_OSCConnections[nConnection];
+    }
+
+    COSCConnection* FindConnection( int nConnection )
+    {
+        std::map<int, COSCConnection*>::const_iterator iter = g_OSCConnections.find( nConnection );
+        return iter != g_OSCConnections.end() ? iter->second : NULL;
+    }
+
+    void InvalidateOSCValues( IOSCValueSink* pSink )
+    {
+        for ( std::map<SOSCConnectionKey, COSCConnection*>::const_iterator iter = g_OSCConnectionPool.begin(); iter != g_OSCConnectionPool.end(); ++iter )
+        {
+            iter->second->InvalidateValues( pSink );
+        }
+    }
+
+    int OSCOpenConnection( const char* sHost, int nPort, EOSCConnectionType eType, int nFraming )
+    {
+        return AcquireOSCConnection( MakeOSCConnectionKey( sHost, nPort, eType, nFraming ) );
+    }
+
+    void OSCCloseConnection( int nConnection )
+    {
+        ReleaseOSCConnection( nConnection );
+    }
+
+    bool OSCIsConnectionOk( int nConnection )
+    {
+        COSCConnection* pConn = FindConnection( nConnection );
+        return pConn && pConn->IsOk();
+    }
+
+    void OSCAddHandler( int nConnection, const char* sAddress, IOSCMessageHandler* pHandler )
+    {
+        COSCConnection* pConn = FindConnection( nConnection );
+
+        if ( pConn && pHandler )
+        {
+            pConn->AddHandler( sAddress, pHandler, nConnection );
+        }
+    }
+
+    void OSCRemoveHandler( int nConnection, IOSCMessageHandler* pHandler )
+    {
+        COSCConnection* pConn = FindConnection( nConnection );
+
+        if ( pConn )
+        {
+            pConn->RemoveHandler( pHandler, nConnection );
+        }
+    }
+
+    bool OSCSendPacket( int nConnection, const void* pData, size_t nSize )
+    {
+        COSCConnection* pConn = FindConnection( nConnection );
+        return pConn && pConn->SendPacket( pData, nSize );
+    }
+
+    bool OSCReplyPacket( int nConnection, const void* pData, size_t nSize )
+    {
+        COSCConnection* pConn = FindConnection( nConnection );
+        return pConn && pConn->ReplyPacket( pData, nSize );
+    }
+
+    void OSCUpdateConnections( int64 nFrame )
+    {
+        for ( std::map<SOSCConnectionKey, COSCConnection*>::const_iterator iter = g_OSCConnectionPool.begin(); iter != g_OSCConnectionPool.end(); ++iter )
+        {
+            iter->second->Update( nFrame );
+        }
+    }
+
+    int OSCGetStats( int nConnection, SOSCStats& stats )
+    {
+        stats.Reset();
+
+        if ( nConnection > 0 )
+        {
+            COSCConnection* pConn = FindConnection( nConnection );
+
+            if ( pConn )
+            {
+                pConn->GetStats( stats );
+            }
+
+            return pConn && !pConn->IsOk() ? 1 : 0;
+        }
+
+        int nFailed = 0;
+
+        for ( std::map<SOSCConnectionKey, COSCConnection*>::const_iterator iter = g_OSCConnectionPool.begin(); iter != g_OSCConnectionPool.end(); ++iter )
+        {
+            SOSCStats connStats;
+            iter->second->GetStats( connStats );
+            stats.Add( connStats );
+            nFailed += iter->second->IsOk() ? 0 : 1;
+        }
+
+        return nFailed;
+    }
+
+    int OSCGetConnectionCount()
+    {
+        return int( g_OSCConnectionPool.size() );
+    }
+
+    namespace
+    {
+        COSCConnection* FindServerConnection( int nPort )
+        {
+            for ( std::map<SOSCConnectionKey, COSCConnection*>::const_iterator iter = g_OSCConnectionPool.begin(); iter != g_OSCConnectionPool.end(); ++iter )
+            {
+                if ( iter->first.bServer && iter->first.nPort == nPort )
+                {
+                    return iter->second;
+                }
+            }
+
+            OSCLog( OSCLL_Warning, "No server connection on port %d", nPort );
+            return NULL;
+        }
+    }
+
+    bool OSCCapture( int nPort, const char* sFile )
+    {
+        COSCConnection* pConn = FindServerConnection( nPort );
+        return pConn && pConn->Capture( sFile );
+    }
+
+    bool OSCReplay( int nPort, const char* sFile, float fSpeed )
+    {
+        COSCConnection* pConn = FindServerConnection( nPort );
+        return pConn && pConn->Replay( sFile, fSpeed );
+    }
+
+    void OSCResetStats( int nConnection )
+    {
+        for ( std::map<SOSCConnectionKey, COSCConnection*>::const_iterator iter = g_OSCConnectionPool.begin(); iter != g_OSCConnectionPool.end(); ++iter )
+        {
+            if ( nConnection <= 0 || iter->second == FindConnection( nConnection ) )
+            {
+                iter->second->ResetStats();
+            }
+        }
+    }
+
+    void OSCLogStats()
+    {
+        for ( std::map<SOSCConnectionKey, COSCConnection*>::const_iterator iter = g_OSCConnectionPool.begin(); iter != g_OSCConnectionPool.end(); ++iter )
+        {
+            iter->second->LogStats();
+        }
+    }
+
+    void OSCLogLatency()
+    {
+        for ( std::map<SOSCConnectionKey, COSCConnection*>::const_iterator iter = g_OSCConnectionPool.begin(); iter != g_OSCConnectionPool.end(); ++iter )
+        {
+            iter->second->LogLatency();
+        }
+    }
+
+    void OSCResetLatency()
+    {
+        for ( std::map<SOSCConnectionKey, COSCConnection*>::const_iterator iter = g_OSCConnectionPool.begin(); iter != g_OSCConnectionPool.end(); ++iter )
+        {
+            iter->second->ResetLatency();
+        }
+    }
+}
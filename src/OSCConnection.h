@@ -0,0 +1,653 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <OSCCore.h>
+#include <OSCTransport.h>
+#include <OSCLatencyHistogram.h>
+#include <OSCCoalescer.h>
+#include <OSCJitterBuffer.h>
+#include <OSCDiagnostics.h>
+#include <oscpkt/oscpkt.hh>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OSCPlugin
+{
+    class COSCSendScheduler;
+    class COSCCaptureWriter;
+    class COSCReplayTransport;
+
+    /**
+    * @brief Where a received value goes.
+    * The sink is resolved once at registration and cleared when it is destroyed (see InvalidateOSCValues).
+    */
+    struct SOSCValueInfo
+    {
+        eOSCType type;
+        IOSCValueSink* pSink; //!< NULL for OSCT_Any and once the sink is gone
+        int nPort;
+        std::vector<uint32>* pArray; //!< array types are stored here (owned by the sink) and nPort gets the element count
+
+        SOSCValueInfo( eOSCType _type, IOSCValueSink* _pSink, int _nPort, std::vector<uint32>* _pArray = NULL ) :
+            type( _type ),
+            pSink( _pSink ),
+            nPort( _nPort ),
+            pArray( _pArray )
+        {
+        };
+    };
+
+    class IReceiveInfo
+    {
+        public:
+            virtual bool Receive( oscpkt::Message& msg, SOSCStats& stats ) const = 0;
+            virtual void Release() = 0;
+
+        protected:
+            virtual ~IReceiveInfo() {}
+    };
+
+    class COSCMessage : public IReceiveInfo
+    {
+            std::string m_sMessage;
+            std::list<SOSCValueInfo> m_OSCValues;
+
+        public:
+            COSCMessage( const char* sMessage )
+            {
+                m_sMessage = sMessage;
+            }
+
+            void AddValue( const SOSCValueInfo& info )
+            {
+                m_OSCValues.push_back( info );
+            }
+
+            const std::string& GetAddress() const
+            {
+                return m_sMessage;
+            }
+
+            void ClearValues()
+            {
+                m_OSCValues.clear();
+            }
+
+            void InvalidateValues( IOSCValueSink* pSink );
+
+            /**
+            * @return true if the message matched, a value of the wrong type is counted in stats.nTypeMismatches (not logged)
+            */
+            bool Receive( oscpkt::Message& msg, SOSCStats& stats ) const
+            {
+                return Receive( msg, stats, NULL, 0 );
+            }
+
+            /**
+            * @param pJitter if enabled the numeric values go into it instead of the sinks, see Output
+            * @param nArrival of the packet for the jitter buffer
+            */
+            bool Receive( oscpkt::Message& msg, SOSCStats& stats, COSCJitterBuffer* pJitter, uint64 nArrival ) const;
+
+            /**
+            * @brief Hand values played back by a jitter buffer to the sinks of the numeric values, in registration order
+            */
+            void Output( const float* pValues ) const;
+
+            void Release()
+            {
+                delete this;
+            };
+    };
+
+    /**
+    * @brief Where the timetags of sent bundles come from
+    */
+    enum eOSCTimeTagClock
+    {
+        OSCTC_Immediate = 0, //!< no time, receivers handle the bundle on arrival
+        OSCTC_FrameStart, //!< the same time for everything sent in a frame, taken when the first connection sends in it
+        OSCTC_Monotonic, //!< the time each packet is encoded
+    };
+
+    /**
+    * @brief Send packet compiled into a flat program.
+    * Bundles and messages are opcodes, each message refers to a contiguous range of values.
+    * Values are stored as parallel arrays, the send value nodes write into them through a slot id.
+    * The packet owns no heap objects of its own, so copies made by std::vector are safe.
+    */
+    class COSCPacket
+    {
+            enum eOSCOp
+            {
+                OSCOP_BundleStart,
+                OSCOP_BundleEnd,
+                OSCOP_Message,
+            };
+
+            struct SOSCOp
+            {
+                eOSCOp op;
+                int nAddress; //!< index into m_Addresses
+                int nFirstValue;
+                int nValues;
+            };
+
+            bool m_bAutoSend;
+            bool m_bSend;
+
+            std::vector<SOSCOp> m_Program;
+            std::vector<std::string> m_Addresses;
+
+            // values, contiguous for each message
+            std::vector<unsigned char> m_Types; //!< eOSCType
+            std::vector<int64> m_Ints; //!< Int32, Int64, Bool
+            std::vector<double> m_Floats; //!< Float32, Double64
+            std::vector<std::string> m_Strings;
+            std::vector<std::vector<uint32> > m_Arrays; //!< Float32Array, Int32Array in host byte order
+
+            std::vector<int> m_SlotValues; //!< value index of each slot id handed out by AddValue
+
+            oscpkt::Message m_msg; //!< reused so encoding doesn't allocate once the packet has been sent
+
+        public:
+            enum
+            {
+                MAX_ARRAY_ELEMENTS = 16384, //!< 64 KB of words, the most a UDP datagram can carry
+            };
+
+            COSCPacket()
+            {
+                m_bSend = false;
+                m_bAutoSend = true;
+            }
+
+            void SetAutoSend( bool bAutoSend )
+            {
+                m_bAutoSend = bAutoSend;
+            }
+
+            /**
+            * @brief Drop all messages and values but keep the allocated storage for registering them again
+            */
+            void Clear();
+
+            void NotifyChange()
+            {
+                if ( m_bAutoSend )
+                {
+                    m_bSend = true;
+                }
+            }
+
+            void RequestSend()
+            {
+                m_bSend = true;
+            }
+
+            void AddBundleStart()
+            {
+                SOSCOp op = { OSCOP_BundleStart, -1, int( m_Types.size() ), 0 };
+                m_Program.push_back( op );
+            }
+
+            void AddBundleEnd()
+            {
+                SOSCOp op = { OSCOP_BundleEnd, -1, int( m_Types.size() ), 0 };
+                m_Program.push_back( op );
+            }
+
+            /**
+            * @return id of the message for AddValue
+            */
+            int AddMessage( const char* sMessage )
+            {
+                m_Addresses.push_back( sMessage );
+
+                SOSCOp op = { OSCOP_Message, int( m_Addresses.size() ) - 1, int( m_Types.size() ), 0 };
+                m_Program.push_back( op );
+                return m_Program.size() - 1;
+            }
+
+            /**
+            * @brief Append a value to a message of this packet
+            * @return slot id the value node writes to
+            */
+            int AddValue( int nMessage, eOSCType type );
+
+            void SetValue( int nSlot, int64 nValue )
+            {
+                int nIndex = m_SlotValues[nSlot];
+                m_Ints[nIndex] = nValue;
+                m_Floats[nIndex] = double( nValue );
+            }
+
+            void SetValue( int nSlot, double fValue )
+            {
+                int nIndex = m_SlotValues[nSlot];
+                m_Floats[nIndex] = fValue;
+                m_Ints[nIndex] = int64( fValue );
+            }
+
+            void SetValue( int nSlot, int nValue )
+            {
+                SetValue( nSlot, int64( nValue ) );
+            }
+
+            void SetValue( int nSlot, float fValue )
+            {
+                SetValue( nSlot, double( fValue ) );
+            }
+
+            void SetValue( int nSlot, bool bValue )
+            {
+                SetValue( nSlot, int64( bValue ? 1 : 0 ) );
+            }
+
+            void SetValue( int nSlot, const char* sValue )
+            {
+                m_Strings[m_SlotValues[nSlot]] = sValue;
+            }
+
+            /**
+            * @brief Resize an array value, clamped to MAX_ARRAY_ELEMENTS
+            */
+            void SetArraySize( int nSlot, size_t nSize )
+            {
+                m_Arrays[m_SlotValues[nSlot]].resize( nSize < size_t( MAX_ARRAY_ELEMENTS ) ? nSize : size_t( MAX_ARRAY_ELEMENTS ) );
+            }
+
+            /**
+            * @brief Set an element of an array value, the array grows if needed
+            * @return false (and logged) if nIndex is MAX_ARRAY_ELEMENTS or above
+            */
+            bool SetArrayElement( int nSlot, size_t nIndex, uint32 nWord );
+
+            /**
+            * @brief Set a value from text without going through int/float (the flow system has no 64 bit types)
+            */
+            void SetValueExact( int nSlot, const char* sValue );
+
+            /**
+            * @brief Encode the packet if a send was requested
+            * @param nTimeTag of all bundles in the packet (see OSCUnixNsToTimeTag), 1 is immediate
+            * @return true if pw holds a packet that should be sent
+            */
+            bool Encode( oscpkt::PacketWriter& pw, uint64 nTimeTag = 1 );
+    };
+
+    class COSCConnection
+    {
+            IOSCTransport* m_pTransport;
+            mutable CryMutex m_TransportLock; //!< the send scheduler thread uses the transport too
+            COSCSendScheduler* m_pScheduler; //!< NULL while packets are sent from Update
+            float m_fSendRate;
+            bool m_bSendRepeat;
+            COSCCoalescer m_Coalescer; //!< changed packets of a frame, when sent from Update
+
+            struct SOSCSentPacket
+            {
+                uint64 nHash; //!< of the bytes last sent
+                uint64 nTime; //!< when they were sent
+                bool bValid;
+            };
+
+            eOSCTimeTagClock m_eTimeTagClock;
+            uint64 m_nTimeTagLatencyNs; //!< added to the send time, how far receivers schedule ahead
+
+            bool m_bFanOut;
+            uint64 m_nPeerTimeoutNs;
+
+            bool m_bSuppressRepeats;
+            uint64 m_nKeepAliveNs; //!< 0 suppresses repeats forever
+            std::vector<SOSCSentPacket> m_Sent; //!< by packet id, while repeats are suppressed
+            eOSCTransportType m_eTransport;
+            eOSCStreamFraming m_eFraming;
+            std::string m_sHost;
+            int m_nPort;
+            bool m_bServer;
+
+            std::vector<COSCMessage> m_ReceiveOSCMessages;
+            std::vector<COSCPacket> m_Packets;
+            std::vector<int> m_ReceiveOwners; //!< handle that registered each receive message
+            std::vector<COSCJitterBuffer> m_JitterBuffers; //!< of each receive message, mostly disabled
+            std::vector<int> m_PacketOwners; //!< handle that registered each packet
+
+            // handlers of the native interface
+            struct SOSCHandler
+            {
+                std::string sAddress;
+                IOSCMessageHandler* pHandler; //!< NULL once removed
+                int nOwner;
+            };
+
+            std::vector<SOSCHandler> m_Handlers;
+
+            int m_nRefs; //!< Connection nodes and native users of this socket
+            int64 m_nLastUpdate; //!< frame of the last Update, every user calls it
+
+            oscpkt::PacketWriter m_pw; //!< reused for every packet so its storage is only allocated once
+            std::vector<char> m_Received; //!< copy of the packet being dispatched, taken under the transport lock
+
+            // packets handed over by clients in this process, bypassing the socket
+            struct SLoopbackPacket
+            {
+                size_t nOffset;
+                size_t nSize;
+                uint64 nTimestamp;
+            };
+
+            std::vector<char> m_LoopbackData;
+            std::vector<SLoopbackPacket> m_LoopbackPackets;
+
+            mutable COSCConnection* m_pLoopbackServer; //!< result of FindLoopbackServer
+            mutable unsigned int m_nLoopbackGeneration; //!< pool generation m_pLoopbackServer was found in
+
+            /**
+            * @brief An owner that registers again in place, see BeginRegistration
+            */
+            struct SOSCRegistration
+            {
+                int nOwner;
+                std::vector<int> receive; //!< receive messages of the owner in registration order
+                std::vector<int> packets; //!< packets of the owner in registration order
+                size_t nReceive; //!< entries of receive reused so far
+                size_t nPackets; //!< entries of packets reused so far
+                int nUpdates; //!< updates since BeginRegistration
+            };
+
+            std::vector<SOSCRegistration> m_Registrations;
+
+            SOSCRegistration* FindRegistration( int nOwner );
+
+            /**
+            * @brief Empty a packet whose id is handed out again or released
+            */
+            void ClearPacket( int nPacket );
+
+            /**
+            * @brief Drop what the owner didn't register again
+            */
+            void EndRegistration( const SOSCRegistration& reg );
+
+            SOSCStats m_Stats; //!< written on the main thread only
+            SOSCStats m_SchedulerBase; //!< scheduler counters at the last reset
+            uint64 m_nLastStatsLog;
+            COSCDiagnostics m_Diagnostics; //!< problems logged once, repeats summarized
+
+            /**
+            * @brief Log the summary of repeated problems
+            */
+            void FlushDiagnostics( uint64 nNow );
+
+            COSCLatencyHistogram m_ArrivalLatency; //!< packet arrival (kernel timestamp if available) to dispatch
+            COSCLatencyHistogram m_TimeTagLatency; //!< bundle timetag to dispatch, only for timetagged messages
+
+            COSCCaptureWriter* m_pCapture; //!< NULL unless received packets are recorded
+            COSCReplayTransport* m_pReplay; //!< same as m_pTransport while a capture is played back
+            bool m_bReplayFinished;
+
+            /**
+            * @brief Find a server connection in this process that would receive what this client sends,
+            * the result is kept until the connection pool changes
+            */
+            COSCConnection* FindLoopbackServer() const;
+            void QueueLoopbackPacket( const void* pData, size_t nSize );
+
+            /**
+            * @brief Hand a received packet to all registered messages
+            * @param nArrival arrival time of the packet, 0 if unknown
+            */
+            void Dispatch( const void* pData, size_t nSize, uint64 nArrival );
+            void CapturePacket( const void* pData, size_t nSize, uint64 nArrival, const std::string& sSender );
+
+            /**
+            * @brief Send what m_Coalescer collected, takes the transport lock
+            */
+            void SendCoalesced();
+
+            /**
+            * @brief Is the encoding of a packet the same as its last send, remembers it if not
+            */
+            bool IsRepeat( size_t nPacket, const void* pData, size_t nSize, uint64 nNow );
+
+            /**
+            * @brief Replace the transport but keep all registrations
+            */
+            bool SwapTransport( IOSCTransport* pTransport, COSCReplayTransport* pReplay );
+
+        public:
+            COSCConnection();
+            ~COSCConnection();
+
+            void AddRef()
+            {
+                ++m_nRefs;
+            }
+
+            int GetRefCount() const
+            {
+                return m_nRefs;
+            }
+
+            /**
+            * @brief Drop the registrations of one user
+            * @return true if nobody uses the connection anymore
+            */
+            bool Release( int nOwner );
+
+            /**
+            * @brief Send packets at a fixed rate from a scheduler thread
+            * @param fRate ticks per second, 0 sends changed packets once per frame from Update
+            * @param bRepeat resend unchanged packets on every tick
+            */
+            void SetSendRate( float fRate, bool bRepeat );
+            void StopScheduler();
+
+            /**
+            * @brief Send the packets changed in a frame (or a send rate tick) together in top-level bundles of up to nMaxSize bytes
+            * instead of a datagram each, 0 turns it off. See OSC_COALESCE_UDP_SIZE.
+            */
+            void SetCoalesceSize( size_t nMaxSize );
+
+            /**
+            * @brief Skip sends of a packet whose bytes are the same as the last time it was sent, for graphs that request sends every frame.
+            * @param fKeepAlive seconds after which a repeat is sent anyway, 0 never
+            */
+            void SetSuppressRepeats( bool bSuppress, float fKeepAlive );
+
+            /**
+            * @brief Put real times into the bundles sent, so receivers can schedule them and smooth out the frame time jitter.
+            * Only bundles carry timetags, packets that are a single message are sent as they are.
+            * @param fLatency seconds added to the time, receivers play the bundles that much later but evenly spaced
+            */
+            void SetTimeTags( eOSCTimeTagClock eClock, float fLatency );
+
+            /**
+            * @brief A UDP server sends to everyone it received from instead of only the last sender, each packet is encoded once.
+            * @param fPeerTimeout seconds after which a peer that sent nothing is dropped, 0 never
+            * @return false if the transport can't do it (UDP clients)
+            */
+            bool SetFanOut( bool bFanOut, float fPeerTimeout );
+
+            /**
+            * @return peers a packet is sent to, 0 if unknown
+            */
+            int GetPeerCount() const;
+
+            void Reset();
+            void InvalidateValues( IOSCValueSink* pSink );
+
+            void GetStats( SOSCStats& stats ) const;
+            void ResetStats();
+            void LogStats() const;
+
+            void ResetLatency();
+            void LogLatency() const;
+
+            /**
+            * @brief The next AddReceiveMessage/AddPacket calls of nOwner reuse its existing entries in order, so they keep their ids.
+            * Entries that aren't registered again are dropped after the next frame, re-initializing a graph doesn't grow the connection.
+            */
+            void BeginRegistration( int nOwner );
+
+            int AddReceiveMessage( const char* sMessage, int nOwner );
+
+            /**
+            * @brief Smooth the numeric values of a receive message: they are buffered and output interpolated every frame,
+            * a little delayed depending on how unevenly they arrive. For continuous streams like sensors or skeletons.
+            * @param fMaxDelay seconds the values may lag behind at most
+            * @param fMaxExtrapolation seconds values are extrapolated when the next sample is late
+            */
+            void SetJitterBuffer( int nMessage, bool bEnable, float fMaxDelay, float fMaxExtrapolation );
+
+            const COSCJitterBuffer& GetJitterBuffer( int nMessage ) const
+            {
+                return m_JitterBuffers[nMessage];
+            }
+
+            COSCMessage& GetReceiveMessage( int nMessage )
+            {
+                assert( nMessage >= 0 );
+                assert( nMessage < m_ReceiveOSCMessages.size() );
+
+                return m_ReceiveOSCMessages[nMessage];
+            }
+
+            /**
+            * @brief Including released entries, their indices are never reused by other owners
+            */
+            size_t GetReceiveMessageCount() const
+            {
+                return m_ReceiveOSCMessages.size();
+            }
+
+            void AddHandler( const char* sAddress, IOSCMessageHandler* pHandler, int nOwner );
+
+            /**
+            * @brief Only marks the handler, it might be removed while messages are dispatched
+            */
+            void RemoveHandler( IOSCMessageHandler* pHandler, int nOwner );
+
+            bool IsOk() const
+            {
+                return m_pTransport && m_pTransport->IsOk();
+            }
+
+            int AddPacket( int nOwner );
+
+            COSCPacket& GetPacket( int nPacket )
+            {
+                assert( nPacket >= 0 );
+                assert( nPacket < m_Packets.size() );
+
+                return m_Packets[nPacket];
+            }
+
+            bool Connect( const char* sHost, int nPort, bool bServer, eOSCTransportType eTransport = OSCTT_Udp, eOSCStreamFraming eFraming = OSCSF_Slip );
+
+            /**
+            * @brief Open a new transport with other settings (or the same ones), registrations and their ids stay valid
+            */
+            bool Rebind( const char* sHost, int nPort, bool bServer, eOSCTransportType eTransport, eOSCStreamFraming eFraming );
+
+            /**
+            * @brief Append every received packet with its arrival time and sender to a capture file
+            * @param sFile NULL stops recording
+            */
+            bool Capture( const char* sFile );
+
+            /**
+            * @brief Receive from a capture file instead of the socket, packets sent meanwhile are dropped
+            * @param sFile NULL reopens the socket
+            * @param fSpeed 1 original pacing, 2 twice as fast, 0 as fast as possible
+            */
+            bool Replay( const char* sFile, float fSpeed );
+
+            /**
+            * @brief Send an encoded packet right away, stream transports transmit it on the next Update
+            */
+            bool SendPacket( const void* pData, size_t nSize );
+
+            /**
+            * @brief Send only to the peer the message being dispatched came from, for answers to requests
+            */
+            bool ReplyPacket( const void* pData, size_t nSize );
+
+            /**
+            * @brief Receive and dispatch, then send the changed packets
+            * @param nFrame id of the current frame, further calls with the same id do nothing
+            */
+            void Update( int64 nFrame );
+    };
+
+    /**
+    * @brief Identifies a socket, Connection nodes with the same key share one COSCConnection
+    */
+    struct SOSCConnectionKey
+    {
+        std::string sHost;
+        int nPort;
+        bool bServer;
+        eOSCTransportType eTransport;
+        eOSCStreamFraming eFraming; //!< only relevant for TCP
+
+        bool operator<( const SOSCConnectionKey& other ) const
+        {
+            if ( nPort != other.nPort )
+            {
+                return nPort < other.nPort;
+            }
+
+            if ( bServer != other.bServer )
+            {
+                return bServer < other.bServer;
+            }
+
+            if ( eTransport != other.eTransport )
+            {
+                return eTransport < other.eTransport;
+            }
+
+            if ( eFraming != other.eFraming )
+            {
+                return eFraming < other.eFraming;
+            }
+
+            return sHost < other.sHost;
+        }
+    };
+
+    /**
+    * @param eType connection type, also the nType port of the Connection node
+    */
+    SOSCConnectionKey MakeOSCConnectionKey( const char* sHost, int nPort, EOSCConnectionType eType, int nFraming );
+
+    /**
+    * @brief Get a handle to the pooled connection for key, the socket is opened by the first user
+    */
+    int AcquireOSCConnection( const SOSCConnectionKey& key );
+
+    /**
+    * @brief Move the connection of a handle to other settings without touching its registrations.
+    * Only possible for the only user of a connection if no other connection has the new settings.
+    * @return false if the caller has to release and acquire a connection instead
+    */
+    bool RebindOSCConnection( int nHandle, const SOSCConnectionKey& key );
+
+    /**
+    * @brief Drop a handle and everything registered through it, the socket is closed with the last handle
+    */
+    void ReleaseOSCConnection( int nHandle );
+
+    COSCConnection& GetConnection( int nConnection );
+
+    /**
+    * @brief Connection by id or NULL if it was closed in the meantime
+    */
+    COSCConnection* FindConnection( int nConnection );
+}
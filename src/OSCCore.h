@@ -0,0 +1,111 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <IPluginOSC.h>
+#include <OSCStats.h>
+
+/**
+* @brief Engine independent part of the plugin: connections, packets and message dispatch.
+* The flow nodes and the plugin interface are built on top of it, the CMake build (CMakeLists.txt)
+* compiles it without CryEngine so it can be tested and benchmarked headless.
+*/
+namespace OSCPlugin
+{
+    enum eOSCType
+    {
+        OSCT_String,
+        OSCT_Float32,
+        OSCT_Double64,
+        OSCT_Int32,
+        OSCT_Int64,
+        OSCT_Bool,
+        OSCT_Any,
+        OSCT_Float32Array, //!< blob of big endian float32
+        OSCT_Int32Array, //!< blob of big endian int32
+    };
+
+    /**
+    * @brief Receives the values of a registered receive message, the flow nodes activate their output ports with them.
+    * Value types the flow system has no port type for are narrowed (int64 -> int, double -> float),
+    * the exact value follows as text on nPort + 1.
+    */
+    class IOSCValueSink
+    {
+        public:
+            virtual void OnOSCValue( int nPort, int nValue ) = 0;
+            virtual void OnOSCValue( int nPort, float fValue ) = 0;
+            virtual void OnOSCValue( int nPort, bool bValue ) = 0;
+            virtual void OnOSCValue( int nPort, const char* sValue ) = 0;
+
+        protected:
+            /**
+            * @brief The core never owns a sink, the owner deletes it through its own type
+            */
+            virtual ~IOSCValueSink() {}
+    };
+
+    enum eOSCLogLevel
+    {
+        OSCLL_Always = 0,
+        OSCLL_Warning,
+        OSCLL_Error,
+    };
+
+    typedef void ( *TOSCLogHandler )( eOSCLogLevel eLevel, const char* sMessage );
+
+    /**
+    * @brief Route the log output of the core, without a handler it goes to stderr
+    */
+    void SetOSCLogHandler( TOSCLogHandler pHandler );
+    void OSCLog( eOSCLogLevel eLevel, const char* sFormat, ... );
+
+    extern int g_nOSCMaxPacketsPerUpdate; //!< CVar osc_max_packets_per_update
+    extern float g_fOSCStatsInterval; //!< CVar osc_stats_interval
+    extern float g_fOSCLogInterval; //!< CVar osc_log_interval
+    extern int g_nOSCMaxPeers; //!< CVar osc_max_peers
+
+    // IPluginOSC
+    int OSCOpenConnection( const char* sHost, int nPort, EOSCConnectionType eType, int nFraming );
+    void OSCCloseConnection( int nConnection );
+    bool OSCIsConnectionOk( int nConnection );
+    void OSCAddHandler( int nConnection, const char* sAddress, IOSCMessageHandler* pHandler );
+    void OSCRemoveHandler( int nConnection, IOSCMessageHandler* pHandler );
+    bool OSCSendPacket( int nConnection, const void* pData, size_t nSize );
+    bool OSCReplyPacket( int nConnection, const void* pData, size_t nSize );
+
+    /**
+    * @param nFrame id of the current frame, connections are updated once per frame no matter how many users call this
+    */
+    void OSCUpdateConnections( int64 nFrame );
+
+    /**
+    * @brief Counters of one connection handle or the sum of all connections (nConnection <= 0)
+    * @return number of connections that failed
+    */
+    int OSCGetStats( int nConnection, SOSCStats& stats );
+    int OSCGetConnectionCount();
+    void OSCResetStats( int nConnection );
+    void OSCLogStats();
+
+    void OSCLogLatency();
+    void OSCResetLatency();
+
+    /**
+    * @brief Record what the server connection on nPort receives (see src/OSCCapture.h)
+    * @param sFile NULL stops recording
+    */
+    bool OSCCapture( int nPort, const char* sFile );
+
+    /**
+    * @brief Feed a capture into the server connection on nPort instead of its socket
+    * @param sFile NULL reopens the socket
+    * @param fSpeed 1 original pacing, 2 twice as fast, 0 as fast as possible
+    */
+    bool OSCReplay( int nPort, const char* sFile, float fSpeed );
+
+    /**
+    * @brief Drop all registrations of a value sink, called before it is destroyed
+    */
+    void InvalidateOSCValues( IOSCValueSink* pSink );
+}
@@ -0,0 +1,128 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#include <StdAfx.h>
+#include <OSCDiagnostics.h>
+
+#include <cstdio>
+
+namespace OSCPlugin
+{
+    namespace
+    {
+        struct SReasonInfo
+        {
+            eOSCLogLevel eLevel;
+            const char* sFormat;
+        };
+
+        const SReasonInfo g_Reasons[OSCD_Count] =
+        {
+            { OSCLL_Warning, "message %s received unexpected type" },
+            { OSCLL_Error, "Sock error: %s - is the server running?" },
+        };
+    }
+
+    COSCDiagnostics::COSCDiagnostics()
+    {
+        Clear();
+    }
+
+    void COSCDiagnostics::Clear()
+    {
+        m_Entries.clear();
+        m_nIntervalStart = 0;
+        m_nRepeats = 0;
+    }
+
+    bool COSCDiagnostics::Report( eOSCDiagnostic eReason, int nSubject, const char* sDetail, uint64 nNow )
+    {
+        if ( g_fOSCLogInterval <= 0 )
+        {
+            return true;
+        }
+
+        std::pair<TEntries::iterator, bool> result = m_Entries.insert( TEntries::value_type( std::make_pair( int( eReason ), nSubject ), SEntry() ) );
+
+        if ( result.second )
+        {
+            result.first->second.sDetail = sDetail;
+            result.first->second.nRepeats = 0;
+
+            if ( !m_nIntervalStart )
+            {
+                m_nIntervalStart = nNow;
+            }
+
+            return true;
+        }
+
+        ++result.first->second.nRepeats;
+        ++m_nRepeats;
+        return false;
+    }
+
+    void COSCDiagnostics::Forget( eOSCDiagnostic eReason, int nSubject )
+    {
+        TEntries::iterator iter = m_Entries.find( std::make_pair( int( eReason ), nSubject ) );
+
+        if ( iter != m_Entries.end() )
+        {
+            m_nRepeats -= iter->second.nRepeats;
+            m_Entries.erase( iter );
+        }
+    }
+
+    void COSCDiagnostics::Flush( const char* sPrefix, uint64 nNow )
+    {
+        if ( m_nRepeats )
+        {
+            std::string sSummary;
+            eOSCLogLevel eLevel = OSCLL_Warning;
+            char sLine[512];
+
+            for ( TEntries::const_iterator iter = m_Entries.begin(); iter != m_Entries.end(); ++iter )
+            {
+                if ( !iter->second.nRepeats )
+                {
+                    continue;
+                }
+
+                const SReasonInfo& reason = g_Reasons[iter->first.first];
+                eLevel = reason.eLevel > eLevel ? reason.eLevel : eLevel;
+
+                snprintf( sLine, sizeof( sLine ), reason.sFormat, iter->second.sDetail.c_str() );
+                sLine[sizeof( sLine ) - 1] = 0;
+                sSummary += sSummary.empty() ? "" : "; ";
+                sSummary += sLine;
+
+                snprintf( sLine, sizeof( sLine ), " (%llu times)", ( unsigned long long )iter->second.nRepeats );
+                sSummary += sLine;
+            }
+
+            OSCLog( eLevel, "%s: repeated in the last %.1f s: %s", sPrefix, double( nNow - m_nIntervalStart ) / 1e9, sSummary.c_str() );
+        }
+
+        // what didn't repeat is logged right away again next time
+        for ( TEntries::iterator iter = m_Entries.begin(); iter != m_Entries.end(); )
+        {
+            if ( iter->second.nRepeats )
+            {
+                iter->second.nRepeats = 0;
+                ++iter;
+            }
+
+            else
+            {
+                m_Entries.erase( iter++ );
+            }
+        }
+
+        m_nRepeats = 0;
+        m_nIntervalStart = m_Entries.empty() ? 0 : nNow;
+    }
+
+    void COSCDiagnostics::Log( eOSCDiagnostic eReason, const char* sDetail )
+    {
+        OSCLog( g_Reasons[eReason].eLevel, g_Reasons[eReason].sFormat, sDetail );
+    }
+}
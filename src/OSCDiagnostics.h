@@ -0,0 +1,75 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <OSCCore.h>
+
+#include <map>
+#include <string>
+
+namespace OSCPlugin
+{
+    enum eOSCDiagnostic
+    {
+        OSCD_WrongType = 0, //!< subject is the receive message
+        OSCD_SocketError, //!< subject unused
+        OSCD_Count,
+    };
+
+    /**
+    * @brief Deduplicates the problems of a connection so a misbehaving peer can't flood the log.
+    * The first occurrence of each (reason, subject) is logged right away, repeats are only counted
+    * and reported as one summary line per interval. A problem that didn't repeat within an interval
+    * is forgotten, so it is logged right away again when it comes back.
+    * Has a single writer thread like SOSCStats, so the counters need no locks.
+    */
+    class COSCDiagnostics
+    {
+            struct SEntry
+            {
+                std::string sDetail; //!< of the first occurrence
+                uint64 nRepeats; //!< since the last summary
+            };
+
+            typedef std::map<std::pair<int, int>, SEntry> TEntries;
+            TEntries m_Entries;
+            uint64 m_nIntervalStart;
+            uint64 m_nRepeats; //!< sum of the entries
+
+        public:
+            COSCDiagnostics();
+
+            /**
+            * @brief Count an occurrence
+            * @param sDetail text for the log line, only copied the first time
+            * @return true if this is the first occurrence and should be logged now
+            */
+            bool Report( eOSCDiagnostic eReason, int nSubject, const char* sDetail, uint64 nNow );
+
+            /**
+            * @brief The interval (CVar osc_log_interval) has passed since the first problem
+            */
+            bool IsDue( uint64 nNow ) const
+            {
+                return m_nIntervalStart && nNow - m_nIntervalStart >= uint64( g_fOSCLogInterval * 1e9 );
+            }
+
+            /**
+            * @brief Log one summary line of the repeats and start a new interval
+            * @param sPrefix put before the summary, usually the name of the connection
+            */
+            void Flush( const char* sPrefix, uint64 nNow );
+
+            /**
+            * @brief The subject means something else now, its next problem is logged right away
+            */
+            void Forget( eOSCDiagnostic eReason, int nSubject );
+
+            void Clear();
+
+            /**
+            * @brief Log line of a reason with its detail (address or error text)
+            */
+            static void Log( eOSCDiagnostic eReason, const char* sDetail );
+    };
+}
@@ -0,0 +1,180 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#include <StdAfx.h>
+#include <OSCJitterBuffer.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace OSCPlugin
+{
+    COSCJitterBuffer::COSCJitterBuffer()
+    {
+        m_bEnabled = false;
+        m_nMaxDelayNs = 0;
+        m_nMaxExtrapolationNs = 0;
+        Clear();
+    }
+
+    void COSCJitterBuffer::Configure( bool bEnabled, float fMaxDelay, float fMaxExtrapolation )
+    {
+        m_bEnabled = bEnabled;
+        m_nMaxDelayNs = fMaxDelay > 0 ? uint64( double( fMaxDelay ) * 1e9 ) : 0;
+        m_nMaxExtrapolationNs = fMaxExtrapolation > 0 ? uint64( double( fMaxExtrapolation ) * 1e9 ) : 0;
+        Clear();
+    }
+
+    void COSCJitterBuffer::Clear()
+    {
+        m_nChannels = 0;
+        m_Values.clear();
+        m_nFirst = 0;
+        m_nCount = 0;
+        m_nLastArrival = 0;
+        m_fInterval = 0;
+        m_fJitter = 0;
+        m_fDelay = 0;
+        m_nLastSample = 0;
+        m_bHeld = false;
+    }
+
+    double COSCJitterBuffer::GetTargetDelay() const
+    {
+        double fTarget = m_fInterval + 4 * m_fJitter;
+        return m_nMaxDelayNs && fTarget > double( m_nMaxDelayNs ) ? double( m_nMaxDelayNs ) : fTarget;
+    }
+
+    void COSCJitterBuffer::Push( uint64 nArrival )
+    {
+        int nChannels = int( m_Input.size() );
+
+        if ( nChannels != m_nChannels )
+        {
+            Clear();
+            m_nChannels = nChannels;
+            m_Values.resize( MAX_SAMPLES * nChannels );
+        }
+
+        if ( !nChannels || ( m_nCount && nArrival < m_Times[Slot( m_nCount - 1 )] ) )
+        {
+            return;
+        }
+
+        if ( m_nLastArrival )
+        {
+            // RFC 3550 style running averages, 1/16 per sample
+            double fSpacing = double( nArrival - m_nLastArrival );
+
+            if ( m_fInterval == 0 )
+            {
+                m_fInterval = fSpacing;
+            }
+
+            m_fInterval += ( fSpacing - m_fInterval ) / 16;
+            m_fJitter += ( fabs( fSpacing - m_fInterval ) - m_fJitter ) / 16;
+        }
+
+        m_nLastArrival = nArrival;
+
+        if ( m_nCount == MAX_SAMPLES )
+        {
+            m_nFirst = Slot( 1 );
+            --m_nCount;
+        }
+
+        int nSlot = Slot( m_nCount++ );
+        m_Times[nSlot] = nArrival;
+
+        for ( int i = 0; i < nChannels; ++i )
+        {
+            m_Values[nSlot * nChannels + i] = m_Input[i];
+        }
+
+        m_bHeld = false;
+    }
+
+    const float* COSCJitterBuffer::Sample( uint64 nNow )
+    {
+        if ( !m_nCount )
+        {
+            return NULL;
+        }
+
+        double fTarget = GetTargetDelay();
+
+        if ( !m_nLastSample || nNow <= m_nLastSample )
+        {
+            m_fDelay = m_nLastSample ? m_fDelay : fTarget;
+        }
+
+        else
+        {
+            // stretch or squeeze time by at most 10%, so the output keeps moving forward smoothly
+            double fStep = double( nNow - m_nLastSample ) / 10;
+            m_fDelay += fTarget > m_fDelay ? std::min( fTarget - m_fDelay, fStep ) : -std::min( m_fDelay - fTarget, fStep );
+        }
+
+        m_nLastSample = nNow;
+        uint64 nPlayout = nNow - std::min( uint64( m_fDelay ), nNow );
+
+        // samples before the one preceding the playout time are not needed anymore
+        while ( m_nCount > 2 && m_Times[Slot( 1 )] <= nPlayout )
+        {
+            m_nFirst = Slot( 1 );
+            --m_nCount;
+        }
+
+        m_Output.resize( m_nChannels );
+        uint64 nFirst = m_Times[Slot( 0 )];
+        uint64 nLast = m_Times[Slot( m_nCount - 1 )];
+
+        if ( m_nCount == 1 || nPlayout <= nFirst )
+        {
+            if ( m_nCount == 1 && nPlayout > nFirst )
+            {
+                if ( m_bHeld )
+                {
+                    return NULL;
+                }
+
+                m_bHeld = true;
+            }
+
+            const float* pValues = Values( 0 );
+            m_Output.assign( pValues, pValues + m_nChannels );
+            return &m_Output[0];
+        }
+
+        // interpolate between the first two samples, or extrapolate from the last two
+        int nA = nPlayout < nLast ? 0 : m_nCount - 2;
+        uint64 nTimeA = m_Times[Slot( nA )];
+        uint64 nTimeB = m_Times[Slot( nA + 1 )];
+        uint64 nTime = nPlayout;
+
+        if ( nPlayout >= nLast )
+        {
+            if ( nPlayout - nLast >= m_nMaxExtrapolationNs )
+            {
+                if ( m_bHeld )
+                {
+                    return NULL;
+                }
+
+                m_bHeld = true;
+            }
+
+            nTime = nLast + std::min( nPlayout - nLast, m_nMaxExtrapolationNs );
+        }
+
+        double fT = nTimeB > nTimeA ? double( nTime - nTimeA ) / double( nTimeB - nTimeA ) : 1.0;
+        const float* pA = Values( nA );
+        const float* pB = Values( nA + 1 );
+
+        for ( int i = 0; i < m_nChannels; ++i )
+        {
+            m_Output[i] = float( pA[i] + ( pB[i] - pA[i] ) * fT );
+        }
+
+        return &m_Output[0];
+    }
+}
@@ -0,0 +1,101 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <vector>
+
+namespace OSCPlugin
+{
+    /**
+    * @brief Short history of timestamped samples of a receive message, played back a little delayed so values can be
+    * interpolated at frame time instead of jumping whenever a packet arrives.
+    * The delay follows the measured arrival interval and jitter (interval + 4 * mean deviation, capped),
+    * it changes by at most 10% of the elapsed time so the playout time never runs backwards.
+    * After the newest sample values are extrapolated for a limited time, then held.
+    */
+    class COSCJitterBuffer
+    {
+            enum
+            {
+                MAX_SAMPLES = 32,
+            };
+
+            bool m_bEnabled;
+            uint64 m_nMaxDelayNs;
+            uint64 m_nMaxExtrapolationNs;
+
+            int m_nChannels;
+            uint64 m_Times[MAX_SAMPLES]; //!< ring of arrival times
+            std::vector<float> m_Values; //!< ring of MAX_SAMPLES * m_nChannels
+            int m_nFirst;
+            int m_nCount;
+
+            uint64 m_nLastArrival;
+            double m_fInterval; //!< average ns between arrivals
+            double m_fJitter; //!< average deviation from it
+            double m_fDelay; //!< current playout delay in ns
+            uint64 m_nLastSample; //!< time of the last Sample call
+            bool m_bHeld; //!< the held value was output already
+
+            std::vector<float> m_Input; //!< filled by the receiver before Push
+            std::vector<float> m_Output;
+
+            int Slot( int nSample ) const
+            {
+                return ( m_nFirst + nSample ) % MAX_SAMPLES;
+            }
+
+            const float* Values( int nSample ) const
+            {
+                return &m_Values[Slot( nSample ) * m_nChannels];
+            }
+
+            double GetTargetDelay() const;
+
+        public:
+            COSCJitterBuffer();
+
+            /**
+            * @param fMaxDelay upper limit of the playout delay in seconds
+            * @param fMaxExtrapolation seconds values are extrapolated past the newest sample
+            */
+            void Configure( bool bEnabled, float fMaxDelay, float fMaxExtrapolation );
+
+            bool IsEnabled() const
+            {
+                return m_bEnabled;
+            }
+
+            /**
+            * @brief Scratch for the values of one sample, cleared by the caller
+            */
+            std::vector<float>& GetInput()
+            {
+                return m_Input;
+            }
+
+            /**
+            * @brief Add GetInput() as the sample that arrived at nArrival (see GetOSCWallClockNs).
+            * A different number of values than before starts over.
+            */
+            void Push( uint64 nArrival );
+
+            /**
+            * @brief Values at the playout time nNow - delay
+            * @return NULL if there is nothing new to output (empty, or the held value was returned already)
+            */
+            const float* Sample( uint64 nNow );
+
+            uint64 GetDelayNs() const
+            {
+                return uint64( m_fDelay );
+            }
+
+            int GetChannelCount() const
+            {
+                return m_nChannels;
+            }
+
+            void Clear();
+    };
+}
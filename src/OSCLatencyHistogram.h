@@ -0,0 +1,146 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <cstring>
+
+namespace OSCPlugin
+{
+    /**
+    * @brief Fixed size log-linear latency histogram (HDR histogram style).
+    * Values below 2 * SUB_BUCKETS ns are counted exactly, above that every power of two is split into SUB_BUCKETS
+    * linear buckets, so any recorded value is reported with less than 1/SUB_BUCKETS (1.6%) relative error.
+    * Recording is a couple of integer ops and never allocates.
+    */
+    class COSCLatencyHistogram
+    {
+        public:
+            enum
+            {
+                SUB_BUCKET_BITS = 6,
+                SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+                MAX_VALUE_BITS = 40, //!< values are clamped to ~18 minutes
+                BUCKETS = 2 * SUB_BUCKETS + ( MAX_VALUE_BITS - SUB_BUCKET_BITS - 1 ) * SUB_BUCKETS,
+            };
+
+        private:
+            unsigned int m_Counts[BUCKETS];
+            uint64 m_nTotal;
+            uint64 m_nMin;
+            uint64 m_nMax;
+
+            static int HighestBit( uint64 nValue )
+            {
+                int nBit = 0;
+
+                while ( nValue >>= 1 )
+                {
+                    ++nBit;
+                }
+
+                return nBit;
+            }
+
+            static int GetIndex( uint64 nValue )
+            {
+                if ( nValue < 2 * SUB_BUCKETS )
+                {
+                    return int( nValue );
+                }
+
+                int nBit = HighestBit( nValue );
+                int nShift = nBit - SUB_BUCKET_BITS;
+                int nIndex = 2 * SUB_BUCKETS + ( nBit - SUB_BUCKET_BITS - 1 ) * SUB_BUCKETS + int( nValue >> nShift ) - SUB_BUCKETS;
+                return nIndex < BUCKETS ? nIndex : BUCKETS - 1;
+            }
+
+            /**
+            * @brief Value in the middle of the range counted by a bucket
+            */
+            static uint64 GetValue( int nIndex )
+            {
+                if ( nIndex < 2 * SUB_BUCKETS )
+                {
+                    return uint64( nIndex );
+                }
+
+                int nOctave = ( nIndex - 2 * SUB_BUCKETS ) / SUB_BUCKETS;
+                int nSub = ( nIndex - 2 * SUB_BUCKETS ) % SUB_BUCKETS;
+                int nShift = nOctave + 1;
+                uint64 nLow = uint64( SUB_BUCKETS + nSub ) << nShift;
+                return nLow + ( ( uint64( 1 ) << nShift ) >> 1 );
+            }
+
+        public:
+            COSCLatencyHistogram()
+            {
+                Reset();
+            }
+
+            void Reset()
+            {
+                memset( m_Counts, 0, sizeof( m_Counts ) );
+                m_nTotal = 0;
+                m_nMin = ~uint64( 0 );
+                m_nMax = 0;
+            }
+
+            void Record( uint64 nValue )
+            {
+                ++m_Counts[GetIndex( nValue )];
+                ++m_nTotal;
+                m_nMin = nValue < m_nMin ? nValue : m_nMin;
+                m_nMax = nValue > m_nMax ? nValue : m_nMax;
+            }
+
+            uint64 GetCount() const
+            {
+                return m_nTotal;
+            }
+
+            uint64 GetMin() const
+            {
+                return m_nTotal ? m_nMin : 0;
+            }
+
+            uint64 GetMax() const
+            {
+                return m_nMax;
+            }
+
+            /**
+            * @brief Value below which fPercentile percent of the recorded values fall
+            * @param fPercentile 0..100
+            */
+            uint64 GetPercentile( double fPercentile ) const
+            {
+                if ( !m_nTotal )
+                {
+                    return 0;
+                }
+
+                uint64 nRank = uint64( fPercentile / 100.0 * double( m_nTotal ) + 0.5 );
+                nRank = nRank < 1 ? 1 : ( nRank > m_nTotal ? m_nTotal : nRank );
+
+                uint64 nSeen = 0;
+
+                for ( int i = 0; i < BUCKETS; ++i )
+                {
+                    nSeen += m_Counts[i];
+
+                    if ( nSeen >= nRank )
+                    {
+                        if ( i == BUCKETS - 1 )
+                        {
+                            return m_nMax; // clamped values
+                        }
+
+                        uint64 nValue = GetValue( i );
+                        return nValue > m_nMax ? m_nMax : ( nValue < m_nMin ? m_nMin : nValue );
+                    }
+                }
+
+                return m_nMax;
+            }
+    };
+}
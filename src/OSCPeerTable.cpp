@@ -0,0 +1,181 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#include <StdAfx.h>
+#include <OSCPeerTable.h>
+#include <OSCCore.h>
+
+namespace OSCPlugin
+{
+    COSCPeerTable::COSCPeerTable()
+    {
+        m_nIdleTimeoutNs = 0;
+        Clear();
+    }
+
+    void COSCPeerTable::Clear()
+    {
+        m_Peers.clear();
+        m_Index.assign( 16, -1 );
+        m_nLastEviction = 0;
+    }
+
+    void COSCPeerTable::SetIdleTimeout( uint64 nIdleTimeoutNs )
+    {
+        m_nIdleTimeoutNs = nIdleTimeoutNs;
+    }
+
+    bool COSCPeerTable::MakeKey( const oscpkt::SockAddr& addr, SPeerKey& key )
+    {
+        memset( &key, 0, sizeof( key ) );
+        key.nFamily = addr.addr().sa_family;
+
+        if ( key.nFamily == AF_INET )
+        {
+            const sockaddr_in& in = ( const sockaddr_in& )addr.addr();
+            memcpy( key.addr, &in.sin_addr, sizeof( in.sin_addr ) );
+            key.nPort = in.sin_port;
+            return true;
+        }
+
+        else if ( key.nFamily == AF_INET6 )
+        {
+            const sockaddr_in6& in6 = ( const sockaddr_in6& )addr.addr();
+            memcpy( key.addr, &in6.sin6_addr, sizeof( in6.sin6_addr ) );
+            key.nPort = in6.sin6_port;
+            return true;
+        }
+
+        return false;
+    }
+
+    size_t COSCPeerTable::Hash( const SPeerKey& key )
+    {
+        // FNV-1a, the bytes that differ between peers are few
+        const unsigned char* pBytes = ( const unsigned char* )&key;
+        uint32 nHash = 2166136261u;
+
+        for ( size_t i = 0; i < sizeof( key ); ++i )
+        {
+            nHash ^= pBytes[i];
+            nHash *= 16777619u;
+        }
+
+        return nHash;
+    }
+
+    size_t COSCPeerTable::FindSlot( const SPeerKey& key ) const
+    {
+        size_t nMask = m_Index.size() - 1;
+
+        for ( size_t nSlot = Hash( key ) & nMask; ; nSlot = ( nSlot + 1 ) & nMask )
+        {
+            if ( m_Index[nSlot] < 0 || m_Peers[m_Index[nSlot]].key == key )
+            {
+                return nSlot;
+            }
+        }
+    }
+
+    void COSCPeerTable::Rebuild( size_t nSlots )
+    {
+        m_Index.assign( nSlots, -1 );
+
+        for ( size_t i = 0; i < m_Peers.size(); ++i )
+        {
+            m_Index[FindSlot( m_Peers[i].key )] = int( i );
+        }
+    }
+
+    void COSCPeerTable::Touch( const oscpkt::SockAddr& addr, uint64 nNow )
+    {
+        SPeerKey key;
+
+        if ( !MakeKey( addr, key ) )
+        {
+            return;
+        }
+
+        size_t nSlot = FindSlot( key );
+
+        if ( m_Index[nSlot] >= 0 )
+        {
+            m_Peers[m_Index[nSlot]].nLastSeen = nNow;
+            return;
+        }
+
+        // new peers are rare, a good moment to forget the ones that left
+        size_t nCount = m_Peers.size();
+        Evict( nNow );
+
+        if ( m_Peers.size() != nCount )
+        {
+            nSlot = FindSlot( key );
+        }
+
+        SPeer peer;
+        peer.addr = addr;
+        peer.key = key;
+        peer.nLastSeen = nNow;
+
+        if ( g_nOSCMaxPeers > 0 && m_Peers.size() >= size_t( g_nOSCMaxPeers ) )
+        {
+            // full, a flood of (possibly spoofed) senders only displaces the quietest peers
+            size_t nOldest = 0;
+
+            for ( size_t i = 1; i < m_Peers.size(); ++i )
+            {
+                if ( m_Peers[i].nLastSeen < m_Peers[nOldest].nLastSeen )
+                {
+                    nOldest = i;
+                }
+            }
+
+            m_Peers[nOldest] = peer;
+            Rebuild( m_Index.size() );
+            return;
+        }
+
+        m_Peers.push_back( peer );
+
+        // at most half full, so probe sequences stay short
+        if ( m_Peers.size() * 2 > m_Index.size() )
+        {
+            Rebuild( m_Index.size() * 2 );
+        }
+
+        else
+        {
+            m_Index[nSlot] = int( m_Peers.size() - 1 );
+        }
+    }
+
+    void COSCPeerTable::Evict( uint64 nNow )
+    {
+        if ( !m_nIdleTimeoutNs || nNow - m_nLastEviction < m_nIdleTimeoutNs / 4 )
+        {
+            return;
+        }
+
+        m_nLastEviction = nNow;
+        size_t nKept = 0;
+
+        for ( size_t i = 0; i < m_Peers.size(); ++i )
+        {
+            if ( nNow < m_Peers[i].nLastSeen || nNow - m_Peers[i].nLastSeen < m_nIdleTimeoutNs )
+            {
+                if ( nKept != i )
+                {
+                    m_Peers[nKept] = m_Peers[i];
+                }
+
+                ++nKept;
+            }
+        }
+
+        if ( nKept != m_Peers.size() )
+        {
+            m_Peers.resize( nKept );
+            Rebuild( m_Index.size() );
+        }
+    }
+}
@@ -0,0 +1,83 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <oscpkt/udp.hh>
+
+#include <vector>
+
+namespace OSCPlugin
+{
+    /**
+    * @brief Addresses that sent datagrams to a server socket, to send back to all of them.
+    * Peers are stored densely so a fan out is a plain loop, and found through an open addressing hash index
+    * on ip and port, so a received datagram costs one hash and usually one compare even with hundreds of peers.
+    * Any sender becomes a peer, there is no authentication and source addresses can be spoofed, so fan out is meant for
+    * trusted networks. The table holds at most osc_max_peers peers, a new one replaces the peer that was silent longest.
+    */
+    class COSCPeerTable
+    {
+            struct SPeerKey
+            {
+                unsigned char addr[16]; //!< IPv4 uses the first 4 bytes
+                unsigned short nPort; //!< network byte order
+                unsigned short nFamily;
+
+                bool operator==( const SPeerKey& other ) const
+                {
+                    return nPort == other.nPort && nFamily == other.nFamily && memcmp( addr, other.addr, sizeof( addr ) ) == 0;
+                }
+            };
+
+            struct SPeer
+            {
+                oscpkt::SockAddr addr;
+                SPeerKey key;
+                uint64 nLastSeen; //!< see GetOSCWallClockNs
+            };
+
+            std::vector<SPeer> m_Peers;
+            std::vector<int> m_Index; //!< power of two slots, index into m_Peers or -1
+            uint64 m_nIdleTimeoutNs;
+            uint64 m_nLastEviction;
+
+            static bool MakeKey( const oscpkt::SockAddr& addr, SPeerKey& key );
+            static size_t Hash( const SPeerKey& key );
+
+            /**
+            * @return slot of the key, or the free slot it would go into
+            */
+            size_t FindSlot( const SPeerKey& key ) const;
+            void Rebuild( size_t nSlots );
+
+        public:
+            COSCPeerTable();
+
+            /**
+            * @param nIdleTimeoutNs peers that didn't send anything for this long are dropped, 0 never
+            */
+            void SetIdleTimeout( uint64 nIdleTimeoutNs );
+
+            /**
+            * @brief A datagram arrived from addr, adds the peer or refreshes it, see g_nOSCMaxPeers
+            */
+            void Touch( const oscpkt::SockAddr& addr, uint64 nNow );
+
+            /**
+            * @brief Drop idle peers, does nothing if the last sweep was less than a quarter of the timeout ago
+            */
+            void Evict( uint64 nNow );
+
+            size_t GetCount() const
+            {
+                return m_Peers.size();
+            }
+
+            oscpkt::SockAddr& GetAddress( size_t nPeer )
+            {
+                return m_Peers[nPeer].addr;
+            }
+
+            void Clear();
+    };
+}
@@ -0,0 +1,197 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#include <StdAfx.h>
+#include <OSCSendScheduler.h>
+#include <OSCTrace.h>
+
+namespace OSCPlugin
+{
+    COSCSendScheduler::COSCSendScheduler( IOSCTransport* pTransport, CryMutex& transportLock ) :
+        m_TransportLock( transportLock )
+    {
+        m_pTransport = pTransport;
+        m_nPeriod = 1000000000u / 60;
+        m_bRepeat = false;
+        m_nCoalesceSize = 0;
+        m_bStop = false;
+    }
+
+    COSCSendScheduler::~COSCSendScheduler()
+    {
+    }
+
+    void COSCSendScheduler::SetRate( float fRate, bool bRepeat )
+    {
+        CryAutoLock<CryMutex> lock( m_Lock );
+        m_nPeriod = uint64( 1000000000.0 / ( fRate > 1.0f ? fRate : 1.0f ) );
+        m_bRepeat = bRepeat;
+    }
+
+    void COSCSendScheduler::SetCoalesceSize( size_t nMaxSize )
+    {
+        CryAutoLock<CryMutex> lock( m_Lock );
+        m_nCoalesceSize = nMaxSize;
+    }
+
+    void COSCSendScheduler::Commit( int nPacket, const void* pData, size_t nSize )
+    {
+        CryAutoLock<CryMutex> lock( m_Lock );
+
+        if ( nPacket >= int( m_Committed.size() ) )
+        {
+            m_Committed.resize( nPacket + 1 );
+            m_Committed[nPacket].bDirty = false;
+        }
+
+        SCommittedPacket& packet = m_Committed[nPacket];
+        packet.data.assign( ( const char* )pData, ( const char* )pData + nSize );
+        packet.bDirty = true;
+    }
+
+    SOSCStats COSCSendScheduler::GetStats() const
+    {
+        CryAutoLock<CryMutex> lock( m_TransportLock );
+        return m_Stats;
+    }
+
+    void COSCSendScheduler::Clear()
+    {
+        CryAutoLock<CryMutex> lock( m_Lock );
+        m_Committed.clear();
+    }
+
+    bool COSCSendScheduler::WaitUntil( uint64 nDeadline )
+    {
+        for ( ;; )
+        {
+            uint64 nNow = GetOSCMonotonicClockNs();
+
+            if ( m_bStop )
+            {
+                return false;
+            }
+
+            if ( nNow >= nDeadline )
+            {
+                return true;
+            }
+
+            // rounded up so a tick is never early, it is late by at most the timer resolution and the schedule doesn't drift
+            m_Stop.Wait( uint32( ( nDeadline - nNow + 999999u ) / 1000000u ) );
+        }
+    }
+
+    void COSCSendScheduler::Tick()
+    {
+        size_t nSending = 0;
+
+        {
+            CryAutoLock<CryMutex> lock( m_Lock );
+            m_Coalescer.SetMaxSize( m_nCoalesceSize );
+
+            for ( std::vector<SCommittedPacket>::iterator iter = m_Committed.begin(); iter != m_Committed.end(); ++iter )
+            {
+                if ( ( *iter ).data.empty() || !( ( *iter ).bDirty || m_bRepeat ) )
+                {
+                    continue;
+                }
+
+                if ( nSending == m_Sending.size() )
+                {
+                    m_Sending.push_back( std::vector<char>() );
+                }
+
+                m_Sending[nSending++].assign( ( *iter ).data.begin(), ( *iter ).data.end() );
+                ( *iter ).bDirty = false;
+            }
+        }
+
+        if ( !nSending )
+        {
+            return;
+        }
+
+        OSC_TRACE_SCOPE( "Scheduler Send" );
+        CryAutoLock<CryMutex> lock( m_TransportLock );
+
+        for ( size_t i = 0; i < nSending && m_pTransport->IsOk(); ++i )
+        {
+            const std::vector<char>& packet = m_Sending[i];
+
+            if ( m_Coalescer.GetMaxSize() )
+            {
+                if ( m_Coalescer.Add( &packet[0], packet.size() ) )
+                {
+                    continue;
+                }
+
+                SendCoalesced();
+
+                if ( m_Coalescer.Add( &packet[0], packet.size() ) )
+                {
+                    continue;
+                }
+            }
+
+            m_Stats.CountSend( packet.size(), m_pTransport->SendPacket( &packet[0], packet.size() ) );
+        }
+
+        SendCoalesced();
+        m_pTransport->Flush();
+    }
+
+    void COSCSendScheduler::SendCoalesced()
+    {
+        if ( m_Coalescer.IsEmpty() )
+        {
+            return;
+        }
+
+        if ( m_Coalescer.GetPacketCount() > 1 )
+        {
+            m_Stats.nCoalesced += m_Coalescer.GetPacketCount();
+        }
+
+        m_Stats.CountSend( m_Coalescer.GetSize(), m_pTransport->IsOk() && m_pTransport->SendPacket( m_Coalescer.GetData(), m_Coalescer.GetSize() ) );
+        m_Coalescer.Clear();
+    }
+
+    void COSCSendScheduler::Run()
+    {
+        uint64 nNext = GetOSCMonotonicClockNs();
+
+        while ( !m_bStop )
+        {
+            uint64 nPeriod;
+
+            {
+                CryAutoLock<CryMutex> lock( m_Lock );
+                nPeriod = m_nPeriod;
+            }
+
+            // ticks are spaced from the schedule, not from when the last one finished
+            nNext += nPeriod;
+
+            if ( !WaitUntil( nNext ) )
+            {
+                break;
+            }
+
+            Tick();
+
+            // fell behind by more than a tick (debugger, suspended process), don't burst to catch up
+            uint64 nNow = GetOSCMonotonicClockNs();
+
+            if ( nNow > nNext + nPeriod )
+            {
+                nNext = nNow;
+            }
+        }
+    }
+
+    void COSCSendScheduler::Cancel()
+    {
+        m_bStop = true;
+        m_Stop.Set();
+    }
+}
@@ -0,0 +1,86 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <OSCTransport.h>
+#include <OSCStats.h>
+#include <OSCCoalescer.h>
+
+#include <vector>
+
+namespace OSCPlugin
+{
+    /**
+    * @brief Sends the packets of a connection at a fixed rate on its own thread.
+    * The game thread encodes changed packets once per frame and commits the bytes,
+    * the scheduler thread sends the latest committed version of every packet on each tick.
+    * All transport calls of the connection have to hold the transport lock while the scheduler runs.
+    */
+    class COSCSendScheduler :
+        public CrySimpleThread<>
+    {
+            struct SCommittedPacket
+            {
+                std::vector<char> data;
+                bool bDirty; //!< committed since the last tick
+            };
+
+            IOSCTransport* m_pTransport;
+            CryMutex& m_TransportLock;
+
+            CryMutex m_Lock; //!< guards everything below
+            std::vector<SCommittedPacket> m_Committed;
+            uint64 m_nPeriod; //!< ns between ticks
+            bool m_bRepeat; //!< send every packet on each tick, not just the changed ones
+            size_t m_nCoalesceSize; //!< see SetCoalesceSize
+
+            CryEvent m_Stop;
+            volatile bool m_bStop;
+
+            std::vector<std::vector<char> > m_Sending; //!< copies taken on the scheduler thread, capacity is reused
+            SOSCStats m_Stats; //!< sends of the scheduler thread, written under the transport lock
+            COSCCoalescer m_Coalescer; //!< used on the scheduler thread only
+
+            /**
+            * @brief Sleep until nDeadline (see GetOSCMonotonicClockNs), so system time changes don't shift the ticks
+            * @return false if the scheduler was stopped
+            */
+            bool WaitUntil( uint64 nDeadline );
+
+            void Tick();
+            void SendCoalesced();
+
+        public:
+            COSCSendScheduler( IOSCTransport* pTransport, CryMutex& transportLock );
+            ~COSCSendScheduler();
+
+            /**
+            * @param fRate ticks per second
+            * @param bRepeat resend unchanged packets on every tick
+            */
+            void SetRate( float fRate, bool bRepeat );
+
+            /**
+            * @brief Send the packets of a tick together in bundles of up to nMaxSize bytes, 0 sends each on its own
+            */
+            void SetCoalesceSize( size_t nMaxSize );
+
+            /**
+            * @brief Hand over the current encoding of a packet, replaces a version that wasn't sent yet
+            */
+            void Commit( int nPacket, const void* pData, size_t nSize );
+
+            /**
+            * @brief Snapshot of the counters of the scheduler thread, taken under the transport lock it sends with
+            */
+            SOSCStats GetStats() const;
+
+            /**
+            * @brief Forget all committed packets
+            */
+            void Clear();
+
+            virtual void Run();
+            virtual void Cancel();
+    };
+}
@@ -0,0 +1,541 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#include <StdAfx.h>
+#include <OSCShmTransport.h>
+
+#if defined(_MSC_VER) || defined(WIN32)
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   include <windows.h>
+#   include <intrin.h>
+#else
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <signal.h>
+#   include <unistd.h>
+#   include <cerrno>
+#   include <climits>
+#   include <ctime>
+#   if defined(__linux__)
+#       include <linux/futex.h>
+#       include <sys/syscall.h>
+#   endif
+#endif
+
+#include <cstring>
+#include <cstdio>
+
+namespace OSCPlugin
+{
+    namespace
+    {
+#if defined(_MSC_VER) || defined(WIN32)
+        // volatile accesses have acquire/release semantics with MSVC
+        inline unsigned int LoadAcquire( volatile unsigned int* p )
+        {
+            unsigned int v = *p;
+            _ReadWriteBarrier();
+            return v;
+        }
+
+        inline void StoreRelease( volatile unsigned int* p, unsigned int v )
+        {
+            _ReadWriteBarrier();
+            *p = v;
+        }
+
+        inline int AtomicAdd( volatile int* p, int v )
+        {
+            return InterlockedExchangeAdd( ( volatile long* )p, v ) + v;
+        }
+
+        inline int AtomicLoad( volatile int* p )
+        {
+            return InterlockedCompareExchange( ( volatile long* )p, 0, 0 );
+        }
+
+        inline int AtomicCompareExchange( volatile int* p, int nExpected, int nValue )
+        {
+            return InterlockedCompareExchange( ( volatile long* )p, nValue, nExpected );
+        }
+
+        inline int GetOwnProcessId()
+        {
+            return ( int )GetCurrentProcessId();
+        }
+
+        bool IsProcessAlive( int nPid )
+        {
+            HANDLE hProcess = OpenProcess( SYNCHRONIZE, FALSE, ( DWORD )nPid );
+
+            if ( !hProcess )
+            {
+                return GetLastError() == ERROR_ACCESS_DENIED;
+            }
+
+            bool bAlive = WaitForSingleObject( hProcess, 0 ) == WAIT_TIMEOUT;
+            CloseHandle( hProcess );
+            return bAlive;
+        }
+#else
+        inline unsigned int LoadAcquire( volatile unsigned int* p )
+        {
+            return __atomic_load_n( p, __ATOMIC_ACQUIRE );
+        }
+
+        inline void StoreRelease( volatile unsigned int* p, unsigned int v )
+        {
+            __atomic_store_n( p, v, __ATOMIC_RELEASE );
+        }
+
+        inline int AtomicAdd( volatile int* p, int v )
+        {
+            return __atomic_add_fetch( p, v, __ATOMIC_SEQ_CST );
+        }
+
+        inline int AtomicLoad( volatile int* p )
+        {
+            return __atomic_load_n( p, __ATOMIC_SEQ_CST );
+        }
+
+        inline int AtomicCompareExchange( volatile int* p, int nExpected, int nValue )
+        {
+            return __sync_val_compare_and_swap( p, nExpected, nValue );
+        }
+
+        inline int GetOwnProcessId()
+        {
+            return ( int )getpid();
+        }
+
+        bool IsProcessAlive( int nPid )
+        {
+            return kill( nPid, 0 ) == 0 || errno == EPERM;
+        }
+#endif
+
+        inline unsigned int RecordSize( size_t nSize )
+        {
+            return 4 + ( unsigned int )( ( nSize + 3 ) & ~size_t( 3 ) );
+        }
+    }
+
+    COSCShmRing::COSCShmRing() :
+        m_pHeader( 0 ),
+        m_pData( 0 ),
+        m_nMask( 0 ),
+        m_nPending( 0 ),
+        m_nMappingSize( 0 ),
+        m_pOwner( 0 )
+    {
+#if defined(_MSC_VER) || defined(WIN32)
+        m_hMapping = 0;
+        m_hEvent = 0;
+#else
+        m_nHandle = -1;
+#endif
+    }
+
+    COSCShmRing::~COSCShmRing()
+    {
+        Close();
+    }
+
+    bool COSCShmRing::Open( const std::string& sName, size_t nCapacity, bool bConsumer )
+    {
+        Close();
+        m_sError.clear();
+        m_sName = sName;
+
+        unsigned int nPow2 = SHM_MIN_CAPACITY;
+
+        while ( nPow2 < nCapacity && nPow2 < 0x40000000 )
+        {
+            nPow2 <<= 1;
+        }
+
+        m_nMappingSize = sizeof( SOSCShmHeader ) + nPow2;
+        void* pMemory = 0;
+
+#if defined(_MSC_VER) || defined(WIN32)
+        std::string sMapping = "Local\\" + sName;
+        m_hMapping = CreateFileMappingA( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, ( DWORD )m_nMappingSize, sMapping.c_str() );
+
+        if ( !m_hMapping )
+        {
+            m_sError = "CreateFileMapping failed";
+            return false;
+        }
+
+        pMemory = MapViewOfFile( m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, m_nMappingSize );
+
+        if ( !pMemory )
+        {
+            m_sError = "MapViewOfFile failed";
+            Close();
+            return false;
+        }
+
+        std::string sEvent = "Local\\" + sName + "_signal";
+        m_hEvent = CreateEventA( NULL, FALSE, FALSE, sEvent.c_str() );
+#else
+        std::string sPath = "/" + sName;
+        m_nHandle = shm_open( sPath.c_str(), O_RDWR | O_CREAT, 0600 );
+
+        if ( m_nHandle == -1 )
+        {
+            m_sError = strerror( errno );
+            return false;
+        }
+
+        struct stat st;
+
+        if ( fstat( m_nHandle, &st ) != 0 )
+        {
+            m_sError = strerror( errno );
+            Close();
+            return false;
+        }
+
+        if ( ( size_t )st.st_size < m_nMappingSize )
+        {
+            if ( ftruncate( m_nHandle, m_nMappingSize ) != 0 )
+            {
+                m_sError = strerror( errno );
+                Close();
+                return false;
+            }
+        }
+
+        else
+        {
+            // map an existing ring with the size its creator chose
+            m_nMappingSize = st.st_size;
+        }
+
+        pMemory = mmap( 0, m_nMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_nHandle, 0 );
+
+        if ( pMemory == MAP_FAILED )
+        {
+            pMemory = 0;
+            m_sError = strerror( errno );
+            Close();
+            return false;
+        }
+#endif
+
+        m_pHeader = ( SOSCShmHeader* )pMemory;
+        m_pData = ( char* )pMemory + sizeof( SOSCShmHeader );
+
+        // the header is shared with another process, a capacity that isn't a valid ring size would make the mask reach
+        // past the mapping, so such a header is set up again like a new one
+        unsigned int nExisting = m_pHeader->nCapacity;
+        bool bValid = m_pHeader->nMagic == SHM_MAGIC && nExisting >= SHM_MIN_CAPACITY && ( nExisting & ( nExisting - 1 ) ) == 0
+                      && nExisting <= m_nMappingSize - sizeof( SOSCShmHeader );
+
+        if ( !bValid )
+        {
+            m_pHeader->nCapacity = nPow2;
+            m_pHeader->nHead = 0;
+            m_pHeader->nTail = 0;
+            m_pHeader->nWaiters = 0;
+            m_pHeader->nProducer = 0;
+            m_pHeader->nConsumer = 0;
+            m_pHeader->nMagic = SHM_MAGIC;
+        }
+
+        m_nMask = m_pHeader->nCapacity - 1;
+        m_nPending = 0;
+
+        // take the role, from a process that died without closing too
+        volatile int* pOwner = bConsumer ? &m_pHeader->nConsumer : &m_pHeader->nProducer;
+        int nPid = GetOwnProcessId();
+        int nOwner = AtomicCompareExchange( pOwner, 0, nPid );
+
+        if ( nOwner != 0 && ( nOwner == nPid || IsProcessAlive( nOwner ) || AtomicCompareExchange( pOwner, nOwner, nPid ) != nOwner ) )
+        {
+            m_sError = bConsumer ? "ring already has a consumer" : "ring already has a producer";
+            Close();
+            return false;
+        }
+
+        m_pOwner = pOwner;
+
+        if ( bConsumer )
+        {
+            // the tail belongs to the consumer, so unread data can be dropped while a producer keeps writing
+            StoreRelease( &m_pHeader->nTail, LoadAcquire( &m_pHeader->nHead ) );
+        }
+
+        return true;
+    }
+
+    void COSCShmRing::Close()
+    {
+        bool bLast = false;
+
+        if ( m_pOwner )
+        {
+            AtomicCompareExchange( m_pOwner, GetOwnProcessId(), 0 );
+            int nOther = AtomicLoad( m_pOwner == &m_pHeader->nConsumer ? &m_pHeader->nProducer : &m_pHeader->nConsumer );
+            bLast = nOther == 0 || !IsProcessAlive( nOther );
+            m_pOwner = 0;
+        }
+
+#if defined(_MSC_VER) || defined(WIN32)
+        // the mapping goes away with its last handle
+        ( void )bLast;
+
+        if ( m_pHeader )
+        {
+            UnmapViewOfFile( m_pHeader );
+        }
+
+        if ( m_hMapping )
+        {
+            CloseHandle( m_hMapping );
+            m_hMapping = 0;
+        }
+
+        if ( m_hEvent )
+        {
+            CloseHandle( m_hEvent );
+            m_hEvent = 0;
+        }
+
+#else
+
+        if ( m_pHeader )
+        {
+            munmap( m_pHeader, m_nMappingSize );
+        }
+
+        if ( m_nHandle != -1 )
+        {
+            ::close( m_nHandle );
+            m_nHandle = -1;
+        }
+
+        if ( bLast )
+        {
+            shm_unlink( ( "/" + m_sName ).c_str() );
+        }
+
+#endif
+        m_pHeader = 0;
+        m_pData = 0;
+        m_nPending = 0;
+    }
+
+    void COSCShmRing::Signal()
+    {
+        AtomicAdd( &m_pHeader->nSignal, 1 );
+
+        // only pay for the syscall if somebody is actually sleeping
+        if ( AtomicLoad( &m_pHeader->nWaiters ) > 0 )
+        {
+#if defined(_MSC_VER) || defined(WIN32)
+
+            if ( m_hEvent )
+            {
+                SetEvent( m_hEvent );
+            }
+
+#elif defined(__linux__)
+            syscall( SYS_futex, &m_pHeader->nSignal, FUTEX_WAKE, INT_MAX, 0, 0, 0 );
+#endif
+        }
+    }
+
+    bool COSCShmRing::Write( const void* pData, size_t nSize )
+    {
+        if ( !m_pHeader || !pData || nSize == 0 )
+        {
+            return false;
+        }
+
+        unsigned int nCapacity = m_nMask + 1;
+        unsigned int nRecord = RecordSize( nSize );
+
+        if ( nRecord > nCapacity / 2 )
+        {
+            return false; // too large for this ring
+        }
+
+        unsigned int nHead = m_pHeader->nHead;
+        unsigned int nFree = nCapacity - ( nHead - LoadAcquire( &m_pHeader->nTail ) );
+        unsigned int nPos = nHead & m_nMask;
+        unsigned int nToEnd = nCapacity - nPos;
+
+        if ( nToEnd < nRecord )
+        {
+            // records are never split, skip the tail end of the ring
+            if ( nFree < nToEnd + nRecord )
+            {
+                return false;
+            }
+
+            *( unsigned int* )( m_pData + nPos ) = SHM_WRAP_MARKER;
+            nHead += nToEnd;
+            nPos = 0;
+        }
+
+        else if ( nFree < nRecord )
+        {
+            return false;
+        }
+
+        *( unsigned int* )( m_pData + nPos ) = ( unsigned int )nSize;
+        memcpy( m_pData + nPos + 4, pData, nSize );
+
+        StoreRelease( &m_pHeader->nHead, nHead + nRecord );
+        Signal();
+        return true;
+    }
+
+    bool COSCShmRing::Peek( const char*& pData, size_t& nSize )
+    {
+        if ( !m_pHeader )
+        {
+            return false;
+        }
+
+        unsigned int nTail = m_pHeader->nTail;
+
+        while ( nTail != LoadAcquire( &m_pHeader->nHead ) )
+        {
+            unsigned int nPos = nTail & m_nMask;
+            unsigned int nRecordSize = *( const unsigned int* )( m_pData + nPos );
+
+            if ( nRecordSize == SHM_WRAP_MARKER )
+            {
+                nTail += m_nMask + 1 - nPos;
+                StoreRelease( &m_pHeader->nTail, nTail );
+                continue;
+            }
+
+            if ( nRecordSize > m_nMask + 1 - nPos - 4 )
+            {
+                // corrupt size word, never read past the ring, drop what is unread and resync at the head
+                StoreRelease( &m_pHeader->nTail, LoadAcquire( &m_pHeader->nHead ) );
+                return false;
+            }
+
+            pData = m_pData + nPos + 4;
+            nSize = nRecordSize;
+            m_nPending = RecordSize( nRecordSize );
+            return true;
+        }
+
+        return false;
+    }
+
+    void COSCShmRing::Pop()
+    {
+        if ( m_pHeader && m_nPending )
+        {
+            StoreRelease( &m_pHeader->nTail, m_pHeader->nTail + m_nPending );
+            m_nPending = 0;
+        }
+    }
+
+    bool COSCShmRing::Wait( int nTimeoutMs )
+    {
+        if ( !m_pHeader )
+        {
+            return false;
+        }
+
+        AtomicAdd( &m_pHeader->nWaiters, 1 );
+        int nSignal = AtomicLoad( &m_pHeader->nSignal );
+        bool bData = m_pHeader->nTail != LoadAcquire( &m_pHeader->nHead );
+
+        if ( !bData )
+        {
+#if defined(_MSC_VER) || defined(WIN32)
+
+            if ( m_hEvent )
+            {
+                WaitForSingleObject( m_hEvent, nTimeoutMs < 0 ? INFINITE : ( DWORD )nTimeoutMs );
+            }
+
+#elif defined(__linux__)
+            struct timespec ts;
+            ts.tv_sec = nTimeoutMs / 1000;
+            ts.tv_nsec = ( nTimeoutMs % 1000 ) * 1000000;
+            syscall( SYS_futex, &m_pHeader->nSignal, FUTEX_WAIT, nSignal, nTimeoutMs < 0 ? 0 : &ts, 0, 0 );
+#else
+            ( void )nSignal;
+            usleep( 100 );
+#endif
+            bData = m_pHeader->nTail != LoadAcquire( &m_pHeader->nHead );
+        }
+
+        AtomicAdd( &m_pHeader->nWaiters, -1 );
+        return bData;
+    }
+
+    COSCShmTransport::COSCShmTransport() :
+        m_bServer( false ),
+        m_bHolding( false ),
+        m_pPacket( 0 ),
+        m_nPacketSize( 0 )
+    {
+    }
+
+    std::string COSCShmTransport::GetRingName( int nPort )
+    {
+        char sName[64];
+        sprintf( sName, "osc_shm_%d", nPort );
+        return sName;
+    }
+
+    bool COSCShmTransport::Open( const std::string& /* sHost */, int nPort, bool bServer )
+    {
+        m_bServer = bServer;
+        m_bHolding = false;
+        return m_ring.Open( GetRingName( nPort ), COSCShmRing::SHM_DEFAULT_CAPACITY, bServer );
+    }
+
+    void COSCShmTransport::Close()
+    {
+        m_ring.Close();
+        m_bHolding = false;
+    }
+
+    bool COSCShmTransport::ReceiveNextPacket()
+    {
+        if ( !m_bServer )
+        {
+            return false;
+        }
+
+        // the previous packet has been parsed by now
+        if ( m_bHolding )
+        {
+            m_ring.Pop();
+            m_bHolding = false;
+        }
+
+        m_bHolding = m_ring.Peek( m_pPacket, m_nPacketSize );
+        return m_bHolding;
+    }
+
+    bool COSCShmTransport::WaitForPacket( int nTimeoutMs )
+    {
+        if ( m_bHolding )
+        {
+            m_ring.Pop();
+            m_bHolding = false;
+        }
+
+        return m_ring.Wait( nTimeoutMs );
+    }
+
+    bool COSCShmTransport::SendPacket( const void* pData, size_t nSize )
+    {
+        return !m_bServer && m_ring.Write( pData, nSize );
+    }
+}
@@ -0,0 +1,174 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <OSCTransport.h>
+
+#include <string>
+
+namespace OSCPlugin
+{
+    /**
+    * @brief Header at the start of the shared memory block, counters are kept on separate cache lines.
+    * Record layout inside the ring: uint32 size (host byte order) followed by the raw OSC packet padded to 4 bytes.
+    * A size of SHM_WRAP_MARKER means the rest of the ring is unused and the reader continues at offset 0.
+    * nProducer and nConsumer hold the process id of the side that has the ring open, so a second
+    * producer or consumer is refused instead of corrupting the ring.
+    */
+    struct SOSCShmHeader
+    {
+        unsigned int nMagic;
+        unsigned int nCapacity; //!< size of the data area in bytes, power of two
+        unsigned int pad0[14];
+
+        volatile unsigned int nHead; //!< write position, only modified by the producer
+        unsigned int pad1[15];
+
+        volatile unsigned int nTail; //!< read position, only modified by the consumer
+        unsigned int pad2[15];
+
+        volatile int nSignal; //!< futex word, incremented on every write
+        volatile int nWaiters; //!< consumers blocked in Wait
+        unsigned int pad3[14];
+
+        volatile int nProducer; //!< process id of the producer, 0 if none
+        volatile int nConsumer; //!< process id of the consumer, 0 if none
+        unsigned int pad4[14];
+    };
+
+    /**
+    * @brief Single producer / single consumer packet ring in a named shared memory block.
+    * On Linux the block lives in /dev/shm, on Windows it is a named page file mapping.
+    */
+    class COSCShmRing
+    {
+            SOSCShmHeader* m_pHeader;
+            char* m_pData;
+            unsigned int m_nMask;
+            unsigned int m_nPending; //!< size of the record returned by Peek, released by Pop
+            size_t m_nMappingSize;
+            std::string m_sName;
+            std::string m_sError;
+            volatile int* m_pOwner; //!< nProducer or nConsumer, whichever this side holds
+
+#if defined(_MSC_VER) || defined(WIN32)
+            void* m_hMapping;
+            void* m_hEvent;
+#else
+            int m_nHandle;
+#endif
+
+            void Signal();
+
+        public:
+            enum
+            {
+                SHM_MAGIC = 0x4F534352, //!< 'OSCR'
+                SHM_WRAP_MARKER = 0xFFFFFFFF,
+                SHM_MIN_CAPACITY = 4096,
+                SHM_DEFAULT_CAPACITY = 1024 * 1024,
+            };
+
+            COSCShmRing();
+            ~COSCShmRing();
+
+            /**
+            * @brief Map the ring, it is created if it doesn't exist yet
+            * @param sName name of the ring (without leading slash or prefix)
+            * @param nCapacity data area size, rounded up to a power of two
+            * @param bConsumer open as the consumer, which discards all unread data, otherwise as the producer
+            * @return false if the ring couldn't be mapped or another live process already is the producer/consumer
+            */
+            bool Open( const std::string& sName, size_t nCapacity, bool bConsumer );
+
+            /**
+            * @brief Unmap the ring, the last side to close removes the name (/dev/shm on Linux)
+            */
+            void Close();
+
+            bool IsOpen() const
+            {
+                return m_pHeader != 0;
+            }
+
+            const std::string& GetError() const
+            {
+                return m_sError;
+            }
+
+            /**
+            * @brief Append a packet
+            * @return false if the ring is full, the packet is dropped like a datagram would be
+            */
+            bool Write( const void* pData, size_t nSize );
+
+            /**
+            * @brief Get the next packet without copying it out of the ring
+            * @return false if the ring is empty, the data stays valid until Pop is called
+            */
+            bool Peek( const char*& pData, size_t& nSize );
+
+            /**
+            * @brief Release the packet returned by Peek so the producer can reuse the space
+            */
+            void Pop();
+
+            /**
+            * @brief Block until data is available or the timeout expires
+            */
+            bool Wait( int nTimeoutMs );
+    };
+
+    /**
+    * @brief Transport for peers on the same machine, packets are byte identical to the UDP transport.
+    * The ring is named after the port (the host is ignored), servers consume and clients produce.
+    * There is one producer and one consumer per port, further clients or servers fail to open.
+    */
+    class COSCShmTransport : public IOSCTransport
+    {
+            COSCShmRing m_ring;
+            bool m_bServer;
+            bool m_bHolding; //!< a packet returned by ReceiveNextPacket still occupies the ring
+            const char* m_pPacket;
+            size_t m_nPacketSize;
+
+        public:
+            COSCShmTransport();
+
+            static std::string GetRingName( int nPort );
+
+            // IOSCTransport
+            bool Open( const std::string& sHost, int nPort, bool bServer );
+            void Close();
+            bool WaitForPacket( int nTimeoutMs );
+
+            bool IsOk() const
+            {
+                return m_ring.GetError().empty();
+            }
+
+            std::string GetErrorMessage() const
+            {
+                return m_ring.GetError();
+            }
+
+            bool ReceiveNextPacket();
+
+            const void* GetPacketData() const
+            {
+                return m_pPacket;
+            }
+
+            size_t GetPacketSize() const
+            {
+                return m_nPacketSize;
+            }
+
+            bool SendPacket( const void* pData, size_t nSize );
+
+            void Release()
+            {
+                delete this;
+            }
+    };
+}
@@ -0,0 +1,94 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+namespace OSCPlugin
+{
+    /**
+    * @brief Traffic counters of a connection.
+    * Every instance has a single writer thread, so counting needs no locks or atomics;
+    * readers on other threads may see a count that is a few packets old.
+    */
+    struct SOSCStats
+    {
+        uint64 nPacketsIn;
+        uint64 nBytesIn;
+        uint64 nMessagesIn;
+        uint64 nPacketsOut;
+        uint64 nBytesOut;
+        uint64 nCoalesced; //!< packets that went out inside a bundle with others instead of a datagram of their own
+        uint64 nSuppressed; //!< sends skipped because the packet was the same as its last send
+        uint64 nParseErrors; //!< packets that were not valid OSC
+        uint64 nUnmatched; //!< messages no receive message or handler was registered for
+        uint64 nTypeMismatches; //!< values dropped because the argument had another type
+        uint64 nSendFailures;
+        uint64 nUpdates;
+        uint64 nUpdateNs; //!< time spent in Update
+        uint64 nUpdateMaxNs;
+
+        SOSCStats()
+        {
+            Reset();
+        }
+
+        void Reset()
+        {
+            nPacketsIn = nBytesIn = nMessagesIn = 0;
+            nPacketsOut = nBytesOut = nCoalesced = nSuppressed = 0;
+            nParseErrors = nUnmatched = nTypeMismatches = nSendFailures = 0;
+            nUpdates = nUpdateNs = nUpdateMaxNs = 0;
+        }
+
+        void Add( const SOSCStats& other )
+        {
+            nPacketsIn += other.nPacketsIn;
+            nBytesIn += other.nBytesIn;
+            nMessagesIn += other.nMessagesIn;
+            nPacketsOut += other.nPacketsOut;
+            nBytesOut += other.nBytesOut;
+            nCoalesced += other.nCoalesced;
+            nSuppressed += other.nSuppressed;
+            nParseErrors += other.nParseErrors;
+            nUnmatched += other.nUnmatched;
+            nTypeMismatches += other.nTypeMismatches;
+            nSendFailures += other.nSendFailures;
+            nUpdates += other.nUpdates;
+            nUpdateNs += other.nUpdateNs;
+            nUpdateMaxNs = other.nUpdateMaxNs > nUpdateMaxNs ? other.nUpdateMaxNs : nUpdateMaxNs;
+        }
+
+        /**
+        * @brief Counters since base was taken, the max update time is kept as is
+        */
+        void Subtract( const SOSCStats& base )
+        {
+            nPacketsIn -= base.nPacketsIn;
+            nBytesIn -= base.nBytesIn;
+            nMessagesIn -= base.nMessagesIn;
+            nPacketsOut -= base.nPacketsOut;
+            nBytesOut -= base.nBytesOut;
+            nCoalesced -= base.nCoalesced;
+            nSuppressed -= base.nSuppressed;
+            nParseErrors -= base.nParseErrors;
+            nUnmatched -= base.nUnmatched;
+            nTypeMismatches -= base.nTypeMismatches;
+            nSendFailures -= base.nSendFailures;
+            nUpdates -= base.nUpdates;
+            nUpdateNs -= base.nUpdateNs;
+        }
+
+        void CountSend( size_t nSize, bool bOk )
+        {
+            if ( bOk )
+            {
+                ++nPacketsOut;
+                nBytesOut += nSize;
+            }
+
+            else
+            {
+                ++nSendFailures;
+            }
+        }
+    };
+}
@@ -0,0 +1,783 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#include <StdAfx.h>
+#include <OSCTcpTransport.h>
+
+#if defined(_MSC_VER) || defined(WIN32)
+#   include <winsock2.h>
+#   include <ws2tcpip.h>
+#else
+#   include <sys/socket.h>
+#   include <netinet/in.h>
+#   include <netinet/tcp.h>
+#   include <netdb.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <cerrno>
+#endif
+
+#include <cstring>
+#include <cstdio>
+
+namespace OSCPlugin
+{
+    namespace
+    {
+        const unsigned char SLIP_END = 0xC0;
+        const unsigned char SLIP_ESC = 0xDB;
+        const unsigned char SLIP_ESC_END = 0xDC;
+        const unsigned char SLIP_ESC_ESC = 0xDD;
+
+        const size_t MAX_STREAM_PACKET = 16 * 1024 * 1024; //!< reject packets (length prefixes or SLIP frames) above this
+
+#if defined(_MSC_VER) || defined(WIN32)
+        int LastSocketError()
+        {
+            return WSAGetLastError();
+        }
+
+        bool IsWouldBlock( int nError )
+        {
+            return nError == WSAEWOULDBLOCK || nError == WSAEINPROGRESS || nError == WSAEINTR;
+        }
+
+        void CloseSocket( int nHandle )
+        {
+            ::closesocket( nHandle );
+        }
+
+        bool SetNonBlocking( int nHandle )
+        {
+            u_long nMode = 1;
+            return ioctlsocket( nHandle, FIONBIO, &nMode ) == 0;
+        }
+
+        std::string SocketErrorString( int nError )
+        {
+            char s[64];
+            _snprintf_s( s, 64, 64, "system error #%d", nError );
+            return s;
+        }
+
+        bool IsListenSocketBroken( int nError )
+        {
+            return nError == WSAENOTSOCK || nError == WSAEINVAL || nError == WSAEOPNOTSUPP || nError == WSANOTINITIALISED;
+        }
+
+        const int SEND_FLAGS = 0;
+#else
+        int LastSocketError()
+        {
+            return errno;
+        }
+
+        bool IsWouldBlock( int nError )
+        {
+            return nError == EAGAIN || nError == EWOULDBLOCK || nError == EINPROGRESS || nError == EINTR;
+        }
+
+        void CloseSocket( int nHandle )
+        {
+            ::close( nHandle );
+        }
+
+        bool SetNonBlocking( int nHandle )
+        {
+            int nFlags = fcntl( nHandle, F_GETFL, 0 );
+            return nFlags != -1 && fcntl( nHandle, F_SETFL, nFlags | O_NONBLOCK ) == 0;
+        }
+
+        std::string SocketErrorString( int nError )
+        {
+            return strerror( nError );
+        }
+
+        bool IsListenSocketBroken( int nError )
+        {
+            return nError == EBADF || nError == ENOTSOCK || nError == EINVAL || nError == EOPNOTSUPP;
+        }
+
+#   ifdef MSG_NOSIGNAL
+        const int SEND_FLAGS = MSG_NOSIGNAL;
+#   else
+        const int SEND_FLAGS = 0;
+#   endif
+#endif
+
+        void SetNoDelay( int nHandle )
+        {
+            // we coalesce packets ourselves, Nagle would only add latency
+            int nFlag = 1;
+            setsockopt( nHandle, IPPROTO_TCP, TCP_NODELAY, ( const char* )&nFlag, sizeof( nFlag ) );
+        }
+    }
+
+    COSCStreamDecoder::COSCStreamDecoder( eOSCStreamFraming eFraming ) :
+        m_eFraming( eFraming )
+    {
+        Reset();
+    }
+
+    void COSCStreamDecoder::Reset()
+    {
+        m_Frame.clear();
+        m_bEscape = false;
+        m_nExpected = 0;
+        m_Ready.clear();
+        m_ReadyPackets.clear();
+        m_nNextReady = 0;
+    }
+
+    bool COSCStreamDecoder::Feed( const char* pData, size_t nSize )
+    {
+        if ( m_nNextReady == m_ReadyPackets.size() )
+        {
+            // everything handed out, reuse the buffer
+            m_Ready.clear();
+            m_ReadyPackets.clear();
+            m_nNextReady = 0;
+        }
+
+        const char* pEnd = pData + nSize;
+
+        if ( m_eFraming == OSCSF_Slip )
+        {
+            for ( ; pData != pEnd; ++pData )
+            {
+                unsigned char c = ( unsigned char )*pData;
+
+                if ( m_Frame.size() >= MAX_STREAM_PACKET && c != SLIP_END )
+                {
+                    // same limit as a length prefix, a peer that never ends its frame can't grow the buffer without bound
+                    m_Frame.clear();
+                    m_bEscape = false;
+                    return false;
+                }
+
+                if ( m_bEscape )
+                {
+                    m_bEscape = false;
+                    m_Frame.push_back( c == SLIP_ESC_END ? ( char )SLIP_END : c == SLIP_ESC_ESC ? ( char )SLIP_ESC : ( char )c );
+                }
+
+                else if ( c == SLIP_ESC )
+                {
+                    m_bEscape = true;
+                }
+
+                else if ( c == SLIP_END )
+                {
+                    // empty frames are the leading END of double ended SLIP
+                    if ( !m_Frame.empty() )
+                    {
+                        m_ReadyPackets.push_back( std::make_pair( m_Ready.size(), m_Frame.size() ) );
+                        m_Ready.insert( m_Ready.end(), m_Frame.begin(), m_Frame.end() );
+                        m_Frame.clear();
+                    }
+                }
+
+                else
+                {
+                    m_Frame.push_back( c );
+                }
+            }
+
+            return true;
+        }
+
+        while ( pData != pEnd )
+        {
+            if ( m_nExpected == 0 )
+            {
+                // collect the 4 byte big endian length prefix
+                size_t nNeeded = std::min<size_t>( 4 - m_Frame.size(), pEnd - pData );
+                m_Frame.insert( m_Frame.end(), pData, pData + nNeeded );
+                pData += nNeeded;
+
+                if ( m_Frame.size() < 4 )
+                {
+                    break;
+                }
+
+                const unsigned char* p = ( const unsigned char* )&m_Frame[0];
+                m_nExpected = ( size_t( p[0] ) << 24 ) | ( size_t( p[1] ) << 16 ) | ( size_t( p[2] ) << 8 ) | size_t( p[3] );
+                m_Frame.clear();
+
+                if ( m_nExpected == 0 || m_nExpected > MAX_STREAM_PACKET )
+                {
+                    m_nExpected = 0;
+                    return false;
+                }
+
+                continue;
+            }
+
+            size_t nMissing = m_nExpected - m_Frame.size();
+            size_t nAvailable = pEnd - pData;
+
+            if ( m_Frame.empty() && nAvailable >= m_nExpected )
+            {
+                // whole packet inside this chunk, skip the staging buffer
+                m_ReadyPackets.push_back( std::make_pair( m_Ready.size(), m_nExpected ) );
+                m_Ready.insert( m_Ready.end(), pData, pData + m_nExpected );
+                pData += m_nExpected;
+                m_nExpected = 0;
+                continue;
+            }
+
+            size_t nTake = std::min( nMissing, nAvailable );
+            m_Frame.insert( m_Frame.end(), pData, pData + nTake );
+            pData += nTake;
+
+            if ( m_Frame.size() == m_nExpected )
+            {
+                m_ReadyPackets.push_back( std::make_pair( m_Ready.size(), m_Frame.size() ) );
+                m_Ready.insert( m_Ready.end(), m_Frame.begin(), m_Frame.end() );
+                m_Frame.clear();
+                m_nExpected = 0;
+            }
+        }
+
+        return true;
+    }
+
+    bool COSCStreamDecoder::PopPacket( const char*& pData, size_t& nSize )
+    {
+        if ( m_nNextReady >= m_ReadyPackets.size() )
+        {
+            return false;
+        }
+
+        const std::pair<size_t, size_t>& packet = m_ReadyPackets[m_nNextReady++];
+        pData = &m_Ready[packet.first];
+        nSize = packet.second;
+        return true;
+    }
+
+    void COSCStreamDecoder::Encode( eOSCStreamFraming eFraming, const void* pData, size_t nSize, std::vector<char>& out )
+    {
+        const unsigned char* p = ( const unsigned char* )pData;
+
+        if ( eFraming == OSCSF_LengthPrefix )
+        {
+            size_t nPos = out.size();
+            out.resize( nPos + 4 + nSize );
+            out[nPos] = char( ( nSize >> 24 ) & 0xFF );
+            out[nPos + 1] = char( ( nSize >> 16 ) & 0xFF );
+            out[nPos + 2] = char( ( nSize >> 8 ) & 0xFF );
+            out[nPos + 3] = char( nSize & 0xFF );
+
+            if ( nSize )
+            {
+                memcpy( &out[nPos + 4], p, nSize );
+            }
+
+            return;
+        }
+
+        // worst case every byte needs escaping
+        out.reserve( out.size() + nSize * 2 + 2 );
+        out.push_back( ( char )SLIP_END );
+
+        for ( size_t i = 0; i < nSize; ++i )
+        {
+            if ( p[i] == SLIP_END )
+            {
+                out.push_back( ( char )SLIP_ESC );
+                out.push_back( ( char )SLIP_ESC_END );
+            }
+
+            else if ( p[i] == SLIP_ESC )
+            {
+                out.push_back( ( char )SLIP_ESC );
+                out.push_back( ( char )SLIP_ESC_ESC );
+            }
+
+            else
+            {
+                out.push_back( ( char )p[i] );
+            }
+        }
+
+        out.push_back( ( char )SLIP_END );
+    }
+
+    COSCTcpTransport::COSCTcpTransport( eOSCStreamFraming eFraming ) :
+        m_eFraming( eFraming ),
+        m_bServer( false ),
+        m_nListenHandle( -1 ),
+        m_nNextPeer( 0 ),
+        m_pPacket( 0 ),
+        m_nPacketSize( 0 ),
+        m_nServerAddrLen( 0 ),
+        m_nReconnectAt( 0 ),
+        m_nReconnectDelay( 0 )
+    {
+#if defined(_MSC_VER) || defined(WIN32)
+        WSADATA wsa_data;
+
+        if ( WSAStartup( MAKEWORD( 2, 2 ), &wsa_data ) != 0 )
+        {
+            SetError( "winsock failed to initialise" );
+        }
+
+#endif
+    }
+
+    COSCTcpTransport::~COSCTcpTransport()
+    {
+        Close();
+#if defined(_MSC_VER) || defined(WIN32)
+        WSACleanup();
+#endif
+    }
+
+    void COSCTcpTransport::SetError( const std::string& sError )
+    {
+        if ( m_sError.empty() )
+        {
+            m_sError = sError;
+        }
+    }
+
+    void COSCTcpTransport::Close()
+    {
+        while ( !m_Peers.empty() )
+        {
+            ClosePeer( m_Peers.size() - 1 );
+        }
+
+        if ( m_nListenHandle != -1 )
+        {
+            CloseSocket( m_nListenHandle );
+            m_nListenHandle = -1;
+        }
+
+        m_nNextPeer = 0;
+        m_pPacket = 0;
+        m_nPacketSize = 0;
+        m_nServerAddrLen = 0;
+        m_nReconnectAt = 0;
+        m_nReconnectDelay = 0;
+    }
+
+    void COSCTcpTransport::ClosePeer( size_t nPeer )
+    {
+        if ( m_Peers[nPeer].nHandle != -1 )
+        {
+            CloseSocket( m_Peers[nPeer].nHandle );
+        }
+
+        m_Peers.erase( m_Peers.begin() + nPeer );
+        m_nNextPeer = 0;
+        m_pPacket = 0; // its peer may be gone, nothing to reply to
+
+        if ( !m_bServer && m_Peers.empty() && m_nServerAddrLen )
+        {
+            ScheduleReconnect();
+        }
+    }
+
+    void COSCTcpTransport::ScheduleReconnect()
+    {
+        uint64 nMin = uint64( RECONNECT_MIN_MS ) * 1000000u;
+        uint64 nMax = uint64( RECONNECT_MAX_MS ) * 1000000u;
+        m_nReconnectDelay = m_nReconnectDelay ? std::min( m_nReconnectDelay * 2, nMax ) : nMin;
+        m_nReconnectAt = GetOSCMonotonicClockNs() + m_nReconnectDelay;
+    }
+
+    void COSCTcpTransport::UpdateReconnect()
+    {
+        if ( m_nReconnectAt && GetOSCMonotonicClockNs() >= m_nReconnectAt )
+        {
+            m_nReconnectAt = 0;
+            Connect();
+        }
+    }
+
+    void COSCTcpTransport::Connect()
+    {
+        const sockaddr* pAddr = ( const sockaddr* )&m_ServerAddr;
+        int nHandle = ( int )socket( pAddr->sa_family, SOCK_STREAM, IPPROTO_TCP );
+
+        if ( nHandle == -1 || !SetNonBlocking( nHandle ) )
+        {
+            if ( nHandle != -1 )
+            {
+                CloseSocket( nHandle );
+            }
+
+            ScheduleReconnect();
+            return;
+        }
+
+        SetNoDelay( nHandle );
+
+        bool bConnecting = false;
+
+        if ( connect( nHandle, pAddr, m_nServerAddrLen ) != 0 )
+        {
+            if ( !IsWouldBlock( LastSocketError() ) )
+            {
+                CloseSocket( nHandle );
+                ScheduleReconnect();
+                return;
+            }
+
+            bConnecting = true;
+        }
+
+        else
+        {
+            m_nReconnectDelay = 0;
+        }
+
+        m_Peers.push_back( SStreamPeer( nHandle, m_eFraming ) );
+        m_Peers.back().bConnecting = bConnecting;
+    }
+
+    bool COSCTcpTransport::Open( const std::string& sHost, int nPort, bool bServer )
+    {
+        Close();
+        m_sError.clear();
+        m_bServer = bServer;
+
+        char sPort[64];
+        sprintf( sPort, "%d", nPort );
+
+        struct addrinfo hints;
+        struct addrinfo* result = 0;
+        memset( &hints, 0, sizeof( hints ) );
+        hints.ai_family = AF_INET; // same default as oscpkt::UdpSocket
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = bServer ? AI_PASSIVE : 0;
+
+        int err = getaddrinfo( bServer ? 0 : sHost.c_str(), sPort, &hints, &result );
+
+        if ( err != 0 )
+        {
+            SetError( gai_strerror( err ) );
+            return false;
+        }
+
+        if ( !bServer )
+        {
+            // the address is kept for reconnects, a server that isn't up yet is retried
+            memcpy( &m_ServerAddr, result->ai_addr, std::min<size_t>( result->ai_addrlen, sizeof( m_ServerAddr ) ) );
+            m_nServerAddrLen = ( int )result->ai_addrlen;
+            freeaddrinfo( result );
+            Connect();
+            return true;
+        }
+
+        for ( struct addrinfo* rp = result; rp; rp = rp->ai_next )
+        {
+            int nHandle = ( int )socket( rp->ai_family, rp->ai_socktype, rp->ai_protocol );
+
+            if ( nHandle == -1 )
+            {
+                continue;
+            }
+
+            if ( !SetNonBlocking( nHandle ) )
+            {
+                CloseSocket( nHandle );
+                continue;
+            }
+
+            int nReuse = 1;
+            setsockopt( nHandle, SOL_SOCKET, SO_REUSEADDR, ( const char* )&nReuse, sizeof( nReuse ) );
+
+            if ( bind( nHandle, rp->ai_addr, ( int )rp->ai_addrlen ) != 0 || listen( nHandle, SOMAXCONN ) != 0 )
+            {
+                CloseSocket( nHandle );
+                continue;
+            }
+
+            m_nListenHandle = nHandle;
+            break;
+        }
+
+        freeaddrinfo( result );
+
+        if ( m_nListenHandle == -1 )
+        {
+            SetError( "bind failed" );
+            return false;
+        }
+
+        return true;
+    }
+
+    void COSCTcpTransport::AcceptPeers()
+    {
+        if ( m_nListenHandle == -1 )
+        {
+            return;
+        }
+
+        while ( true )
+        {
+            int nHandle = ( int )accept( m_nListenHandle, 0, 0 );
+
+            if ( nHandle == -1 )
+            {
+                int nError = LastSocketError();
+
+                // aborted handshakes, running out of descriptors or network errors only concern the pending connection,
+                // it is accepted again on the next update
+                if ( IsListenSocketBroken( nError ) )
+                {
+                    SetError( SocketErrorString( nError ) );
+                }
+
+                return;
+            }
+
+            if ( !SetNonBlocking( nHandle ) )
+            {
+                CloseSocket( nHandle );
+                continue;
+            }
+
+            SetNoDelay( nHandle );
+            m_Peers.push_back( SStreamPeer( nHandle, m_eFraming ) );
+        }
+    }
+
+    bool COSCTcpTransport::ReadPeer( SStreamPeer& peer )
+    {
+        if ( peer.bConnecting )
+        {
+            return true;
+        }
+
+        char buffer[READ_CHUNK];
+
+        while ( true )
+        {
+            int nRead = ( int )recv( peer.nHandle, buffer, sizeof( buffer ), 0 );
+
+            if ( nRead == 0 )
+            {
+                return false; // orderly shutdown by the peer
+            }
+
+            if ( nRead < 0 )
+            {
+                return IsWouldBlock( LastSocketError() );
+            }
+
+            if ( !peer.decoder.Feed( buffer, nRead ) )
+            {
+                return false; // out of sync, the stream can't be recovered
+            }
+
+            if ( nRead < ( int )sizeof( buffer ) )
+            {
+                return true;
+            }
+        }
+    }
+
+    bool COSCTcpTransport::ReceiveNextPacket()
+    {
+        if ( !IsOk() )
+        {
+            return false;
+        }
+
+        if ( m_bServer )
+        {
+            AcceptPeers();
+        }
+
+        else
+        {
+            UpdateReconnect();
+        }
+
+        for ( int nPass = 0; nPass < 2; ++nPass )
+        {
+            for ( size_t i = 0; i < m_Peers.size(); ++i )
+            {
+                size_t nPeer = ( m_nNextPeer + i ) % m_Peers.size();
+
+                if ( m_Peers[nPeer].decoder.PopPacket( m_pPacket, m_nPacketSize ) )
+                {
+                    m_nNextPeer = nPeer;
+                    return true;
+                }
+            }
+
+            if ( nPass == 0 )
+            {
+                // nothing buffered, pull everything the kernel has for us
+                for ( size_t nPeer = m_Peers.size(); nPeer-- > 0; )
+                {
+                    if ( !ReadPeer( m_Peers[nPeer] ) )
+                    {
+                        ClosePeer( nPeer );
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    std::string COSCTcpTransport::GetPacketSender() const
+    {
+        if ( !m_pPacket || m_nNextPeer >= m_Peers.size() )
+        {
+            return std::string();
+        }
+
+        sockaddr_storage addr;
+        socklen_t nLen = sizeof( addr );
+        char sHost[256], sService[32];
+
+        if ( getpeername( m_Peers[m_nNextPeer].nHandle, ( sockaddr* )&addr, &nLen ) != 0
+                || getnameinfo( ( sockaddr* )&addr, nLen, sHost, sizeof( sHost ), sService, sizeof( sService ), NI_NUMERICHOST | NI_NUMERICSERV ) != 0 )
+        {
+            return std::string();
+        }
+
+        return std::string( sHost ) + ":" + sService;
+    }
+
+    bool COSCTcpTransport::WaitForPacket( int nTimeoutMs )
+    {
+        std::vector<int> handles;
+        handles.reserve( m_Peers.size() + 1 );
+
+        for ( std::vector<SStreamPeer>::const_iterator iter = m_Peers.begin(); iter != m_Peers.end(); ++iter )
+        {
+            handles.push_back( ( *iter ).nHandle );
+        }
+
+        if ( m_nListenHandle != -1 )
+        {
+            handles.push_back( m_nListenHandle );
+        }
+
+        return !handles.empty() && WaitForOSCSockets( &handles[0], handles.size(), false, nTimeoutMs );
+    }
+
+    bool COSCTcpTransport::SendPacket( const void* pData, size_t nSize )
+    {
+        if ( !IsOk() || !pData || nSize == 0 || m_Peers.empty() )
+        {
+            return false;
+        }
+
+        bool bRet = true;
+
+        for ( std::vector<SStreamPeer>::iterator iter = m_Peers.begin(); iter != m_Peers.end(); ++iter )
+        {
+            bRet &= QueuePacket( *iter, pData, nSize );
+        }
+
+        return bRet;
+    }
+
+    bool COSCTcpTransport::ReplyPacket( const void* pData, size_t nSize )
+    {
+        if ( !IsOk() || !pData || nSize == 0 || !m_pPacket || m_nNextPeer >= m_Peers.size() )
+        {
+            return false;
+        }
+
+        return QueuePacket( m_Peers[m_nNextPeer], pData, nSize );
+    }
+
+    bool COSCTcpTransport::QueuePacket( SStreamPeer& peer, const void* pData, size_t nSize )
+    {
+        if ( peer.sendBuffer.size() - peer.nSendOffset + nSize > MAX_SEND_BUFFER )
+        {
+            return false; // peer is not reading, drop instead of growing without bound
+        }
+
+        COSCStreamDecoder::Encode( m_eFraming, pData, nSize, peer.sendBuffer );
+        return true;
+    }
+
+    bool COSCTcpTransport::FlushPeer( SStreamPeer& peer )
+    {
+        if ( peer.bConnecting )
+        {
+            if ( !WaitForOSCSockets( &peer.nHandle, 1, true, 0 ) )
+            {
+                return true; // still connecting
+            }
+
+            int nError = 0;
+            socklen_t nLen = sizeof( nError );
+            getsockopt( peer.nHandle, SOL_SOCKET, SO_ERROR, ( char* )&nError, &nLen );
+
+            if ( nError != 0 )
+            {
+                return false; // refused, retried with the next reconnect
+            }
+
+            peer.bConnecting = false;
+            m_nReconnectDelay = 0;
+        }
+
+        while ( peer.nSendOffset < peer.sendBuffer.size() )
+        {
+            int nSent = ( int )send( peer.nHandle, &peer.sendBuffer[peer.nSendOffset], ( int )( peer.sendBuffer.size() - peer.nSendOffset ), SEND_FLAGS );
+
+            if ( nSent < 0 )
+            {
+                int nError = LastSocketError();
+
+                if ( IsWouldBlock( nError ) )
+                {
+                    break;
+                }
+
+                return false;
+            }
+
+            peer.nSendOffset += nSent;
+        }
+
+        if ( peer.nSendOffset == peer.sendBuffer.size() )
+        {
+            peer.sendBuffer.clear();
+            peer.nSendOffset = 0;
+        }
+
+        else if ( peer.nSendOffset > peer.sendBuffer.size() / 2 )
+        {
+            peer.sendBuffer.erase( peer.sendBuffer.begin(), peer.sendBuffer.begin() + peer.nSendOffset );
+            peer.nSendOffset = 0;
+        }
+
+        return true;
+    }
+
+    bool COSCTcpTransport::Flush()
+    {
+        if ( !IsOk() )
+        {
+            return false;
+        }
+
+        if ( !m_bServer )
+        {
+            UpdateReconnect();
+        }
+
+        for ( size_t nPeer = m_Peers.size(); nPeer-- > 0; )
+        {
+            if ( !FlushPeer( m_Peers[nPeer] ) )
+            {
+                ClosePeer( nPeer );
+            }
+        }
+
+        return IsOk();
+    }
+}
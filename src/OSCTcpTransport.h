@@ -0,0 +1,166 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <OSCTransport.h>
+
+#include <string>
+#include <vector>
+
+namespace OSCPlugin
+{
+    /**
+    * @brief Incremental decoder that splits a byte stream into OSC packets.
+    * Bytes can be fed in arbitrary chunks, completed packets are kept in one contiguous buffer until they are popped.
+    */
+    class COSCStreamDecoder
+    {
+            eOSCStreamFraming m_eFraming;
+            std::vector<char> m_Frame; //!< packet currently being assembled
+            bool m_bEscape; //!< SLIP escape byte seen
+            size_t m_nExpected; //!< length prefix of the current packet, 0 while reading the prefix
+
+            std::vector<char> m_Ready; //!< completed packets, back to back
+            std::vector<std::pair<size_t, size_t> > m_ReadyPackets; //!< offset/size pairs into m_Ready
+            size_t m_nNextReady;
+
+        public:
+            COSCStreamDecoder( eOSCStreamFraming eFraming = OSCSF_Slip );
+
+            void Reset();
+
+            /**
+            * @brief Feed received bytes into the decoder
+            * @return false if the stream is corrupt (e.g. invalid length prefix or oversized packet)
+            */
+            bool Feed( const char* pData, size_t nSize );
+
+            /**
+            * @brief Pop the next completed packet
+            * @return false if no packet is available, the pointer is valid until the next call to Feed or PopPacket
+            */
+            bool PopPacket( const char*& pData, size_t& nSize );
+
+            /**
+            * @brief Append a framed packet to a send buffer
+            */
+            static void Encode( eOSCStreamFraming eFraming, const void* pData, size_t nSize, std::vector<char>& out );
+    };
+
+    /**
+    * @brief OSC 1.1 stream transport over TCP.
+    * Sockets are non-blocking, sends are appended to a per peer buffer and written in as few syscalls as possible on Flush.
+    * In server mode all accepted peers are read from and SendPacket goes to every peer.
+    * A client that can't connect or loses its server connects again with a growing delay, sends fail meanwhile.
+    */
+    class COSCTcpTransport : public IOSCTransport
+    {
+            struct SStreamPeer
+            {
+                int nHandle;
+                bool bConnecting; //!< non-blocking connect still in progress
+                COSCStreamDecoder decoder;
+                std::vector<char> sendBuffer;
+                size_t nSendOffset; //!< bytes of sendBuffer already written
+
+                SStreamPeer( int _nHandle, eOSCStreamFraming eFraming ) :
+                    nHandle( _nHandle ),
+                    bConnecting( false ),
+                    decoder( eFraming ),
+                    nSendOffset( 0 )
+                {
+                };
+            };
+
+            eOSCStreamFraming m_eFraming;
+            bool m_bServer;
+            int m_nListenHandle;
+            std::vector<SStreamPeer> m_Peers;
+            size_t m_nNextPeer; //!< peer to read from next
+            std::string m_sError;
+
+            const char* m_pPacket;
+            size_t m_nPacketSize;
+
+            // address of the server a client connects to, resolved once in Open
+            sockaddr_storage m_ServerAddr;
+            int m_nServerAddrLen;
+            uint64 m_nReconnectAt; //!< see GetOSCMonotonicClockNs, 0 if connected or no reconnect is due
+            uint64 m_nReconnectDelay; //!< ns, doubled after every failed attempt
+
+            void SetError( const std::string& sError );
+            void ClosePeer( size_t nPeer );
+
+            /**
+            * @brief Start a non-blocking connect to m_ServerAddr, schedules the next attempt if it fails right away
+            */
+            void Connect();
+            void ScheduleReconnect();
+            void UpdateReconnect();
+
+            void AcceptPeers();
+            bool ReadPeer( SStreamPeer& peer );
+            bool FlushPeer( SStreamPeer& peer );
+            bool QueuePacket( SStreamPeer& peer, const void* pData, size_t nSize );
+
+        public:
+            enum
+            {
+                MAX_SEND_BUFFER = 4 * 1024 * 1024, //!< packets are dropped if a peer can't keep up
+                READ_CHUNK = 64 * 1024,
+                RECONNECT_MIN_MS = 100,
+                RECONNECT_MAX_MS = 5000,
+            };
+
+            COSCTcpTransport( eOSCStreamFraming eFraming = OSCSF_Slip );
+            ~COSCTcpTransport();
+
+            // IOSCTransport
+            bool Open( const std::string& sHost, int nPort, bool bServer );
+            void Close();
+
+            bool IsOk() const
+            {
+                return m_sError.empty();
+            }
+
+            std::string GetErrorMessage() const
+            {
+                return m_sError;
+            }
+
+            bool ReceiveNextPacket();
+
+            const void* GetPacketData() const
+            {
+                return m_pPacket;
+            }
+
+            size_t GetPacketSize() const
+            {
+                return m_nPacketSize;
+            }
+
+            std::string GetPacketSender() const;
+
+            bool WaitForPacket( int nTimeoutMs );
+
+            bool SendPacket( const void* pData, size_t nSize );
+            bool Flush();
+
+            /**
+            * @brief Only to the peer the current packet came from
+            */
+            bool ReplyPacket( const void* pData, size_t nSize );
+
+            int GetPeerCount() const
+            {
+                return int( m_Peers.size() );
+            }
+
+            void Release()
+            {
+                delete this;
+            }
+    };
+}
@@ -0,0 +1,136 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#include <StdAfx.h>
+#include <OSCCore.h>
+#include <OSCTrace.h>
+
+#include <cstdio>
+
+#if defined(_MSC_VER)
+#   define OSC_THREAD_LOCAL __declspec( thread )
+#else
+#   define OSC_THREAD_LOCAL __thread
+#endif
+
+namespace OSCPlugin
+{
+#if OSC_ENABLE_TRACE
+    int g_nOSCTrace = 0;
+
+    namespace
+    {
+        struct SOSCTraceSpan
+        {
+            const char* sName;
+            uint64 nStart;
+            uint64 nEnd;
+        };
+
+        enum
+        {
+            TRACE_RING_SIZE = 8192, //!< newest spans kept per thread
+        };
+
+        /**
+        * @brief Only written by its thread, the dump may read a span that is being overwritten
+        */
+        struct SOSCTraceRing
+        {
+            threadID nThread;
+            volatile unsigned int nWritten;
+            SOSCTraceSpan spans[TRACE_RING_SIZE];
+        };
+
+        // rings are created on the first span of a thread and live as long as the plugin
+        std::vector<SOSCTraceRing*> g_TraceRings;
+        CryMutex g_TraceRingsLock;
+        OSC_THREAD_LOCAL SOSCTraceRing* t_pTraceRing = NULL;
+    }
+
+    void RecordOSCTraceSpan( const char* sName, uint64 nStart, uint64 nEnd )
+    {
+        SOSCTraceRing* pRing = t_pTraceRing;
+
+        if ( !pRing )
+        {
+            pRing = new SOSCTraceRing();
+            pRing->nThread = CryGetCurrentThreadId();
+            pRing->nWritten = 0;
+
+            CryAutoLock<CryMutex> lock( g_TraceRingsLock );
+            g_TraceRings.push_back( pRing );
+            t_pTraceRing = pRing;
+        }
+
+        SOSCTraceSpan& span = pRing->spans[pRing->nWritten % TRACE_RING_SIZE];
+        span.sName = sName;
+        span.nStart = nStart;
+        span.nEnd = nEnd;
+        ++pRing->nWritten;
+    }
+#endif
+
+    void OSCCmdTraceDump( IConsoleCmdArgs* pArgs )
+    {
+#if OSC_ENABLE_TRACE
+        const char* sFile = pArgs && pArgs->GetArgCount() > 1 ? pArgs->GetArg( 1 ) : "osc_trace.json";
+        FILE* pFile = fopen( sFile, "w" );
+
+        if ( !pFile )
+        {
+            OSCLog( OSCLL_Error, "Could not write trace to %s", sFile );
+            return;
+        }
+
+        CryAutoLock<CryMutex> lock( g_TraceRingsLock );
+
+        // timestamps relative to the oldest span, chrome://tracing wants microseconds
+        uint64 nOrigin = ~uint64( 0 );
+
+        for ( size_t i = 0; i < g_TraceRings.size(); ++i )
+        {
+            const SOSCTraceRing& ring = *g_TraceRings[i];
+            unsigned int nWritten = ring.nWritten;
+            unsigned int nFirst = nWritten > TRACE_RING_SIZE ? nWritten - TRACE_RING_SIZE : 0;
+
+            if ( nFirst < nWritten )
+            {
+                uint64 nStart = ring.spans[nFirst % TRACE_RING_SIZE].nStart;
+                nOrigin = nStart < nOrigin ? nStart : nOrigin;
+            }
+        }
+
+        int nSpans = 0;
+        fprintf( pFile, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" );
+
+        for ( size_t i = 0; i < g_TraceRings.size(); ++i )
+        {
+            const SOSCTraceRing& ring = *g_TraceRings[i];
+            unsigned int nWritten = ring.nWritten;
+            unsigned int nFirst = nWritten > TRACE_RING_SIZE ? nWritten - TRACE_RING_SIZE : 0;
+
+            for ( unsigned int n = nFirst; n < nWritten; ++n )
+            {
+                const SOSCTraceSpan& span = ring.spans[n % TRACE_RING_SIZE];
+
+                if ( span.nStart < nOrigin || span.nEnd < span.nStart )
+                {
+                    continue; // overwritten while dumping
+                }
+
+                fprintf( pFile, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+                         nSpans ? "," : "", span.sName, ( unsigned long )ring.nThread,
+                         ( span.nStart - nOrigin ) / 1000.0, ( span.nEnd - span.nStart ) / 1000.0 );
+                ++nSpans;
+            }
+        }
+
+        fprintf( pFile, "\n]}\n" );
+        fclose( pFile );
+
+        OSCLog( OSCLL_Always, "Wrote %d trace spans of %d threads to %s", nSpans, int( g_TraceRings.size() ), sFile );
+#else
+        OSCLog( OSCLL_Warning, "Tracing was disabled at compile time (OSC_ENABLE_TRACE)" );
+#endif
+    }
+}
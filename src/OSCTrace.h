@@ -0,0 +1,62 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <OSCTransport.h>
+
+/**
+* @brief Trace markers are compiled in unless OSC_ENABLE_TRACE is defined to 0,
+* recording itself is switched on at runtime with the CVar osc_trace.
+*/
+#ifndef OSC_ENABLE_TRACE
+#   define OSC_ENABLE_TRACE 1
+#endif
+
+namespace OSCPlugin
+{
+#if OSC_ENABLE_TRACE
+    extern int g_nOSCTrace; //!< CVar osc_trace
+
+    /**
+    * @brief Append a finished span to the ring buffer of the calling thread
+    * @param sName has to stay valid until the trace is dumped (string literals)
+    */
+    void RecordOSCTraceSpan( const char* sName, uint64 nStart, uint64 nEnd );
+
+    /**
+    * @brief Records the time between construction and destruction as a span
+    */
+    class COSCTraceScope
+    {
+            const char* m_sName;
+            uint64 m_nStart; //!< 0 if tracing was off when the scope started
+
+        public:
+            COSCTraceScope( const char* sName )
+            {
+                m_sName = sName;
+                m_nStart = g_nOSCTrace ? GetOSCWallClockNs() : 0;
+            }
+
+            ~COSCTraceScope()
+            {
+                if ( m_nStart )
+                {
+                    RecordOSCTraceSpan( m_sName, m_nStart, GetOSCWallClockNs() );
+                }
+            }
+    };
+
+#   define OSC_TRACE_CONCAT2( a, b ) a##b
+#   define OSC_TRACE_CONCAT( a, b ) OSC_TRACE_CONCAT2( a, b )
+#   define OSC_TRACE_SCOPE( sName ) OSCPlugin::COSCTraceScope OSC_TRACE_CONCAT( oscTraceScope, __LINE__ )( sName )
+#else
+#   define OSC_TRACE_SCOPE( sName )
+#endif
+
+    /**
+    * @brief Console command osc_trace_dump [file]: write the recorded spans of all threads as Chrome trace JSON
+    * (open in chrome://tracing or ui.perfetto.dev)
+    */
+    void OSCCmdTraceDump( IConsoleCmdArgs* pArgs );
+}
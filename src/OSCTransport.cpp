@@ -0,0 +1,216 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#include <StdAfx.h>
+#include <OSCTransport.h>
+#include <OSCTcpTransport.h>
+#include <OSCShmTransport.h>
+
+#if defined(_MSC_VER) || defined(WIN32)
+#   include <windows.h>
+#else
+#   include <time.h>
+#   include <sys/time.h>
+#   include <sys/socket.h>
+#   include <poll.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+namespace OSCPlugin
+{
+    namespace
+    {
+        bool s_bClockAnchored = false;
+#if defined(_MSC_VER) || defined(WIN32)
+        LARGE_INTEGER s_nFrequency;
+        LARGE_INTEGER s_nCounterBase;
+        uint64 s_nWallBase = 0;
+#elif defined(CLOCK_MONOTONIC)
+        uint64 s_nMonotonicOffset = 0;
+#endif
+
+        /**
+        * @brief Sample the clock bases, the main and the scheduler thread read them without a lock so they are
+        * only written while the module is loaded, before any thread can use them
+        */
+        bool AnchorOSCClocks()
+        {
+            if ( s_bClockAnchored )
+            {
+                return true;
+            }
+
+#if defined(_MSC_VER) || defined(WIN32)
+            // the system time only ticks every few ms, so advance it with the performance counter
+            FILETIME ft;
+            GetSystemTimeAsFileTime( &ft );
+            QueryPerformanceFrequency( &s_nFrequency );
+            QueryPerformanceCounter( &s_nCounterBase );
+            uint64 nFileTime = ( uint64( ft.dwHighDateTime ) << 32 ) | ft.dwLowDateTime;
+            s_nWallBase = ( nFileTime - 116444736000000000ull ) * 100; // 100ns since 1601 to ns since 1970
+#elif defined(CLOCK_MONOTONIC)
+            struct timespec wall;
+            struct timespec monotonic;
+            clock_gettime( CLOCK_REALTIME, &wall );
+            clock_gettime( CLOCK_MONOTONIC, &monotonic );
+            s_nMonotonicOffset = ( uint64( wall.tv_sec ) * 1000000000u + wall.tv_nsec ) - ( uint64( monotonic.tv_sec ) * 1000000000u + monotonic.tv_nsec );
+#endif
+            s_bClockAnchored = true;
+            return true;
+        }
+
+        // static initialization runs on the loading thread before the plugin can start its scheduler
+        const bool s_bClockAnchorInit = AnchorOSCClocks();
+    }
+
+    uint64 GetOSCWallClockNs()
+    {
+#if defined(_MSC_VER) || defined(WIN32)
+        AnchorOSCClocks(); // only does work if called from another static initializer first
+
+        LARGE_INTEGER nCounter;
+        QueryPerformanceCounter( &nCounter );
+        uint64 nTicks = uint64( nCounter.QuadPart - s_nCounterBase.QuadPart );
+        return s_nWallBase + nTicks / s_nFrequency.QuadPart * 1000000000u + nTicks % s_nFrequency.QuadPart * 1000000000u / s_nFrequency.QuadPart;
+#elif defined(CLOCK_REALTIME)
+        struct timespec ts;
+        clock_gettime( CLOCK_REALTIME, &ts );
+        return uint64( ts.tv_sec ) * 1000000000u + ts.tv_nsec;
+#else
+        struct timeval tv;
+        gettimeofday( &tv, 0 );
+        return uint64( tv.tv_sec ) * 1000000000u + tv.tv_usec * 1000u;
+#endif
+    }
+
+    uint64 GetOSCMonotonicClockNs()
+    {
+#if defined(_MSC_VER) || defined(WIN32)
+        // already advanced by the performance counter from a single wall clock sample
+        return GetOSCWallClockNs();
+#elif defined(CLOCK_MONOTONIC)
+        AnchorOSCClocks(); // only does work if called from another static initializer first
+
+        struct timespec ts;
+        clock_gettime( CLOCK_MONOTONIC, &ts );
+        return uint64( ts.tv_sec ) * 1000000000u + ts.tv_nsec + s_nMonotonicOffset;
+#else
+        return GetOSCWallClockNs();
+#endif
+    }
+
+    bool COSCUdpTransport::SendToPeers( const void* pData, size_t nSize )
+    {
+        m_Peers.Evict( GetOSCWallClockNs() );
+
+        if ( !m_sock.isOk() || !pData || nSize == 0 )
+        {
+            return false;
+        }
+
+        if ( !m_Peers.GetCount() )
+        {
+            return true; // nobody subscribed yet, nothing failed
+        }
+
+        bool bRet = true;
+#if defined(__linux__)
+        // one syscall per batch of peers instead of one per peer
+        const size_t nMaxBatch = 64;
+        struct mmsghdr msgs[nMaxBatch];
+        struct iovec iov;
+        iov.iov_base = ( void* )pData;
+        iov.iov_len = nSize;
+
+        for ( size_t nFirst = 0; nFirst < m_Peers.GetCount(); )
+        {
+            size_t nBatch = std::min( nMaxBatch, m_Peers.GetCount() - nFirst );
+            memset( msgs, 0, sizeof( msgs[0] ) * nBatch );
+
+            for ( size_t i = 0; i < nBatch; ++i )
+            {
+                oscpkt::SockAddr& addr = m_Peers.GetAddress( nFirst + i );
+                msgs[i].msg_hdr.msg_name = &addr.addr();
+                msgs[i].msg_hdr.msg_namelen = socklen_t( addr.actualLen() );
+                msgs[i].msg_hdr.msg_iov = &iov;
+                msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+
+            int nSent = sendmmsg( m_sock.handle, msgs, unsigned( nBatch ), 0 );
+
+            if ( nSent > 0 )
+            {
+                nFirst += nSent;
+            }
+
+            else if ( errno != EINTR )
+            {
+                // the first peer of the batch failed, the others still get it
+                bRet = false;
+                ++nFirst;
+            }
+        }
+
+#else
+
+        for ( size_t i = 0; i < m_Peers.GetCount(); ++i )
+        {
+            bRet &= m_sock.sendPacketTo( pData, nSize, m_Peers.GetAddress( i ) );
+        }
+
+#endif
+        return bRet;
+    }
+
+    bool WaitForOSCSockets( const int* pHandles, size_t nCount, bool bWrite, int nTimeoutMs )
+    {
+        if ( !nCount )
+        {
+            return false;
+        }
+
+#if defined(_MSC_VER) || defined(WIN32)
+        // a windows fd_set is a list of sockets and not a bit mask, FD_SET ignores sockets past FD_SETSIZE
+        fd_set set;
+        FD_ZERO( &set );
+
+        for ( size_t i = 0; i < nCount; ++i )
+        {
+            FD_SET( pHandles[i], &set );
+        }
+
+        struct timeval tv;
+        tv.tv_sec = nTimeoutMs / 1000;
+        tv.tv_usec = ( nTimeoutMs % 1000 ) * 1000;
+        return select( 0, bWrite ? 0 : &set, bWrite ? &set : 0, 0, nTimeoutMs < 0 ? 0 : &tv ) > 0;
+#else
+        std::vector<struct pollfd> fds( nCount );
+
+        for ( size_t i = 0; i < nCount; ++i )
+        {
+            fds[i].fd = pHandles[i];
+            fds[i].events = bWrite ? POLLOUT : POLLIN;
+            fds[i].revents = 0;
+        }
+
+        return poll( &fds[0], nfds_t( nCount ), nTimeoutMs < 0 ? -1 : nTimeoutMs ) > 0;
+#endif
+    }
+
+    IOSCTransport* CreateOSCTransport( eOSCTransportType eType, eOSCStreamFraming eFraming )
+    {
+        switch ( eType )
+        {
+            case OSCTT_Tcp:
+                return new COSCTcpTransport( eFraming );
+
+            case OSCTT_SharedMemory:
+                return new COSCShmTransport();
+
+            case OSCTT_Udp:
+            default:
+                return new COSCUdpTransport();
+        }
+    }
+}
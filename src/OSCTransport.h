@@ -0,0 +1,334 @@
+/* OSC_Plugin - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <OSCPeerTable.h>
+#include <oscpkt/udp.hh>
+
+#include <string>
+
+namespace OSCPlugin
+{
+    /**
+    * @brief Transports a connection can use to exchange raw OSC packets
+    */
+    enum eOSCTransportType
+    {
+        OSCTT_Udp = 0,
+        OSCTT_Tcp,
+        OSCTT_SharedMemory,
+    };
+
+    /**
+    * @brief Framing used to delimit OSC packets inside a byte stream (OSC 1.1)
+    */
+    enum eOSCStreamFraming
+    {
+        OSCSF_Slip = 0, //!< double ended SLIP framing as recommended by OSC 1.1
+        OSCSF_LengthPrefix, //!< int32 big endian size in front of each packet (OSC 1.0 stream mode)
+    };
+
+    /**
+    * @brief Moves raw OSC packets between the plugin and its peers.
+    * Packets passed in and out are complete OSC packets so the same PacketReader/PacketWriter code works for every transport.
+    */
+    class IOSCTransport
+    {
+        public:
+            /**
+            * @brief Open the transport
+            * @param sHost host to connect to (ignored when bServer is set)
+            * @param nPort port to listen on or connect to
+            * @param bServer listen for incoming data instead of connecting
+            */
+            virtual bool Open( const std::string& sHost, int nPort, bool bServer ) = 0;
+
+            /**
+            * @brief Close the transport and drop all pending data
+            */
+            virtual void Close() = 0;
+
+            virtual bool IsOk() const = 0;
+            virtual std::string GetErrorMessage() const = 0;
+
+            /**
+            * @brief Fetch the next received packet without blocking
+            * @return true if a packet is available via GetPacketData/GetPacketSize
+            */
+            virtual bool ReceiveNextPacket() = 0;
+            virtual const void* GetPacketData() const = 0;
+            virtual size_t GetPacketSize() const = 0;
+
+            /**
+            * @brief Arrival time of the current packet (see GetOSCWallClockNs)
+            * @return 0 if the transport doesn't know when the packet arrived
+            */
+            virtual uint64 GetPacketTimestamp() const
+            {
+                return 0;
+            }
+
+            /**
+            * @brief Who sent the current packet (ip:port for sockets), only needed for captures
+            * @return empty if the transport doesn't know
+            */
+            virtual std::string GetPacketSender() const
+            {
+                return std::string();
+            }
+
+            /**
+            * @brief Block until ReceiveNextPacket has something to return or the timeout expires.
+            * Only useful for threads that do nothing else, the connection itself polls once per update.
+            */
+            virtual bool WaitForPacket( int nTimeoutMs ) = 0;
+
+            /**
+            * @brief Queue or send a packet, buffered transports only transmit it on Flush
+            */
+            virtual bool SendPacket( const void* pData, size_t nSize ) = 0;
+
+            /**
+            * @brief Transmit everything queued by SendPacket
+            */
+            virtual bool Flush()
+            {
+                return true;
+            };
+
+            /**
+            * @brief Server mode that remembers every address it receives from and sends each packet to all of them,
+            * instead of to whoever sent last. Stream servers always send to all their peers.
+            * @param nIdleTimeoutNs peers that didn't send anything for this long are dropped, 0 never
+            * @return false if the transport has no addressable peers
+            */
+            virtual bool SetFanOut( bool bFanOut, uint64 /* nIdleTimeoutNs */ )
+            {
+                return !bFanOut;
+            }
+
+            /**
+            * @brief Send only to the sender of the current packet, e.g. the answer to a request while it is dispatched
+            */
+            virtual bool ReplyPacket( const void* pData, size_t nSize )
+            {
+                return SendPacket( pData, nSize );
+            }
+
+            /**
+            * @return peers SendPacket goes to, 0 if unknown
+            */
+            virtual int GetPeerCount() const
+            {
+                return 0;
+            }
+
+            virtual void Release() = 0;
+
+        protected:
+            /**
+            * @brief Transports delete themselves in Release
+            */
+            virtual ~IOSCTransport() {}
+    };
+
+    /**
+    * @brief Current wall clock time in nanoseconds since the unix epoch.
+    * Same clock as the kernel receive timestamps, used to compare them and OSC timetags against dispatch time.
+    */
+    uint64 GetOSCWallClockNs();
+
+    /**
+    * @brief Wall clock time that never jumps: a monotonic clock anchored to the wall clock when the module is loaded.
+    * Stamps taken with it stay evenly spaced when the system time is adjusted (NTP, user), for timetags sent to others.
+    */
+    uint64 GetOSCMonotonicClockNs();
+
+    /**
+    * @brief Convert an OSC/NTP timetag (seconds since 1900 + 32 bit fraction) to nanoseconds since the unix epoch
+    */
+    inline uint64 OSCTimeTagToUnixNs( uint64 nTimeTag )
+    {
+        const uint64 nNtpToUnix = 2208988800u;
+        uint64 nSeconds = nTimeTag >> 32;
+
+        if ( nSeconds < nNtpToUnix )
+        {
+            return 0;
+        }
+
+        return ( nSeconds - nNtpToUnix ) * 1000000000u + ( ( nTimeTag & 0xFFFFFFFFu ) * 1000000000u >> 32 );
+    }
+
+    /**
+    * @brief Convert nanoseconds since the unix epoch to an OSC/NTP timetag
+    */
+    inline uint64 OSCUnixNsToTimeTag( uint64 nUnixNs )
+    {
+        const uint64 nNtpToUnix = 2208988800u;
+        uint64 nSeconds = nUnixNs / 1000000000u + nNtpToUnix;
+        uint64 nFraction = ( ( nUnixNs % 1000000000u ) << 32 ) / 1000000000u;
+        return ( nSeconds << 32 ) | nFraction;
+    }
+
+    /**
+    * @brief Block until one of the sockets is readable (writable with bWrite) or the timeout expires.
+    * Unlike a plain select this works with any socket number, FD_SET writes past the set for numbers above FD_SETSIZE.
+    * @param nTimeoutMs negative to wait forever
+    */
+    bool WaitForOSCSockets( const int* pHandles, size_t nCount, bool bWrite, int nTimeoutMs );
+
+    /**
+    * @brief Datagram transport based on oscpkt::UdpSocket
+    */
+    class COSCUdpTransport : public IOSCTransport
+    {
+            oscpkt::UdpSocket m_sock;
+            uint64 m_nTimestamp;
+            bool m_bFanOut;
+            COSCPeerTable m_Peers;
+
+            /**
+            * @brief Send one packet to every peer, batched into few syscalls where the OS allows it
+            */
+            bool SendToPeers( const void* pData, size_t nSize );
+
+        public:
+            COSCUdpTransport() :
+                m_nTimestamp( 0 ),
+                m_bFanOut( false )
+            {
+            }
+
+            bool Open( const std::string& sHost, int nPort, bool bServer )
+            {
+                if ( bServer )
+                {
+                    if ( !m_sock.bindTo( nPort ) )
+                    {
+                        return false;
+                    }
+
+                    m_sock.enableTimestamps(); // optional, see ReceiveNextPacket
+                    return true;
+                }
+
+                return m_sock.connectTo( sHost, nPort );
+            }
+
+            void Close()
+            {
+                m_sock.close();
+                m_Peers.Clear();
+            }
+
+            bool IsOk() const
+            {
+                return m_sock.isOk();
+            }
+
+            std::string GetErrorMessage() const
+            {
+                return m_sock.errorMessage();
+            }
+
+            bool ReceiveNextPacket()
+            {
+                if ( !m_sock.receiveNextPacket( 0 ) )
+                {
+                    return false;
+                }
+
+                // without kernel timestamps the best we know is when we read it
+                m_nTimestamp = m_sock.packetTimestamp();
+
+                if ( !m_nTimestamp )
+                {
+                    m_nTimestamp = GetOSCWallClockNs();
+                }
+
+                if ( m_bFanOut )
+                {
+                    m_Peers.Touch( m_sock.packetOrigin(), m_nTimestamp );
+                }
+
+                return true;
+            }
+
+            const void* GetPacketData() const
+            {
+                return m_sock.buffer.empty() ? 0 : &m_sock.buffer[0];
+            }
+
+            size_t GetPacketSize() const
+            {
+                return m_sock.buffer.size();
+            }
+
+            uint64 GetPacketTimestamp() const
+            {
+                return m_nTimestamp;
+            }
+
+            std::string GetPacketSender() const
+            {
+                return m_sock.remote_addr.asString();
+            }
+
+            bool WaitForPacket( int nTimeoutMs )
+            {
+                int nHandle = m_sock.handle;
+                return nHandle != -1 && WaitForOSCSockets( &nHandle, 1, false, nTimeoutMs );
+            }
+
+            bool SendPacket( const void* pData, size_t nSize )
+            {
+                if ( m_bFanOut )
+                {
+                    return SendToPeers( pData, nSize );
+                }
+
+                return m_sock.sendPacket( pData, nSize );
+            }
+
+            bool SetFanOut( bool bFanOut, uint64 nIdleTimeoutNs )
+            {
+                // a connected client socket has exactly one peer
+                if ( bFanOut && !m_sock.isBound() )
+                {
+                    return false;
+                }
+
+                if ( !bFanOut )
+                {
+                    m_Peers.Clear();
+                }
+
+                m_bFanOut = bFanOut;
+                m_Peers.SetIdleTimeout( nIdleTimeoutNs );
+                return true;
+            }
+
+            bool ReplyPacket( const void* pData, size_t nSize )
+            {
+                return m_sock.sendPacketTo( pData, nSize, m_sock.packetOrigin() );
+            }
+
+            int GetPeerCount() const
+            {
+                return m_bFanOut ? int( m_Peers.GetCount() ) : 0;
+            }
+
+            void Release()
+            {
+                delete this;
+            }
+    };
+
+    /**
+    * @brief Create a transport instance
+    * @param eType transport to create
+    * @param eFraming stream framing (only used by stream transports)
+    */
+    IOSCTransport* CreateOSCTransport( eOSCTransportType eType, eOSCStreamFraming eFraming );
+}